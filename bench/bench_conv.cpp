@@ -51,3 +51,203 @@ BENCHMARK(BM_Convolutionk3x3s1x1)
 BENCHMARK(BM_Convolutionk3x3s1x1)
     ->Args({512, 256, 20, 20})
     ->Unit(benchmark::kMillisecond);
+
+static void BM_Convolutionk3x3s1x1Group(benchmark::State &state) {
+  uint32_t kernel_ct = state.range(0);
+  uint32_t channels = state.range(1);
+  uint32_t rows = state.range(2);
+  uint32_t cols = state.range(3);
+  uint32_t groups = state.range(4);
+
+  sftensor input = std::make_shared<ftensor>(channels, rows, cols);
+  input->Fill(1.f);
+  std::vector<sftensor> inputs;
+  inputs.push_back(input);
+
+  std::vector<sftensor> outputs(1);
+
+  Convolution convolution(kernel_ct, channels, 3, 3, 0, 0, 1, 1, groups,
+                          false);
+  std::vector<float> weights(kernel_ct * channels / groups * 3 * 3);
+  for (uint32_t i = 0; i < weights.size(); ++i) {
+    weights.at(i) = float(i % 7) * 0.1f;
+  }
+  convolution.set_weights(weights);
+
+  for (auto _ : state) {
+    convolution.Forward(inputs, outputs);
+  }
+}
+
+BENCHMARK(BM_Convolutionk3x3s1x1Group)
+    ->Args({128, 128, 40, 40, 4})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_Convolutionk3x3s1x1Group)
+    ->Args({256, 256, 20, 20, 8})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_Convolutionk3x3s1x1Winograd(benchmark::State &state) {
+  uint32_t kernel_ct = state.range(0);
+  uint32_t channels = state.range(1);
+  uint32_t rows = state.range(2);
+  uint32_t cols = state.range(3);
+  bool use_winograd = state.range(4);
+
+  sftensor input = std::make_shared<ftensor>(channels, rows, cols);
+  input->Fill(1.f);
+  std::vector<sftensor> inputs;
+  inputs.push_back(input);
+
+  std::vector<sftensor> outputs(1);
+
+  std::vector<sftensor> weights(kernel_ct);
+  for (uint32_t k = 0; k < kernel_ct; ++k) {
+    auto &weight = weights.at(k);
+    weight = std::make_shared<ftensor>(channels, 3, 3);
+    weight->Rand();
+  }
+
+  Convolution convolution(kernel_ct, channels, 3, 3, 0, 0, 1, 1, 1, false);
+  convolution.set_weights(weights);
+  convolution.set_use_winograd(use_winograd);
+
+  for (auto _ : state) {
+    convolution.Forward(inputs, outputs);
+  }
+}
+
+// 对比Winograd（最后一个参数为1）和im2col的耗时
+BENCHMARK(BM_Convolutionk3x3s1x1Winograd)
+    ->ArgsProduct({{32}, {3}, {320}, {320}, {0, 1}})
+    ->ArgsProduct({{64}, {32}, {160}, {160}, {0, 1}})
+    ->ArgsProduct({{128}, {64}, {80}, {80}, {0, 1}})
+    ->ArgsProduct({{256}, {128}, {40}, {40}, {0, 1}})
+    ->ArgsProduct({{512}, {256}, {20}, {20}, {0, 1}})
+    ->ArgsProduct({{64}, {8, 16}, {80}, {80}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_Convolutionk1x1(benchmark::State &state) {
+  uint32_t kernel_ct = state.range(0);
+  uint32_t channels = state.range(1);
+  uint32_t rows = state.range(2);
+  uint32_t cols = state.range(3);
+  uint32_t stride = state.range(4);
+
+  sftensor input = std::make_shared<ftensor>(channels, rows, cols);
+  input->Fill(1.f);
+  std::vector<sftensor> inputs;
+  inputs.push_back(input);
+
+  std::vector<sftensor> outputs(1);
+
+  std::vector<sftensor> weights(kernel_ct);
+  for (uint32_t k = 0; k < kernel_ct; ++k) {
+    auto &weight = weights.at(k);
+    weight = std::make_shared<ftensor>(channels, 1, 1);
+    weight->Rand();
+  }
+
+  Convolution convolution(kernel_ct, channels, 1, 1, 0, 0, stride, stride, 1,
+                          false);
+  convolution.set_weights(weights);
+
+  for (auto _ : state) {
+    convolution.Forward(inputs, outputs);
+  }
+}
+
+// MobileNetV3的逐点卷积和ResNet的下采样
+BENCHMARK(BM_Convolutionk1x1)
+    ->Args({64, 16, 112, 112, 1})
+    ->Args({24, 64, 56, 56, 1})
+    ->Args({120, 40, 28, 28, 1})
+    ->Args({480, 80, 14, 14, 1})
+    ->Args({960, 160, 7, 7, 1})
+    ->Args({128, 64, 56, 56, 2})
+    ->Args({256, 128, 28, 28, 2})
+    ->Args({512, 256, 14, 14, 2})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_ConvolutionDepthwise(benchmark::State &state) {
+  uint32_t channels = state.range(0);
+  uint32_t rows = state.range(1);
+  uint32_t cols = state.range(2);
+  uint32_t kernel = state.range(3);
+  uint32_t stride = state.range(4);
+
+  sftensor input = std::make_shared<ftensor>(channels, rows, cols);
+  input->Fill(1.f);
+  std::vector<sftensor> inputs;
+  inputs.push_back(input);
+
+  std::vector<sftensor> outputs(1);
+
+  std::vector<sftensor> weights(channels);
+  for (uint32_t k = 0; k < channels; ++k) {
+    auto &weight = weights.at(k);
+    weight = std::make_shared<ftensor>(1, kernel, kernel);
+    weight->Rand();
+  }
+
+  Convolution convolution(channels, channels, kernel, kernel, kernel / 2,
+                          kernel / 2, stride, stride, channels, false);
+  convolution.set_weights(weights);
+
+  for (auto _ : state) {
+    convolution.Forward(inputs, outputs);
+  }
+}
+
+// MobileNetV3-Large的深度卷积：通道数，行数，列数，kernel大小，步长
+BENCHMARK(BM_ConvolutionDepthwise)
+    ->Args({16, 112, 112, 3, 1})
+    ->Args({64, 112, 112, 3, 2})
+    ->Args({72, 56, 56, 3, 1})
+    ->Args({72, 56, 56, 5, 2})
+    ->Args({120, 28, 28, 5, 1})
+    ->Args({240, 28, 28, 3, 2})
+    ->Args({480, 14, 14, 3, 1})
+    ->Args({672, 14, 14, 5, 2})
+    ->Args({960, 7, 7, 5, 1})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_ConvolutionDilated(benchmark::State &state) {
+  uint32_t kernel_ct = state.range(0);
+  uint32_t channels = state.range(1);
+  uint32_t rows = state.range(2);
+  uint32_t cols = state.range(3);
+  uint32_t dilation = state.range(4);
+  uint32_t groups = state.range(5);
+
+  sftensor input = std::make_shared<ftensor>(channels, rows, cols);
+  input->Fill(1.f);
+  std::vector<sftensor> inputs;
+  inputs.push_back(input);
+
+  std::vector<sftensor> outputs(1);
+
+  std::vector<sftensor> weights(kernel_ct);
+  for (uint32_t k = 0; k < kernel_ct; ++k) {
+    auto &weight = weights.at(k);
+    weight = std::make_shared<ftensor>(channels / groups, 3, 3);
+    weight->Rand();
+  }
+
+  Convolution convolution(kernel_ct, channels, 3, 3, dilation, dilation, 1, 1,
+                          groups, false, ActivationType::ActivationNone, false,
+                          dilation, dilation);
+  convolution.set_weights(weights);
+
+  for (auto _ : state) {
+    convolution.Forward(inputs, outputs);
+  }
+}
+
+// DeepLab骨干网络中的膨胀卷积：kernel数目，通道数，行数，列数，膨胀，分组数
+BENCHMARK(BM_ConvolutionDilated)
+    ->Args({256, 256, 33, 33, 2, 1})
+    ->Args({512, 512, 33, 33, 4, 1})
+    ->Args({320, 320, 33, 33, 2, 320})
+    ->Args({960, 960, 33, 33, 4, 960})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,102 @@
+#include "data/load_data.hpp"
+#include "data/npy_file.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace TinyInfer;
+
+// 生成rows行、cols列的csv文件，元素形如激活值的输出"%.6f"
+static size_t WriteCSV(const std::string &file_path, uint32_t rows,
+                       uint32_t cols) {
+  std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+  char buffer[32];
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < rows; ++i) {
+    for (uint32_t j = 0; j < cols; ++j) {
+      seed = seed * 1664525u + 1013904223u;
+      std::snprintf(buffer, sizeof(buffer), "%.6f",
+                    float(seed >> 8) / float(1 << 20) - 8.f);
+      file << buffer << (j + 1 < cols ? "," : "\n");
+    }
+  }
+  return file.tellp();
+}
+
+// 逐行读取、以字符串流切分、std::stof转换的读取方式，作为对比
+static arma::fmat LoadCSVByStream(const std::string &file_path,
+                                  char split_char) {
+  std::ifstream in(file_path);
+  std::string line_str;
+  std::string token;
+  size_t rows = 0;
+  size_t cols = 0;
+  while (std::getline(in, line_str) && !line_str.empty()) {
+    std::stringstream line_stream(line_str);
+    size_t line_cols = 0;
+    while (std::getline(line_stream, token, split_char)) {
+      line_cols += 1;
+    }
+    cols = std::max(cols, line_cols);
+    rows += 1;
+  }
+
+  in.clear();
+  in.seekg(0);
+  arma::fmat data(rows, cols, arma::fill::zeros);
+  for (size_t row = 0; row < rows && std::getline(in, line_str); ++row) {
+    std::stringstream line_stream(line_str);
+    for (size_t col = 0; std::getline(line_stream, token, split_char);
+         ++col) {
+      try {
+        data.at(row, col) = std::stof(token);
+      } catch (std::exception &) {
+      }
+    }
+  }
+  return data;
+}
+
+// state.range(0)控制读取方式：0为字符串流，1为CSVDataLoader
+// state.range(1)、state.range(2)为矩阵的行数和列数
+static void BM_LoadCSV(benchmark::State &state) {
+  const bool fast_load = state.range(0) != 0;
+  const std::string file_path = "./bench_load.csv";
+  const size_t file_size = WriteCSV(file_path, state.range(1), state.range(2));
+  for (auto _ : state) {
+    arma::fmat data = fast_load ? CSVDataLoader::LoadData(file_path)
+                                : LoadCSVByStream(file_path, ',');
+    benchmark::DoNotOptimize(data.memptr());
+  }
+  state.counters["file_mb"] = double(file_size) / (1024 * 1024);
+  state.SetBytesProcessed(int64_t(state.iterations()) * file_size);
+  std::remove(file_path.c_str());
+}
+
+BENCHMARK(BM_LoadCSV)
+    ->Args({0, 1024, 1024})
+    ->Args({1, 1024, 1024})
+    ->Args({0, 64, 65536})
+    ->Args({1, 64, 65536})
+    ->Unit(benchmark::kMillisecond);
+
+// 读取.npy保存的一个批次的输入，state.range(0)、state.range(1)为批次大小和每个输入的元素数
+// 一维的输入直接使用映射的内存，不复制
+static void BM_LoadNpyBatch(benchmark::State &state) {
+  const std::string file_path = "./bench_load.npy";
+  std::vector<sftensor> batch;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    sftensor tensor = std::make_shared<ftensor>(1, 1, state.range(1));
+    tensor->Rand();
+    batch.push_back(tensor);
+  }
+  NpyFile::SaveBatch(file_path, batch);
+  for (auto _ : state) {
+    std::vector<sftensor> tensors = NpyFile::LoadBatch(file_path);
+    benchmark::DoNotOptimize(tensors.data());
+  }
+  std::remove(file_path.c_str());
+}
+
+BENCHMARK(BM_LoadNpyBatch)->Args({8, 3 * 224 * 224})->Unit(benchmark::kMillisecond);
@@ -8,6 +8,8 @@ static void BM_MobilenetV3_Batch8_224x224(benchmark::State &state) {
   RuntimeGraph graph("../../tmp/mobilenet/mobile_batch8.pnnx.param",
                      "../../tmp/mobilenet/mobile_batch8.bin");
 
+  // state.range(0)控制是否融合算子，便于对比
+  graph.set_fuse_ops(state.range(0) != 0);
   graph.Build("pnnx_input_0", "pnnx_output_0");
 
   const uint32_t batch = 8;
@@ -23,4 +25,4 @@ static void BM_MobilenetV3_Batch8_224x224(benchmark::State &state) {
   }
 }
 
-BENCHMARK(BM_MobilenetV3_Batch8_224x224)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MobilenetV3_Batch8_224x224)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,99 @@
+#include "runtime/param_parser.hpp"
+#include "runtime/store_zip.hpp"
+#include <benchmark/benchmark.h>
+#include <fstream>
+
+using namespace TinyInfer;
+
+// 生成由op_count个ReLU节点串联而成的结构文件和不含权重的权重文件
+static void WriteChainModel(const std::string &param_path,
+                            const std::string &bin_path, int op_count) {
+  std::ofstream param_file(param_path, std::ios::trunc);
+  param_file << "7767517\n" << op_count + 2 << " " << op_count + 1 << "\n";
+  param_file << "pnnx.Input input 0 1 0 #0=(1,64,56,56)f32\n";
+  for (int i = 0; i < op_count; ++i) {
+    param_file << "nn.ReLU relu_" << i << " 1 1 " << i << " " << i + 1
+               << " #" << i << "=(1,64,56,56)f32 #" << i + 1
+               << "=(1,64,56,56)f32\n";
+  }
+  param_file << "pnnx.Output output 1 0 " << op_count << " #" << op_count
+             << "=(1,64,56,56)f32\n";
+
+  pnnx::StoreZipWriter bin_writer;
+  bin_writer.open(bin_path);
+  bin_writer.close();
+}
+
+// state.range(0)控制解析方式：0为pnnx::Graph::load，1为ParamParser
+static void ParseModel(benchmark::State &state, const std::string &param_path,
+                       const std::string &bin_path) {
+  const bool fast_parse = state.range(0) != 0;
+  for (auto _ : state) {
+    if (fast_parse) {
+      std::vector<srunop> ops;
+      std::shared_ptr<MappedFile> weight_file;
+      ParamParser::Parse(param_path, bin_path, ops, weight_file);
+      benchmark::DoNotOptimize(ops.data());
+    } else {
+      pnnx::Graph graph;
+      graph.load(param_path, bin_path, true);
+      benchmark::DoNotOptimize(graph.ops.data());
+    }
+  }
+}
+
+static void BM_ParseResnet18(benchmark::State &state) {
+  ParseModel(state, "../../tmp/resnet/resnet18_batch8.pnnx.param",
+             "../../tmp/resnet/resnet18_batch8.pnnx.bin");
+}
+
+static void BM_ParseChain(benchmark::State &state) {
+  const std::string param_path = "./chain.pnnx.param";
+  const std::string bin_path = "./chain.pnnx.bin";
+  WriteChainModel(param_path, bin_path, state.range(1));
+  ParseModel(state, param_path, bin_path);
+  std::remove(param_path.c_str());
+  std::remove(bin_path.c_str());
+}
+
+// state.range(0)为权重的压缩级别，0为不压缩；state.range(1)为解压线程数
+// 计数器file_mb为权重文件大小，对比不压缩和压缩的文件的大小和读取时间
+static void BM_LoadCompressedResnet18(benchmark::State &state) {
+  const int compression_level = state.range(0);
+  const int num_threads = state.range(1);
+  const std::string param_path = "./resnet18_compressed.pnnx.param";
+  const std::string bin_path = "./resnet18_compressed.pnnx.bin";
+  {
+    pnnx::Graph graph;
+    if (graph.load("../../tmp/resnet/resnet18_batch8.pnnx.param",
+                   "../../tmp/resnet/resnet18_batch8.pnnx.bin") != 0 ||
+        graph.save(param_path, bin_path, compression_level) != 0) {
+      state.SkipWithError("Can not write the model");
+      return;
+    }
+  }
+  std::ifstream bin_file(bin_path, std::ios::binary | std::ios::ate);
+  state.counters["file_mb"] = double(bin_file.tellg()) / (1024 * 1024);
+
+  for (auto _ : state) {
+    pnnx::Graph graph;
+    graph.load(param_path, bin_path, true, num_threads);
+    benchmark::DoNotOptimize(graph.ops.data());
+  }
+  std::remove(param_path.c_str());
+  std::remove(bin_path.c_str());
+}
+
+BENCHMARK(BM_ParseResnet18)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadCompressedResnet18)
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({6, 1})
+    ->Args({6, 4})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParseChain)
+    ->Args({0, 1000})
+    ->Args({1, 1000})
+    ->Args({0, 5000})
+    ->Args({1, 5000})
+    ->Unit(benchmark::kMillisecond);
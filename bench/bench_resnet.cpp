@@ -1,5 +1,8 @@
 #include "data/tensor.hpp"
+#include "runtime/compiled_model.hpp"
 #include "runtime/runtime_graph.hpp"
+#include "runtime/shared_weight_segment.hpp"
+#include "runtime/weight_store.hpp"
 #include <benchmark/benchmark.h>
 
 using namespace TinyInfer;
@@ -10,6 +13,8 @@ static void BM_Resnet18_Batch8_224x224(benchmark::State &state) {
   RuntimeGraph graph("../../tmp/resnet/resnet18_batch8.pnnx.param",
                      "../../tmp/resnet/resnet18_batch8.pnnx.bin");
 
+  // state.range(0)控制是否融合算子，便于对比
+  graph.set_fuse_ops(state.range(0) != 0);
   graph.Build("pnnx_input_0", "pnnx_output_0");
 
   const uint32_t batch = 8;
@@ -29,6 +34,8 @@ static void BM_Resnet18_Batch16_224x224(benchmark::State &state) {
   RuntimeGraph graph("../../tmp/resnet/resnet18_batch16.pnnx.param",
                      "../../tmp/resnet/resnet18_batch16.pnnx.bin");
 
+  // state.range(0)控制是否融合算子，便于对比
+  graph.set_fuse_ops(state.range(0) != 0);
   graph.Build("pnnx_input_0", "pnnx_output_0");
 
   const uint32_t batch = 16;
@@ -44,5 +51,109 @@ static void BM_Resnet18_Batch16_224x224(benchmark::State &state) {
   }
 }
 
-BENCHMARK(BM_Resnet18_Batch8_224x224)->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_Resnet18_Batch16_224x224)->Unit(benchmark::kMillisecond);
\ No newline at end of file
+// 冷启动：从pnnx文件构建计算图与加载编译好的模型文件
+static void BM_Resnet18_ColdStart(benchmark::State &state) {
+  const std::string param_path = "../../tmp/resnet/resnet18_batch8.pnnx.param";
+  const std::string bin_path = "../../tmp/resnet/resnet18_batch8.pnnx.bin";
+  const std::string model_path = "./resnet18_batch8.tinyinfer";
+
+  // state.range(0)控制是否加载编译好的模型文件
+  const bool compiled = state.range(0) != 0;
+  if (compiled) {
+    RuntimeGraph graph(param_path, bin_path);
+    graph.Build("pnnx_input_0", "pnnx_output_0");
+    CompiledModel::Save(graph, model_path);
+  }
+
+  for (auto _ : state) {
+    if (compiled) {
+      benchmark::DoNotOptimize(CompiledModel::Load(model_path));
+    } else {
+      RuntimeGraph graph(param_path, bin_path);
+      graph.Build("pnnx_input_0", "pnnx_output_0");
+    }
+  }
+  if (compiled) {
+    std::remove(model_path.c_str());
+  }
+}
+
+// 构建时使用不同的线程数，state.range(0)为线程数，计数器为各阶段的平均耗时（毫秒）
+static void BM_Resnet18_BuildThreads(benchmark::State &state) {
+  const std::string param_path = "../../tmp/resnet/resnet18_batch8.pnnx.param";
+  const std::string bin_path = "../../tmp/resnet/resnet18_batch8.pnnx.bin";
+
+  StartupTimings total;
+  for (auto _ : state) {
+    RuntimeGraph graph(param_path, bin_path);
+    graph.set_build_threads(state.range(0));
+    graph.Build("pnnx_input_0", "pnnx_output_0");
+    const StartupTimings &timings = graph.startup_timings();
+    total.init_ms += timings.init_ms;
+    total.link_ms += timings.link_ms;
+    total.kernel_ms += timings.kernel_ms;
+    total.plan_ms += timings.plan_ms;
+  }
+  state.counters["init_ms"] = total.init_ms / state.iterations();
+  state.counters["link_ms"] = total.link_ms / state.iterations();
+  state.counters["kernel_ms"] = total.kernel_ms / state.iterations();
+  state.counters["plan_ms"] = total.plan_ms / state.iterations();
+}
+
+// 同一进程中构建批次大小为8、16的两个计算图，state.range(0)控制是否共享权重
+// 计数器为两个计算图共用的权重大小（MB），不共享时两个计算图各持有一份
+static void BM_Resnet18_SharedWeights(benchmark::State &state) {
+  const bool share_weights = state.range(0) != 0;
+  double shared_mb = 0.;
+  for (auto _ : state) {
+    RuntimeGraph graph8("../../tmp/resnet/resnet18_batch8.pnnx.param",
+                        "../../tmp/resnet/resnet18_batch8.pnnx.bin");
+    RuntimeGraph graph16("../../tmp/resnet/resnet18_batch16.pnnx.param",
+                         "../../tmp/resnet/resnet18_batch16.pnnx.bin");
+    graph8.set_share_weights(share_weights);
+    graph16.set_share_weights(share_weights);
+    graph8.Build("pnnx_input_0", "pnnx_output_0");
+    graph16.Build("pnnx_input_0", "pnnx_output_0");
+    shared_mb = WeightStore::Instance().blob_bytes() / 1048576.;
+  }
+  state.counters["shared_mb"] = shared_mb;
+}
+
+// 工作进程的热启动：state.range(0)控制是否映射已由其他进程创建的权重段
+static void BM_Resnet18_WeightSegment(benchmark::State &state) {
+  const std::string param_path = "../../tmp/resnet/resnet18_batch8.pnnx.param";
+  const std::string bin_path = "../../tmp/resnet/resnet18_batch8.pnnx.bin";
+  const std::string segment_name = "/tinyinfer_bench_resnet18";
+
+  const bool use_segment = state.range(0) != 0;
+  std::unique_ptr<RuntimeGraph> first_graph;
+  if (use_segment) {
+    SharedWeightSegment::Remove(segment_name);
+    first_graph = std::make_unique<RuntimeGraph>(param_path, bin_path);
+    first_graph->set_weight_segment(segment_name);
+    first_graph->Build("pnnx_input_0", "pnnx_output_0");
+  }
+
+  for (auto _ : state) {
+    RuntimeGraph graph(param_path, bin_path);
+    if (use_segment) {
+      graph.set_weight_segment(segment_name);
+    }
+    graph.Build("pnnx_input_0", "pnnx_output_0");
+  }
+  if (use_segment) {
+    SharedWeightSegment::Remove(segment_name);
+  }
+}
+
+BENCHMARK(BM_Resnet18_Batch8_224x224)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Resnet18_Batch16_224x224)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Resnet18_ColdStart)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Resnet18_BuildThreads)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Resnet18_SharedWeights)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Resnet18_WeightSegment)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -3,6 +3,8 @@
 
 #include <armadillo>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace TinyInfer {
 
@@ -10,6 +12,7 @@ class CSVDataLoader {
 public:
   /**
    * 读取csv文件中保存的矩阵
+   * 文件映射到内存中，各行并行解析并直接写入矩阵；缺失或无法解析的元素为0
    * @param file_path 文件路径
    * @param split_char 分隔符
    * @return 初始化的矩阵
@@ -19,13 +22,21 @@ public:
 
 private:
   /**
-   * 获取csv保存的矩阵维度
-   * @param file csv文件流
+   * 把文件内容划分为行，遇到空行或文件末尾时结束
+   * @param text 文件内容
+   * @return 各行的内容，不含换行符
+   */
+  static std::vector<std::string_view> SplitLines(std::string_view text);
+
+  /**
+   * 解析一行中的元素，写入矩阵的一行
+   * @param line 一行的内容
    * @param split_char 分割符
-   * @return 矩阵维度
+   * @param row 矩阵的行号
+   * @param data 矩阵，列数不少于该行的元素数
    */
-  static std::pair<size_t, size_t> GetMatrixSize(std::ifstream &file,
-                                                 char split_char);
+  static void ParseLine(std::string_view line, char split_char, size_t row,
+                        arma::fmat &data);
 };
 
 } // namespace TinyInfer
@@ -0,0 +1,72 @@
+#ifndef TINY_INFER_INCLUDE_DATA_NPY_FILE_HPP_
+#define TINY_INFER_INCLUDE_DATA_NPY_FILE_HPP_
+
+#include "data/tensor.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace TinyInfer {
+
+// NumPy的.npy、.npz文件的读写
+// 文件映射到内存中，float32、小端且内存布局与Tensor相同（每个通道的行数或列数为1，
+// 或者fortran_order的单通道矩阵）时Tensor直接使用映射的内存，不复制，Tensor持有映射直到被释放；
+// 其余情况（其他元素类型、行主序的矩阵）按Tensor的内存布局复制一份。
+// 支持1至4维的数组：3维及以下为一个Tensor（通道数、行数、列数），批次读写时第一维为批次
+class NpyFile {
+public:
+  /**
+   * 读取.npy文件中保存的一个Tensor
+   * @param file_path 文件路径
+   * @return 读取的Tensor，数组维度超过3维（第一维为1的4维数组除外）或读取失败时返回空
+   */
+  static sftensor Load(const std::string &file_path);
+
+  /**
+   * 读取.npy文件中保存的一个批次的Tensor，第一维为批次
+   * @param file_path 文件路径
+   * @return 读取的Tensor（一个批次），读取失败时为空
+   */
+  static std::vector<sftensor> LoadBatch(const std::string &file_path);
+
+  /**
+   * 读取.npz文件中保存的各批次Tensor，每个数组的第一维为批次
+   * 文件中的数组可以不压缩（np.savez）或压缩（np.savez_compressed）
+   * @param file_path 文件路径
+   * @return 各数组的名称（不含.npy后缀）及其Tensor，读取失败时为空
+   */
+  static std::map<std::string, std::vector<sftensor>>
+  LoadNpz(const std::string &file_path);
+
+  /**
+   * 把一个Tensor保存为.npy文件，数组的维度与Tensor的原始维度相同
+   * @param file_path 文件路径
+   * @param tensor 待保存的Tensor
+   * @return 是否保存成功
+   */
+  static bool Save(const std::string &file_path, const sftensor &tensor);
+
+  /**
+   * 把一个批次的Tensor保存为.npy文件，第一维为批次
+   * @param file_path 文件路径
+   * @param tensors 待保存的Tensor（一个批次），维度须相同
+   * @return 是否保存成功
+   */
+  static bool SaveBatch(const std::string &file_path,
+                        const std::vector<sftensor> &tensors);
+
+  /**
+   * 把多个批次的Tensor保存为.npz文件，每个数组的第一维为批次
+   * @param file_path 文件路径
+   * @param arrays 各数组的名称及其Tensor，每个批次中Tensor的维度须相同
+   * @param compression_level 压缩级别，1至9，为0时不压缩
+   * @return 是否保存成功
+   */
+  static bool SaveNpz(const std::string &file_path,
+                      const std::map<std::string, std::vector<sftensor>> &arrays,
+                      int compression_level = 0);
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_INCLUDE_DATA_NPY_FILE_HPP_
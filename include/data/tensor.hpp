@@ -31,6 +31,16 @@ public:
    */
   explicit Tensor(const std::vector<uint32_t> &shape);
 
+  /**
+   * 在外部内存上创建张量，张量不拥有也不释放该内存
+   * @param raw_ptr 外部内存的起始地址，至少能容纳channels * rows * cols个元素
+   * @param channels 通道数
+   * @param rows 行数
+   * @param cols 列数
+   */
+  explicit Tensor(float *raw_ptr, uint32_t channels, uint32_t rows,
+                  uint32_t cols);
+
   Tensor(const Tensor &tensor);
 
   Tensor(Tensor &&tensor) noexcept;
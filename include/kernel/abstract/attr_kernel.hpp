@@ -2,6 +2,7 @@
 #define TINY_INFER_SOURCE_KERNEL_ATTR_KERNEL_HPP_
 
 #include "kernel.hpp"
+#include "runtime/runtime_attr.hpp"
 
 namespace TinyInfer {
 
@@ -10,14 +11,14 @@ public:
   explicit AttrKernel(const std::string &name);
 
   /**
-   * 初始化权重
+   * 初始化权重，各权重Tensor在一块内存中连续存放
    * @param count 权重数目，比如Conv2d层的卷积核数目
    */
   void InitWeights(const uint32_t count, const uint32_t channel,
                    const uint32_t height, const uint32_t width);
 
   /**
-   * 初始化偏置
+   * 初始化偏置，各偏置Tensor在一块内存中连续存放
    * @param count 偏置数目，比如Conv2d层的卷积核数目
    */
   void InitBias(const uint32_t count, const uint32_t channel,
@@ -31,13 +32,48 @@ public:
 
   void set_bias(const std::vector<float> &bias) override;
 
+  /**
+   * 由计算节点的权重属性加载权重
+   * 属性标记为共享时，权重Tensor使用进程内权重仓库中内容相同的一份权重；
+   * 属性中是打包好的权重值时，权重Tensor直接使用其内存；是映射的权重值时，先原地转换为Tensor的内存布局再直接使用；
+   * 否则复制属性中的权重值，并清除属性中的权重值
+   * @param attr 权重属性
+   */
+  void LoadWeights(RuntimeAttr &attr);
+
+  /**
+   * 由计算节点的偏置属性加载偏置，规则同LoadWeights
+   * @param attr 偏置属性
+   */
+  void LoadBias(RuntimeAttr &attr);
+
   const std::vector<sftensor> &weights() const override;
 
   const std::vector<sftensor> &bias() const override;
 
+  size_t weight_bytes() const override;
+
 protected:
+  /**
+   * 权重被设置或加载后调用，子类可在此把权重整理为计算时使用的布局
+   * 注意：直接修改权重Tensor中的值不会调用
+   */
+  virtual void WeightsUpdated();
+
   std::vector<sftensor> weights_; // 权重
   std::vector<sftensor> bias_;    // 偏置
+
+private:
+  /**
+   * 从进程内的权重仓库中取出内容相同的权重，没有时转换为Tensor的内存布局后放入仓库
+   * @param tensors 已初始化的权重或偏置Tensor，替换为仓库中权重的视图
+   * @param attr 权重属性，须标记为共享
+   * @return 是否使用了共享的权重，属性未标记为共享或权重值与Tensor不符时返回false
+   */
+  bool ShareTensors(std::vector<sftensor> &tensors, RuntimeAttr &attr);
+
+  // 权重Tensor使用的共享权重，Kernel析构后不再被使用的权重由仓库释放
+  std::vector<std::shared_ptr<const std::vector<float>>> shared_weights_;
 };
 
 } // namespace TinyInfer
@@ -23,12 +23,6 @@ public:
 
   virtual ~Kernel() = default;
 
-  /**
-   * Kernel的执行函数
-   * @return 执行状态
-   */
-  virtual InferStatus Forward();
-
   /**
    * Kernel的执行函数
    * @param inputs Kernel的输入Tensor
@@ -36,7 +30,31 @@ public:
    * @return 执行状态
    */
   virtual InferStatus Forward(const std::vector<sftensor> &inputs,
-                              std::vector<sftensor> &outputs);
+                              std::vector<sftensor> &outputs) const;
+
+  /**
+   * 推断Kernel输出Tensor的维度。各Kernel按自身的计算规则重写，
+   * 例如逐元素计算的激活函数输出与输入维度相同；默认实现不支持推断
+   * @param input_shapes 各输入来源中单个Tensor的维度（通道数，行数，列数），按输入来源的顺序排列
+   * @param output_shape 推断出的单个输出Tensor的维度（通道数，行数，列数）
+   * @return 是否推断成功
+   */
+  virtual bool InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                          std::vector<uint32_t> &output_shape) const;
+
+  /**
+   * 估算Kernel处理单个样本的浮点运算次数，用于性能分析，默认每个输出元素一次运算
+   * @param input_shapes 各输入来源中单个Tensor的维度
+   * @param output_shape 单个输出Tensor的维度
+   * @return 浮点运算次数
+   */
+  virtual uint64_t Flops(const std::vector<std::vector<uint32_t>> &input_shapes,
+                         const std::vector<uint32_t> &output_shape) const;
+
+  /**
+   * 返回Kernel权重和偏置占用的内存（字节），用于性能分析
+   */
+  virtual size_t weight_bytes() const;
 
   /**
    * 设置Kernel的权重
@@ -0,0 +1,60 @@
+#ifndef TINY_INFER_RUNTIME_COMPILED_MODEL_HPP_
+#define TINY_INFER_RUNTIME_COMPILED_MODEL_HPP_
+
+#include "runtime/runtime_graph.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace TinyInfer {
+
+// 编译好的模型文件
+// 保存构建完毕的计算图：融合、剪枝后的节点及其参数，按Kernel内存布局打包好的权重，
+// 以及结构文件中声明的输入维度下的激活内存规划结果。
+// 加载时把文件映射到内存中，不再解析文本结构文件、读取zip权重文件、规划内存，
+// 权重Tensor直接使用映射的内存，多个进程加载同一文件时共享页缓存。
+//
+// 文件布局（小端序）：
+// | 文件头（Header） | 结构段：节点、参数、权重描述、激活布局 | 对齐填充 | 权重段：各权重按64字节对齐 |
+// 注意：文件与生成它的TinyInfer版本、机器字节序绑定，版本不同时需重新编译
+class CompiledModel {
+public:
+  // 文件标识
+  static constexpr char kMagic[8] = {'T', 'I', 'N', 'Y', 'I', 'N', 'F', 'C'};
+  // 文件格式版本，格式变化时递增
+  static constexpr uint32_t kVersion = 1;
+  // 权重的对齐字节数
+  static constexpr size_t kAlignment = 64;
+
+  /**
+   * 保存构建完毕的计算图
+   * @param graph 构建完毕的计算图
+   * @param path 编译好的模型文件路径
+   * @return 是否保存成功
+   */
+  static bool Save(const RuntimeGraph &graph, const std::string &path);
+
+  /**
+   * 加载编译好的模型文件，得到构建完毕的计算图
+   * 计算图的输入、输出节点与保存时相同，同时执行的节点数目上限可在加载后重新设置
+   * @param path 编译好的模型文件路径
+   * @return 构建完毕的计算图，失败时返回空
+   */
+  static std::unique_ptr<RuntimeGraph> Load(const std::string &path);
+
+private:
+  // 文件头
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t graph_offset;  // 结构段的偏移量
+    uint64_t graph_size;    // 结构段的大小
+    uint64_t weight_offset; // 权重段的偏移量
+    uint64_t weight_size;   // 权重段的大小
+  };
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_COMPILED_MODEL_HPP_
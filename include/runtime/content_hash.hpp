@@ -0,0 +1,20 @@
+#ifndef TINY_INFER_RUNTIME_CONTENT_HASH_HPP_
+#define TINY_INFER_RUNTIME_CONTENT_HASH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace TinyInfer {
+
+/**
+ * 计算内容的128位哈希值（MurmurHash3 x64），用于识别内容相同的权重、模型
+ * @param data 数据，不要求对齐
+ * @param size 数据的字节数
+ * @param h1 哈希值的低64位
+ * @param h2 哈希值的高64位
+ */
+void ContentHash(const char *data, size_t size, uint64_t &h1, uint64_t &h2);
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_CONTENT_HASH_HPP_
@@ -0,0 +1,101 @@
+#ifndef TINY_INFER_RUNTIME_EXECUTION_CONTEXT_HPP_
+#define TINY_INFER_RUNTIME_EXECUTION_CONTEXT_HPP_
+
+#include "data/tensor.hpp"
+#include "runtime/memory_planner.hpp"
+#include "runtime/profiler.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace TinyInfer {
+
+class RuntimeGraph;
+
+// 槽位（节点输出）中单个样本Tensor的布局，执行上下文依此创建一个批次的Tensor
+// 内存按单个样本规划，批次为batch时各偏移量整体放大batch倍，复用关系保持不变
+struct SlotLayout {
+  bool used = false;       // 槽位是否需要Tensor
+  uint32_t channels = 0;   // 每个Tensor的通道数
+  uint32_t rows = 0;       // 每个Tensor的行数
+  uint32_t cols = 0;       // 每个Tensor的列数
+  bool planned = false;    // 是否位于规划好的arena中
+  size_t offset = 0;       // 单个样本时在arena中的偏移量（字节）
+  size_t sample_bytes = 0; // 每个Tensor占用的内存（字节，已对齐）
+};
+
+// 某一输入维度下计算图中所有激活Tensor的布局及内存规划结果
+struct ActivationLayout {
+  std::vector<std::vector<uint32_t>> input_shapes; // 计算图各输入中单个Tensor的维度
+  std::vector<SlotLayout> slots;     // 各槽位的布局，下标与计算图节点一致
+  size_t naive_bytes = 0;     // 规划前单个样本中间激活Tensor的内存大小
+  size_t planned_bytes = 0;   // 规划后单个样本中间激活Tensor的内存大小
+  size_t live_peak_bytes = 0; // 单个样本同时存活的中间激活Tensor的内存峰值
+};
+
+// 计算图的执行上下文，保存一次推理中的全部可变状态：中间激活Tensor、输出Tensor和调度状态
+// 计算图（节点、Kernel和权重）构建完毕后只读，每个线程持有自己的执行上下文，
+// 即可共享同一份权重并发推理
+class ExecutionContext {
+public:
+  ExecutionContext(const ExecutionContext &) = delete;
+
+  ExecutionContext &operator=(const ExecutionContext &) = delete;
+
+  /**
+   * 返回创建该上下文的计算图
+   */
+  const RuntimeGraph *graph() const;
+
+  /**
+   * 返回该上下文中激活Tensor占用的内存大小（字节），包括计算图的输出Tensor
+   */
+  size_t activation_bytes() const;
+
+  /**
+   * 返回上一次推理的批次大小
+   */
+  uint32_t batch() const;
+
+  /**
+   * 返回上一次调试（debug）推理中逐节点的性能记录
+   */
+  const Profiler &profiler() const;
+
+private:
+  friend class RuntimeGraph;
+
+  /**
+   * 创建执行上下文，只能由RuntimeGraph::CreateContext调用
+   * @param graph 构建完毕的计算图
+   * @param plan_version 计算图执行计划的版本
+   */
+  ExecutionContext(const RuntimeGraph *graph, uint64_t plan_version);
+
+  const RuntimeGraph *graph_ = nullptr; // 创建该上下文的计算图
+  uint64_t plan_version_ = 0;           // 创建时计算图执行计划的版本
+
+  std::shared_ptr<const ActivationLayout> layout_; // 当前Tensor对应的激活布局
+  uint32_t batch_ = 0;          // 当前Tensor对应的批次大小
+  std::unique_ptr<MemoryArena> arena_; // 中间激活Tensor共享的内存
+  // 计算图各输出的Tensor，按输出节点排列，批次变小时保留多余的Tensor
+  std::vector<std::vector<sftensor>> output_tensors_;
+
+  std::vector<std::vector<sftensor>> slot_tensors_; // 各槽位（节点输出）的Tensor
+  std::vector<const std::vector<sftensor> *> slots_; // 各槽位当前指向的Tensor
+  std::vector<std::vector<sftensor>> in_bufs_; // 多输入步骤拼接后的输入Tensor
+  Profiler profiler_; // 调试时逐节点记录的性能信息
+
+  std::unique_ptr<std::atomic<uint32_t>[]>
+      pending_deps_; // 并发执行时，各步骤尚未执行完毕的前驱步骤数目
+  std::atomic<uint32_t> remaining_steps_{0}; // 并发执行时尚未执行完毕的步骤数目
+  std::mutex done_mutex_;
+  std::condition_variable done_cv_; // 所有步骤执行完毕时唤醒Forward
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_EXECUTION_CONTEXT_HPP_
@@ -17,10 +17,13 @@
 
 #include <initializer_list>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "runtime/mapped_file.hpp"
+
 #if BUILD_PNNX
 namespace torch {
 namespace jit {
@@ -160,6 +163,9 @@ public:
     std::vector<int> shape;
 
     std::vector<char> data;
+
+    // entry data inside the mapped bin file when loaded with map_weights, data is empty then
+    const char* mapped_data = 0;
 };
 
 bool operator==(const Attribute& lhs, const Attribute& rhs);
@@ -208,8 +214,13 @@ public:
     Graph();
     ~Graph();
 
-    int load(const std::string& parampath, const std::string& binpath);
-    int save(const std::string& parampath, const std::string& binpath);
+    // map_weights: refer to the attribute data in the mapped bin file instead of copying them,
+    // the mapping is kept alive by weight_file
+    // num_threads: threads decompressing the deflated entries of the bin file, 0 for hardware concurrency
+    int load(const std::string& parampath, const std::string& binpath, bool map_weights = false, int num_threads = 0);
+
+    // compression_level: deflate the attribute data with zlib level 1-9, 0 to store them uncompressed
+    int save(const std::string& parampath, const std::string& binpath, int compression_level = 0);
 
     int python(const std::string& pypath, const std::string& binpath);
 
@@ -233,6 +244,8 @@ public:
     std::vector<Operator*> ops;
     std::vector<Operand*> operands;
 
+    std::shared_ptr<TinyInfer::MappedFile> weight_file;
+
 private:
     Graph(const Graph& rhs);
     Graph& operator=(const Graph& rhs);
@@ -0,0 +1,66 @@
+#ifndef TINY_INFER_RUNTIME_MAPPED_FILE_HPP_
+#define TINY_INFER_RUNTIME_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace TinyInfer {
+
+// 只读映射到内存中的文件
+// 以写时复制（私有）方式映射：未修改的页面与系统页缓存共享，多个进程映射同一文件时只占一份物理内存；
+// 修改映射内存不会写回文件。不支持内存映射的平台上退化为把整个文件读入内存
+class MappedFile {
+public:
+  /**
+   * 映射文件
+   * @param path 文件路径
+   * @return 映射好的文件，失败时返回空
+   */
+  static std::shared_ptr<MappedFile> Open(const std::string &path);
+
+  /**
+   * 分配一块匿名内存，用法与映射的文件相同，例如保存从压缩文件中解压出的内容
+   * @param path 内容来源的文件路径
+   * @param size 内存大小（字节），内容初始化为0
+   * @return 分配的内存，失败时返回空
+   */
+  static std::shared_ptr<MappedFile> Allocate(const std::string &path,
+                                              size_t size);
+
+  MappedFile(const MappedFile &) = delete;
+
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile();
+
+  /**
+   * 返回映射内存的起始地址，按页对齐
+   */
+  uint8_t *data() const;
+
+  /**
+   * 返回文件大小（字节）
+   */
+  size_t size() const;
+
+  /**
+   * 返回文件路径
+   */
+  const std::string &path() const;
+
+private:
+  MappedFile() = default;
+
+  std::string path_;
+  uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;        // 是否通过mmap映射
+  std::vector<uint8_t> buffer_; // 不能映射时读入的文件内容或分配的内存
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_MAPPED_FILE_HPP_
@@ -0,0 +1,145 @@
+#ifndef TINY_INFER_RUNTIME_MEMORY_PLANNER_HPP_
+#define TINY_INFER_RUNTIME_MEMORY_PLANNER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace TinyInfer {
+
+// 激活内存规划器
+// 依据每块内存的生命周期（在执行计划中首次写入和最后一次读取的步骤），
+// 将生命周期互不重叠的内存块打包到同一块连续内存（arena）中
+class MemoryPlanner {
+public:
+  // arena中每块内存的对齐字节数
+  static constexpr size_t kAlignment = 64;
+
+  /**
+   * 添加一块待规划的内存
+   * @param size 内存大小（字节）
+   * @param first_step 内存首次被写入的执行步骤
+   * @param last_step 内存最后一次被读取的执行步骤
+   * @return 内存块编号
+   */
+  uint32_t AddBlock(size_t size, uint32_t first_step, uint32_t last_step);
+
+  /**
+   * 添加一块待规划的内存
+   * @param size 内存大小（字节）
+   * @param first_step 内存被写入的执行步骤
+   * @param use_steps 读取该内存的所有执行步骤
+   * @return 内存块编号
+   */
+  uint32_t AddBlock(size_t size, uint32_t first_step,
+                    const std::vector<uint32_t> &use_steps);
+
+  /**
+   * 设置执行步骤之间的依赖关系，后继步骤的编号必须大于前驱步骤
+   * 设置后不再假设各步骤依次执行：只有一块内存的所有使用步骤都先于另一块内存的写入步骤完成时，
+   * 两块内存才会复用同一段空间，以适应并发执行
+   * @param next_steps 每个执行步骤的后继步骤
+   */
+  void SetDependencies(const std::vector<std::vector<uint32_t>> &next_steps);
+
+  /**
+   * 执行规划，为每块内存分配arena中的偏移量
+   * @return arena的大小（字节）
+   */
+  size_t Plan();
+
+  /**
+   * 清空所有内存块及规划结果
+   */
+  void Clear();
+
+  /**
+   * 返回内存块在arena中的偏移量（字节），需在Plan之后调用
+   * @param block_id 内存块编号
+   */
+  size_t offset(uint32_t block_id) const;
+
+  /**
+   * 返回内存块的数量
+   */
+  uint32_t block_count() const;
+
+  /**
+   * 返回不做规划时所需的内存大小（字节），即所有内存块大小之和
+   */
+  size_t naive_bytes() const;
+
+  /**
+   * 返回任一时刻同时存活的内存之和的最大值（字节），即规划结果的下界
+   */
+  size_t live_peak_bytes() const;
+
+  /**
+   * 返回规划后arena的大小（字节）
+   */
+  size_t planned_bytes() const;
+
+  /**
+   * 将内存大小按kAlignment向上对齐
+   * @param size 内存大小（字节）
+   */
+  static size_t AlignSize(size_t size);
+
+private:
+  // 待规划的内存块
+  struct Block {
+    size_t size = 0;                 // 大小（字节，已对齐）
+    uint32_t first_step = 0;         // 首次写入的执行步骤
+    uint32_t last_step = 0;          // 最后一次读取的执行步骤
+    std::vector<uint32_t> use_steps; // 写入和读取该内存的所有执行步骤
+    size_t offset = 0;               // arena中的偏移量
+  };
+
+  /**
+   * 判断两块内存是否可能同时存活
+   */
+  bool Conflict(const Block &block1, const Block &block2) const;
+
+  /**
+   * 判断block1的所有使用步骤是否都先于block2的写入步骤完成
+   */
+  bool Before(const Block &block1, const Block &block2) const;
+
+  std::vector<Block> blocks_;
+  std::vector<std::vector<bool>> reachable_; // reachable_[i][j]：步骤j依赖于步骤i
+  size_t planned_bytes_ = 0;
+  bool planned_ = false;
+};
+
+// 按kAlignment对齐的一块连续内存
+class MemoryArena {
+public:
+  /**
+   * 开辟内存并清零
+   * @param size 内存大小（字节）
+   */
+  explicit MemoryArena(size_t size);
+
+  /**
+   * 返回arena的起始地址
+   */
+  uint8_t *data() const;
+
+  /**
+   * 返回arena的大小（字节）
+   */
+  size_t size() const;
+
+private:
+  struct AlignedDeleter {
+    void operator()(uint8_t *ptr) const;
+  };
+
+  std::unique_ptr<uint8_t, AlignedDeleter> data_;
+  size_t size_ = 0;
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_MEMORY_PLANNER_HPP_
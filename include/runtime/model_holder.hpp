@@ -0,0 +1,133 @@
+#ifndef TINY_INFER_RUNTIME_MODEL_HOLDER_HPP_
+#define TINY_INFER_RUNTIME_MODEL_HOLDER_HPP_
+
+#include "runtime/execution_context.hpp"
+#include "runtime/runtime_graph.hpp"
+#include "runtime/thread_pool.hpp"
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace TinyInfer {
+
+// 持有当前版本的模型，支持不停服切换模型版本（热更新）
+// 新版本在后台线程中构建、预热（开辟激活内存）完毕后原子地替换当前版本：
+// 切换前已开始的推理继续使用旧版本，旧版本在最后一个使用者结束后释放；切换后开始的推理使用新版本。
+// 可被多个线程同时调用
+class ModelHolder {
+public:
+  // 返回构建完毕的计算图，失败时返回空
+  using GraphFactory = std::function<std::unique_ptr<RuntimeGraph>()>;
+  // 计算图各输入节点名称及其输入Tensor（一个批次）
+  using NamedTensors = std::map<std::string, std::vector<sftensor>>;
+
+  // 模型的一个版本：计算图及其空闲的执行上下文
+  class Version;
+
+  // 对某一版本的占用，持有期间该版本不会被释放
+  // 占用期间独占一个执行上下文，推理的输出Tensor由上下文持有，释放占用后上下文归还给该版本
+  class Lease {
+  public:
+    Lease(Lease &&) = default;
+
+    Lease &operator=(Lease &&) = default;
+
+    ~Lease();
+
+    /**
+     * 返回占用的计算图
+     */
+    const RuntimeGraph &graph() const;
+
+    /**
+     * 返回占用的执行上下文，用于RuntimeGraph::Forward
+     */
+    ExecutionContext &context();
+
+    /**
+     * 返回占用的模型版本号
+     */
+    uint64_t version() const;
+
+  private:
+    friend class ModelHolder;
+
+    Lease(std::shared_ptr<Version> version,
+          std::unique_ptr<ExecutionContext> context);
+
+    std::shared_ptr<Version> version_;
+    std::unique_ptr<ExecutionContext> context_;
+  };
+
+  /**
+   * 创建模型持有者
+   * @param graph 构建完毕的初始版本计算图
+   */
+  explicit ModelHolder(std::unique_ptr<RuntimeGraph> graph);
+
+  ModelHolder(const ModelHolder &) = delete;
+
+  ModelHolder &operator=(const ModelHolder &) = delete;
+
+  /**
+   * 等待尚未完成的版本切换后析构
+   */
+  ~ModelHolder();
+
+  /**
+   * 占用当前版本，之后的版本切换不影响该占用
+   * @return 对当前版本的占用
+   */
+  Lease Acquire() const;
+
+  /**
+   * 使用当前版本推理，输出Tensor复制一份返回，不受之后推理的影响
+   * @param inputs 计算图的输入Tensor（一个批次），仅适用于只有一个输入、输出节点的计算图
+   * @return 计算图的输出Tensor（一个批次）
+   */
+  std::vector<sftensor> Forward(const std::vector<sftensor> &inputs) const;
+
+  /**
+   * 使用当前版本推理有多个输入、输出节点的计算图，输出Tensor复制一份返回
+   * @param inputs 各输入节点名称及其输入Tensor（一个批次）
+   * @return 各输出节点名称及其输出Tensor（一个批次）
+   */
+  NamedTensors Forward(const NamedTensors &inputs) const;
+
+  /**
+   * 在后台线程中构建新版本，预热后替换当前版本
+   * 多次调用时按调用顺序依次切换；构建或预热失败时保留当前版本
+   * @param factory 构建新版本的计算图，在后台线程中调用
+   * @param warmup_inputs 预热时推理使用的输入，为空时不预热；
+   * 预热时开辟的激活内存留给之后的推理使用，切换后的第一次推理不再开辟内存
+   * @return 切换是否成功
+   */
+  std::future<bool> Reload(GraphFactory factory,
+                           NamedTensors warmup_inputs = {});
+
+  /**
+   * 返回当前版本号，初始版本为1，每次切换成功后递增
+   */
+  uint64_t version() const;
+
+private:
+  /**
+   * 构建、预热新版本并替换当前版本，在后台线程中执行
+   * @return 是否切换成功
+   */
+  bool DoReload(const GraphFactory &factory, const NamedTensors &warmup_inputs);
+
+  std::shared_ptr<Version> current_; // 当前版本，原子地读取、替换
+  uint64_t next_version_ = 2; // 下一个版本的版本号，只在后台线程中访问
+  // 依次执行版本切换的后台线程；成员按声明的逆序析构，它最先析构，
+  // 由~ModelHolder中显式调用的Wait()保证后台任务在其他成员析构之前结束
+  ThreadPool reload_pool_{1};
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_MODEL_HOLDER_HPP_
@@ -0,0 +1,70 @@
+#ifndef TINY_INFER_RUNTIME_OP_FUSION_HPP_
+#define TINY_INFER_RUNTIME_OP_FUSION_HPP_
+
+#include "runtime/runtime_op.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace TinyInfer {
+
+// 算子融合模式：一条从首节点出发、除末节点外每个节点只有一个后继的节点链
+// 匹配后链上的节点合并为首节点，首节点的Kernel负责完成整条链的计算
+struct FusionPattern {
+  std::vector<std::string> op_types; // 链上各节点的类型，第一个为首节点
+  std::string expr; // 链上pnnx.Expression节点须满足的表达式，其另一个输入作为残差融合进首节点
+};
+
+// 计算图的算子融合
+// 把卷积后紧跟的残差相加、激活节点融合进卷积，中间结果不再写回内存
+class OpFusion {
+public:
+  /**
+   * 返回支持的融合模式，按优先级排列
+   */
+  static const std::vector<FusionPattern> &Patterns();
+
+  /**
+   * 在计算图节点上匹配融合模式并改写计算图，被融合的节点从ops中移除
+   * 注意：需在节点相连、初始化输入输出空间之后，创建Kernel之前调用
+   * @param ops 计算图节点
+   * @param kept_names 输出须保留的节点名称，这些节点只能作为节点链的末节点被融合
+   * @return 融合的节点链数目
+   */
+  static uint32_t Fuse(std::vector<srunop> &ops,
+                       const std::unordered_set<std::string> &kept_names = {});
+
+  /**
+   * 查找融合了某节点的首节点
+   * @param ops 融合后的计算图节点
+   * @param name 被融合的节点名称
+   * @return 首节点，该节点未被融合时返回空
+   */
+  static srunop FindFusedHead(const std::vector<srunop> &ops,
+                              const std::string &name);
+
+private:
+  /**
+   * 从首节点出发匹配融合模式
+   * @param head 首节点
+   * @param pattern 融合模式
+   * @param chain 匹配成功时的节点链
+   * @return 是否匹配成功
+   */
+  static bool Match(const srunop &head, const FusionPattern &pattern,
+                    std::vector<srunop> &chain);
+
+  /**
+   * 将节点链合并为首节点
+   * @param chain 匹配成功的节点链
+   * @param op_map 节点名称到节点的映射
+   */
+  static void Rewrite(const std::vector<srunop> &chain,
+                      const std::unordered_map<std::string, srunop> &op_map);
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_OP_FUSION_HPP_
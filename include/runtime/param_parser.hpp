@@ -0,0 +1,39 @@
+#ifndef TINY_INFER_RUNTIME_PARAM_PARSER_HPP_
+#define TINY_INFER_RUNTIME_PARAM_PARSER_HPP_
+
+#include "runtime/mapped_file.hpp"
+#include "runtime/runtime_op.hpp"
+#include "runtime/thread_pool.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace TinyInfer {
+
+// pnnx结构文件（.pnnx.param）的解析器
+// 把结构文件映射到内存中单遍解析，直接构造计算图节点，不经过pnnx::Graph：
+// 按名称查找操作数时使用哈希表，参数、维度直接从映射内存中解析，不构造中间字符串流。
+// 解析规则与pnnx::Graph::load相同，权重属性直接指向映射的权重文件中的内存。
+// 第一遍依次读取各节点引用的操作数，之后各节点的参数、权重属性互不依赖，可在线程池中并行解析
+class ParamParser {
+public:
+  /**
+   * 解析结构文件，并映射权重文件
+   * 节点的输入、输出操作数，后继节点名称，参数和权重属性均已初始化，输出操作数尚未开辟输出空间
+   * @param param_path 结构文件路径
+   * @param bin_path 权重文件路径
+   * @param ops 解析得到的计算图节点，按结构文件中的顺序排列
+   * @param weight_file 映射的权重文件，权重属性指向其中的内存；权重文件中有压缩的权重时为解压后的内存；
+   * 权重文件中没有权重时为空
+   * @param pool 并行解析各节点、解压权重的线程池，为空时在当前线程中解析
+   * @return 是否解析成功
+   */
+  static bool Parse(const std::string &param_path, const std::string &bin_path,
+                    std::vector<srunop> &ops,
+                    std::shared_ptr<MappedFile> &weight_file,
+                    ThreadPool *pool = nullptr);
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_PARAM_PARSER_HPP_
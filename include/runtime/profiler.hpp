@@ -0,0 +1,96 @@
+#ifndef TINY_INFER_RUNTIME_PROFILER_HPP_
+#define TINY_INFER_RUNTIME_PROFILER_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace TinyInfer {
+
+// 一个计算节点在一次推理中的性能记录
+struct ProfileRecord {
+  std::string name; // 节点名称
+  std::string type; // 节点类型
+  std::vector<std::string> fused_ops; // 融合进该节点的其他节点名称
+
+  double start_us = 0.; // 开始时间，相对推理开始的微秒数
+  double end_us = 0.;   // 结束时间，相对推理开始的微秒数
+  uint32_t thread_id = 0; // 执行线程的编号，按首次出现的顺序从0开始编号
+
+  uint32_t batch = 0; // 批次大小
+  std::vector<std::vector<uint32_t>> input_shapes; // 各输入来源中单个Tensor的维度
+  std::vector<uint32_t> output_shape; // 单个输出Tensor的维度
+  uint64_t flops = 0; // 估算的浮点运算次数（整个批次）
+  uint64_t bytes = 0; // 估算的内存读写量（字节，整个批次，包括权重）
+
+  /**
+   * 返回执行时间（微秒）
+   */
+  double duration_us() const { return end_us - start_us; }
+};
+
+// 逐节点的性能分析器
+// 记录一次推理中每个计算节点的起止时间、执行线程、输入输出维度、估算的运算量和访存量，
+// 可导出为chrome://tracing或Perfetto可以打开的JSON文件，也可输出按耗时排序的表格
+class Profiler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * 开始记录一次推理，清空上一次的记录
+   * @param step_num 执行步骤的数目
+   */
+  void Begin(uint32_t step_num);
+
+  /**
+   * 记录一个执行步骤，不同步骤可以在不同线程中同时记录
+   * @param step_idx 执行步骤
+   * @param record 性能记录，时间和线程编号由End填写
+   * @param start 开始时刻
+   * @param end 结束时刻
+   */
+  void Record(uint32_t step_idx, ProfileRecord record, Clock::time_point start,
+              Clock::time_point end);
+
+  /**
+   * 结束记录，换算相对时间并为执行线程编号
+   */
+  void End();
+
+  /**
+   * 返回各执行步骤的性能记录，按执行计划的顺序排列
+   */
+  const std::vector<ProfileRecord> &records() const;
+
+  /**
+   * 返回整次推理的耗时（微秒）
+   */
+  double total_us() const;
+
+  /**
+   * 导出Chrome trace格式的JSON文件
+   * @param path 文件路径
+   * @return 是否导出成功
+   */
+  bool ExportChromeTrace(const std::string &path) const;
+
+  /**
+   * 返回按耗时降序排列的前top_n个节点的表格
+   * @param top_n 节点数目
+   */
+  std::string TopTable(uint32_t top_n) const;
+
+private:
+  Clock::time_point begin_;            // 推理开始时刻
+  Clock::time_point end_;              // 推理结束时刻
+  std::vector<ProfileRecord> records_; // 各执行步骤的性能记录
+  std::vector<Clock::time_point> starts_;   // 各执行步骤的开始时刻
+  std::vector<Clock::time_point> ends_;     // 各执行步骤的结束时刻
+  std::vector<std::thread::id> threads_;    // 各执行步骤的执行线程
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_PROFILER_HPP_
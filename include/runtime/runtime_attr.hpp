@@ -3,6 +3,7 @@
 
 #include "runtime_datatype.hpp"
 #include "status_code.hpp"
+#include <cstring>
 #include <glog/logging.h>
 #include <memory>
 #include <vector>
@@ -16,6 +17,18 @@ struct RuntimeAttr {
   std::vector<int> shape;        // 权重维度
   RuntimeDataType type = RuntimeDataType::TypeUnknown; // 权重值类型
 
+  // 位于映射的权重文件中的权重值（与weight_data布局相同，未必按float对齐），此时weight_data为空
+  const char *mapped_data = nullptr;
+  size_t mapped_size = 0; // 映射的权重值字节数
+
+  // 已按Kernel中权重Tensor的内存布局打包好的权重值，位于映射的模型文件中，此时weight_data为空
+  // Kernel直接使用这段内存，不再复制
+  float *packed_data = nullptr;
+  size_t packed_size = 0; // 打包的权重值数目
+
+  // 加载时是否放入进程内共享的权重仓库（见WeightStore），与其他计算图共享内容相同的权重
+  bool share = false;
+
   /**
    * 获取权重值
    * @tparam T 权重值类型
@@ -32,9 +45,13 @@ struct RuntimeAttr {
 using srunattr = std::shared_ptr<RuntimeAttr>;
 
 template <class T> std::vector<T> RuntimeAttr::get(bool need_clear) {
-  CHECK(!weight_data.empty());
+  CHECK(!weight_data.empty() || mapped_data != nullptr);
   CHECK(type != RuntimeDataType::TypeUnknown);
 
+  const bool mapped = weight_data.empty();
+  const char *raw_data = mapped ? mapped_data : weight_data.data();
+  const size_t byte_size = mapped ? mapped_size : weight_data.size();
+
   std::vector<T> weights;
   switch (type) {
   // 目前只支持float32
@@ -44,13 +61,11 @@ template <class T> std::vector<T> RuntimeAttr::get(bool need_clear) {
     CHECK_EQ(is_float, true);
     // 获取当前机器上float类型占用的字节数
     const uint32_t float_size = sizeof(float);
-    // 判断weight_data中的字节数是float_size的整数倍
-    CHECK_EQ(weight_data.size() % float_size, 0);
-    // 按float_size大小读取（解释）权重值
-    for (uint32_t i = 0; i < weight_data.size() / float_size; ++i) {
-      float weight = *((float *)weight_data.data() + i);
-      weights.push_back(weight);
-    }
+    // 判断权重值的字节数是float_size的整数倍
+    CHECK_EQ(byte_size % float_size, 0);
+    // 整块复制权重值，映射的权重值未必按float对齐，不能直接按float读取
+    weights.resize(byte_size / float_size);
+    std::memcpy(weights.data(), raw_data, byte_size);
     break;
   }
   default: {
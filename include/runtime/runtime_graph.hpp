@@ -3,20 +3,36 @@
 
 #include "ir.h"
 #include "kernel/abstract/kernel.hpp"
+#include "runtime/execution_context.hpp"
+#include "runtime/mapped_file.hpp"
+#include "runtime/memory_planner.hpp"
 #include "runtime/runtime_oprand.hpp"
+#include "runtime/shared_weight_segment.hpp"
+#include "runtime/thread_pool.hpp"
 #include "runtime_op.hpp"
 #include <glog/logging.h>
 #include <map>
 #include <memory>
-#include <queue>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace TinyInfer {
 
+// 计算图启动各阶段的耗时，单位为毫秒
+struct StartupTimings {
+  double init_ms = 0.;   // 解析结构文件、映射权重文件
+  double link_ms = 0.;   // 连接节点、初始化输入输出空间、融合算子
+  double kernel_ms = 0.; // 构造Kernel，包括权重的转换
+  double plan_ms = 0.;   // 生成执行计划、规划激活内存
+  uint32_t threads = 1;  // 启动时使用的线程数
+};
+
 // 计算图，由计算节点和节点间的操作数流构成
 class RuntimeGraph {
+  friend class CompiledModel;
+
 public:
   /**
    * 初始化计算图
@@ -32,6 +48,16 @@ public:
    */
   void Build(const std::string &input_name, const std::string &output_name);
 
+  /**
+   * 构建有多个输入、输出节点的计算图
+   * 一次推理即可算出所有输出，各输出共享的节点只执行一次；输出不依赖的节点不构造Kernel，也不执行
+   * @param input_names 输入节点名称，不能重复
+   * @param output_names 输出节点名称，不能重复；也可以是中间节点的名称，此时输出该节点的输出，
+   * 例如只取分类器之前的特征，跳过分类头的计算
+   */
+  void Build(const std::vector<std::string> &input_names,
+             const std::vector<std::string> &output_names);
+
   /**
    * 设置结构文件路径
    */
@@ -54,51 +80,210 @@ public:
 
   /**
    * 执行计算图推理
+   * 使用计算图内部的默认执行上下文，不能被多个线程同时调用
+   * 注意：仅适用于只有一个输入、输出节点的计算图
    * @param inputs 计算图的输入Tensor（一个批次）
-   * @param debug 是否调试，若调试，则会输出中间信息
-   * @return 计算图的输出Tensor（一个批次）
+   * @param debug 是否调试，若调试，则逐节点记录性能信息并输出耗时统计
+   * @return 计算图的输出Tensor（一个批次），下一次Forward时会被覆盖
    */
   std::vector<sftensor> Forward(const std::vector<sftensor> &inputs,
                                 bool debug = false);
 
-private:
   /**
-   * 初始化计算图
-   * @return 是否初始化成功
+   * 执行有多个输入、输出节点的计算图推理
+   * 使用计算图内部的默认执行上下文，不能被多个线程同时调用
+   * @param inputs 各输入节点名称及其输入Tensor（一个批次），各输入的批次大小须相同
+   * @param debug 是否调试，若调试，则逐节点记录性能信息并输出耗时统计
+   * @return 各输出节点名称及其输出Tensor（一个批次），下一次Forward时会被覆盖
    */
-  bool Init();
+  std::map<std::string, std::vector<sftensor>>
+  Forward(const std::map<std::string, std::vector<sftensor>> &inputs,
+          bool debug = false);
 
   /**
-   * 初始化计算图节点的输入操作数
-   * @param inputs pnnx计算图节点的输入操作数
-   * @param op 计算图节点
+   * 创建执行上下文，需在Build之后调用
+   * 计算图构建完毕后只读，多个线程各自使用自己的执行上下文调用Forward即可并发推理
+   * @return 执行上下文
    */
-  static void InitOpInputs(const std::vector<pnnx::Operand *> &inputs,
-                           const srunop &op);
+  std::unique_ptr<ExecutionContext> CreateContext() const;
 
   /**
-   * 初始化计算图节点的输出操作数
-   * @param outputs pnnx计算图节点的输出操作数
-   * @param op 计算图节点
+   * 在给定的执行上下文中执行计算图推理，可被多个线程同时调用（每个线程使用不同的上下文）
+   * @param context 由CreateContext创建的执行上下文
+   * @param inputs 计算图的输入Tensor（一个批次）
+   * @param debug 是否调试，若调试，则逐节点记录性能信息（见ExecutionContext::profiler）并输出耗时统计
+   * @return 计算图的输出Tensor（一个批次），由上下文持有，下一次使用该上下文Forward时会被覆盖
+   * 注意：批次大小可以与结构文件中声明的不同，上下文按需扩充或复用激活内存；
+   * 输入Tensor的维度也可以不同（同一批次内须相同），此时由各Kernel推断节点输出的维度并重新规划内存，
+   * 推断和规划的结果按输入维度缓存
    */
-  static void InitOpOutputs(const std::vector<pnnx::Operand *> &outputs,
-                            const srunop &op);
+  std::vector<sftensor> Forward(ExecutionContext &context,
+                                const std::vector<sftensor> &inputs,
+                                bool debug = false) const;
 
   /**
-   * 初始化计算图节点的参数
-   * @param params pnnx计算图节点的参数
-   * @param op 计算图节点
+   * 在给定的执行上下文中执行有多个输入、输出节点的计算图推理，可被多个线程同时调用
+   * @param context 由CreateContext创建的执行上下文
+   * @param inputs 各输入节点名称及其输入Tensor（一个批次），各输入的批次大小须相同
+   * @param debug 是否调试，若调试，则逐节点记录性能信息并输出耗时统计
+   * @return 各输出节点名称及其输出Tensor（一个批次），由上下文持有，下一次使用该上下文Forward时会被覆盖
    */
-  static void InitOpParams(const std::map<std::string, pnnx::Parameter> &params,
-                           const srunop &op);
+  std::map<std::string, std::vector<sftensor>>
+  Forward(ExecutionContext &context,
+          const std::map<std::string, std::vector<sftensor>> &inputs,
+          bool debug = false) const;
 
   /**
-   * 初始化计算图节点的权重
-   * @param attrs pnnx计算图节点的权重
-   * @param op 计算图节点
+   * 返回构建时指定的输入节点名称
+   */
+  const std::vector<std::string> &input_names() const;
+
+  /**
+   * 返回构建时指定的输出节点名称
+   */
+  const std::vector<std::string> &output_names() const;
+
+  /**
+   * 设置同时执行的计算节点数目上限
+   * 大于1时，Forward将前驱均已执行完毕的节点派发到工作窃取线程池中并发执行，
+   * 使计算图中相互独立的分支可以同时计算
+   * 注意：不能与Forward同时调用；构建完毕后切换串行、并发执行会重新规划内存，之前创建的执行上下文随之失效
+   * @param max_concurrent_ops 同时执行的节点数目上限，为1时按执行计划依次执行
+   */
+  void set_max_concurrent_ops(uint32_t max_concurrent_ops);
+
+  /**
+   * 返回同时执行的计算节点数目上限
+   */
+  uint32_t max_concurrent_ops() const;
+
+  /**
+   * 设置是否融合算子，默认融合
+   * 融合时，卷积与其后的残差相加、ReLU、Hardswish节点合并为一个节点，中间结果不再写回内存
+   * 注意：需在Build之前调用
+   * @param fuse_ops 是否融合算子
+   */
+  void set_fuse_ops(bool fuse_ops);
+
+  /**
+   * 返回是否融合算子
+   */
+  bool fuse_ops() const;
+
+  /**
+   * 返回内存规划前中间激活Tensor所需的内存大小（字节），需在Build之后调用
+   * @param batch 批次大小
+   */
+  size_t naive_activation_bytes(uint32_t batch = 1) const;
+
+  /**
+   * 返回内存规划后中间激活Tensor所需的内存大小（字节），需在Build之后调用
+   * @param batch 批次大小
+   */
+  size_t planned_activation_bytes(uint32_t batch = 1) const;
+
+  /**
+   * 返回默认执行上下文中上一次调试（debug）推理的逐节点性能记录
+   * 可导出为Chrome trace文件，或输出按耗时排序的表格
+   */
+  const Profiler &profiler() const;
+
+  /**
+   * 返回按输入维度缓存的激活布局数目，不包括结构文件中声明的输入维度
+   */
+  size_t cached_layout_count() const;
+
+  /**
+   * 返回输入维度对应的激活布局是否在缓存中
+   * @param input_shapes 各输入Tensor的维度（通道数，行数，列数）
+   */
+  bool has_cached_layout(
+      const std::vector<std::vector<uint32_t>> &input_shapes) const;
+
+  /**
+   * 设置初始化、构建计算图时使用的线程数
+   * 各节点的参数解析、Kernel构造和权重转换互不依赖，在线程池中并行执行
+   * 注意：需在Build之前调用
+   * @param build_threads 线程数，为0时使用硬件线程数，为1时在当前线程中依次执行
+   */
+  void set_build_threads(uint32_t build_threads);
+
+  /**
+   * 返回初始化、构建计算图时使用的线程数，为0表示使用硬件线程数
    */
-  static void InitOpAttrs(const std::map<std::string, pnnx::Attribute> &attrs,
-                          const srunop &op);
+  uint32_t build_threads() const;
+
+  /**
+   * 设置是否与同一进程中的其他计算图共享权重，默认不共享
+   * 共享时，各节点的权重转换为Kernel内存布局后放入进程内的权重仓库（见WeightStore），
+   * 由内容相同的权重（例如同一模型批次大小不同的结构文件）构建的计算图共用一份只读权重，各自持有激活内存；
+   * 代价是构建时需计算权重内容的哈希值
+   * 注意：需在Build之前调用；加载编译好的模型时权重本身就与页缓存共享，不使用权重仓库
+   * @param share_weights 是否共享权重
+   */
+  void set_share_weights(bool share_weights);
+
+  /**
+   * 返回是否与同一进程中的其他计算图共享权重
+   */
+  bool share_weights() const;
+
+  /**
+   * 设置跨进程共享的权重段，默认不使用
+   * 构建时若段已存在，以只读方式映射，权重Tensor直接使用其中已转换好的权重；
+   * 若不存在，构造Kernel后由当前进程创建并写入权重，当前计算图也改用段中的权重。
+   * 同一主机上的多个工作进程使用同一名称即可只保留一份权重，后启动的进程不再转换权重
+   * 注意：需在Build之前调用；段不会随进程退出而删除，见SharedWeightSegment::Remove
+   * @param name 段的名称：以'/'开头且不含其他'/'时为POSIX共享内存，否则为文件路径
+   * @param wait_ms 段正由其他进程写入时等待的最长时间（毫秒），
+   * 超时后视为创建的进程已退出，删除该段并由当前进程重新创建
+   */
+  void set_weight_segment(const std::string &name, uint32_t wait_ms = 10000);
+
+  /**
+   * 返回跨进程共享的权重段名称，为空表示不使用
+   */
+  const std::string &weight_segment() const;
+
+  /**
+   * 返回构建时是否使用了其他进程（或计算图）创建的权重段
+   */
+  bool weight_segment_attached() const;
+
+  /**
+   * 返回上一次初始化、构建（或加载编译好的模型）时各阶段的耗时
+   */
+  const StartupTimings &startup_timings() const;
+
+private:
+  // 静态执行计划中的一步
+  struct ExecStep {
+    RuntimeOp *op = nullptr;        // 计算节点
+    Kernel *kernel = nullptr;       // 节点对应的计算Kernel
+    std::vector<uint32_t> in_slots; // 输入Tensor所在的槽位（按in_oprands_seq排列）
+    uint32_t out_slot = 0;          // 输出Tensor所在的槽位
+    std::vector<uint32_t> next_steps; // 依赖当前步骤输出的后继步骤
+    uint32_t dep_count = 0;           // 当前步骤依赖的前驱步骤数目
+  };
+
+  // 按输入维度缓存的激活布局数目上限，超出时移除最久未使用的
+  static constexpr size_t kMaxCachedLayouts = 16;
+
+  // 调试时输出的耗时最多的节点数目
+  static constexpr uint32_t kProfileTopNum = 10;
+
+  /**
+   * 初始化计算图
+   * @param pool 并行解析各节点的线程池，为空时在当前线程中解析
+   * @return 是否初始化成功
+   */
+  bool Init(ThreadPool *pool);
+
+  /**
+   * 创建初始化、构建计算图时使用的线程池
+   * @return 线程池，只使用一个线程时返回空
+   */
+  std::unique_ptr<ThreadPool> CreateBuildPool() const;
 
   /**
    * 创建节点的计算Kernel
@@ -108,19 +293,125 @@ private:
   static skernel CreateKernel(const srunop &op);
 
   /**
-   * 检查当前节点是否就绪
-   * @param op 待检查的节点
+   * 找到计算图输入、输出所在的槽位，并从输出逆向标记其依赖的节点
+   */
+  void ResolveGraphIO();
+
+  /**
+   * 映射已有的权重段，将输出依赖的节点的权重属性指向段中已转换好的权重
+   * @return 权重段是否已存在（不论映射是否成功），不存在时由当前进程在构造Kernel后创建
+   */
+  bool AttachWeightSegment();
+
+  /**
+   * 创建权重段并写入各Kernel的权重，之后各Kernel改用段中的权重
+   */
+  void PublishWeightSegment();
+
+  /**
+   * 为输出依赖的计算节点构造Kernel
+   * @param pool 并行构造Kernel的线程池，为空时在当前线程中构造
+   */
+  void CreateKernels(ThreadPool *pool);
+
+  /**
+   * 生成静态执行计划
+   * 按拓扑序排列输出依赖的计算节点，并预先解析每个节点输入、输出Tensor所在的槽位
+   */
+  void BuildExecPlan();
+
+  /**
+   * 由各节点的输出空间记录结构文件中声明的输入维度对应的激活布局（尚未规划内存）
+   */
+  void InitDefaultLayout();
+
+  /**
+   * 按激活布局和批次大小准备执行上下文中的Tensor，所需内存变大时扩充arena，否则复用已有内存
+   * @param context 执行上下文
+   * @param layout 输入维度对应的激活布局
+   * @param batch 批次大小
    */
-  static bool CheckOpReady(const srunop &op);
+  void PrepareContext(ExecutionContext &context,
+                      const std::shared_ptr<const ActivationLayout> &layout,
+                      uint32_t batch) const;
 
   /**
-   * 向后继节点传递Tensors，并将就绪的节点加入执行队列
-   * @param cur_op 当前节点
-   * @param ops_que 计算图节点的执行队列
-   * @param outputs 当前节点的输出Tensors，会被传递给后继节点
+   * 查找输入维度对应的激活布局，缓存中没有时推断各节点输出的维度并规划内存
+   * @param input_shapes 计算图各输入中单个Tensor的维度，按input_names_排列
+   * @return 激活布局
    */
-  static void ProbeNextOp(const srunop &cur_op, std::deque<srunop> &ops_que,
-                          const std::vector<sftensor> &outputs);
+  std::shared_ptr<const ActivationLayout>
+  FindLayout(const std::vector<std::vector<uint32_t>> &input_shapes) const;
+
+  /**
+   * 按执行计划依次调用各Kernel的InferShape，推断各槽位的Tensor维度
+   * @param layout 激活布局，须已设置input_shapes
+   * @return 是否推断成功
+   */
+  bool InferLayout(ActivationLayout &layout) const;
+
+  /**
+   * 规划激活布局中各槽位的内存
+   * 依据执行计划计算每个节点输出Tensor的生命周期，将生命周期不重叠的Tensor放入同一块arena中复用
+   * 注意：计算图的输出Tensor会返回给调用者，不参与规划；
+   * 并发执行时，只有存在依赖关系的Tensor才会复用内存
+   * @param layout 激活布局
+   */
+  void PlanLayout(ActivationLayout &layout) const;
+
+  /**
+   * 执行计算图：检查输入、准备执行上下文，并按执行计划串行或并发执行所有步骤
+   * @param context 执行上下文
+   * @param inputs 各输入节点的输入Tensor（一个批次），按input_names_排列
+   * @param debug 是否调试
+   */
+  void Execute(ExecutionContext &context,
+               const std::vector<const std::vector<sftensor> *> &inputs,
+               bool debug) const;
+
+  /**
+   * 判断槽位是否为计算图的输出
+   * @param slot 槽位
+   */
+  bool IsOutputSlot(uint32_t slot) const;
+
+  /**
+   * 执行一个步骤
+   * @param context 执行上下文
+   * @param step_idx 执行步骤
+   * @param debug 是否记录执行时间
+   */
+  void RunStep(ExecutionContext &context, uint32_t step_idx, bool debug) const;
+
+  /**
+   * 生成一个执行步骤的性能记录（不含时间），包括输入输出维度、估算的运算量和访存量
+   * @param context 执行上下文，该步骤须已执行完毕
+   * @param step_idx 执行步骤
+   */
+  ProfileRecord MakeProfileRecord(const ExecutionContext &context,
+                                  uint32_t step_idx) const;
+
+  /**
+   * 并发执行计算图：从无依赖的步骤出发，步骤执行完毕后派发就绪的后继步骤
+   * @param context 执行上下文
+   * @param debug 是否记录执行时间
+   */
+  void ForwardConcurrent(ExecutionContext &context, bool debug) const;
+
+  /**
+   * 在当前线程中沿依赖链执行步骤
+   * 当前步骤执行完毕后，就绪的第一个后继步骤留在当前线程继续执行，其余提交给线程池
+   * @param context 执行上下文
+   * @param step_idx 起始步骤
+   * @param debug 是否记录执行时间
+   */
+  void RunStepChain(ExecutionContext &context, uint32_t step_idx,
+                    bool debug) const;
+
+  /**
+   * 规划结构文件中声明的输入维度下中间激活Tensor的内存，并清空按输入维度缓存的激活布局
+   */
+  void PlanActivationMemory();
 
 private:
   // 计算图状态类型
@@ -133,14 +424,48 @@ private:
   GraphState graph_state_;  // 计算图状态
   std::string param_path_;  // 计算图结构文件
   std::string bin_path_;    // 计算图权重文件
-  std::string input_name_;  // 输入节点名称
-  std::string output_name_; // 输出节点名称
+  std::vector<std::string> input_names_;  // 输入节点名称
+  std::vector<std::string> output_names_; // 输出节点名称
 
   std::vector<srunop> ops_;                           // 计算图节点
   std::unordered_map<std::string, srunop> input_ops;  // 输入节点
   std::unordered_map<std::string, srunop> output_ops; // 输出节点
 
-  std::unique_ptr<pnnx::Graph> graph_; // pnnx格式的计算图
+  std::vector<ExecStep> exec_plan_; // 按拓扑序排列的执行步骤
+  std::vector<uint32_t> input_slots_;  // 各输入所在的槽位，按input_names_排列
+  std::vector<uint32_t> output_slots_; // 各输出所在的槽位，按output_names_排列，可能重复
+  std::vector<bool> required_ops_;     // 各节点是否被计算图的输出依赖
+  uint64_t plan_version_ = 0; // 执行计划的版本，重新规划内存时递增
+
+  uint32_t max_concurrent_ops_ = 1;     // 同时执行的计算节点数目上限
+  bool fuse_ops_ = true;                // 是否融合算子
+  uint32_t build_threads_ = 0;          // 初始化、构建时使用的线程数
+  bool share_weights_ = false;          // 是否与其他计算图共享权重
+  std::string weight_segment_name_;     // 跨进程共享的权重段名称
+  uint32_t weight_segment_wait_ms_ = 10000; // 等待其他进程写入权重段的最长时间
+  bool weight_segment_attached_ = false; // 是否使用了已有的权重段
+  SharedWeightSegment::ModelKey weight_segment_key_; // 模型的键
+  std::shared_ptr<SharedWeightSegment> weight_segment_; // 映射的权重段
+  StartupTimings startup_timings_;      // 启动各阶段的耗时
+  std::unique_ptr<ThreadPool> op_pool_; // 并发执行计算节点的线程池
+
+  uint32_t param_batch_ = 0; // 结构文件中声明的批次大小，为0表示动态批次
+  // 结构文件中声明的输入维度对应的激活布局，槽位下标与ops_一致，对应各节点的输出
+  std::shared_ptr<const ActivationLayout> default_layout_;
+  // 缓存的激活布局及其最近一次被使用的时刻
+  struct CachedLayout {
+    std::shared_ptr<const ActivationLayout> layout;
+    uint64_t last_use = 0;
+  };
+  // 按输入维度缓存的其他激活布局，超出上限时移除最久未使用的
+  mutable std::map<std::vector<std::vector<uint32_t>>, CachedLayout> layouts_;
+  mutable uint64_t layout_tick_ = 0; // 查找激活布局的次数，作为使用时刻
+  mutable std::mutex layout_mutex_; // 保护layouts_，Forward可能被多个线程同时调用
+
+  std::unique_ptr<ExecutionContext> default_context_; // 默认的执行上下文
+
+  // 权重文件或编译好的模型文件的映射，权重Tensor直接使用这段内存
+  std::shared_ptr<MappedFile> mapped_model_;
 };
 
 } // namespace TinyInfer
@@ -24,7 +24,6 @@ struct RuntimeOp {
   std::string name;               // 计算节点的名称
   std::string type;               // 计算节点的类型
   std::shared_ptr<Kernel> kernel; // 节点对应的计算Kernel
-  int32_t meet_num = 0;           // 当前节点被前驱节点访问的次数
 
   std::vector<srunoprand>
       in_oprands_seq; // 节点的输入操作数（一个节点可能有多个来源的输入）
@@ -56,6 +55,12 @@ public:
    */
   static void InitOpsOutput(const std::vector<pnnx::Operator *> &pnnx_ops,
                             const std::vector<srunop> &ops);
+
+  /**
+   * 按节点输出操作数中记录的维度初始化节点的输出空间
+   * @param ops 计算图节点，输出操作数的名称、维度、值类型已初始化
+   */
+  static void InitOpsOutput(const std::vector<srunop> &ops);
 };
 
 } // namespace TinyInfer
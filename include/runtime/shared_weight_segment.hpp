@@ -0,0 +1,149 @@
+#ifndef TINY_INFER_RUNTIME_SHARED_WEIGHT_SEGMENT_HPP_
+#define TINY_INFER_RUNTIME_SHARED_WEIGHT_SEGMENT_HPP_
+
+#include "data/tensor.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace TinyInfer {
+
+// 跨进程共享的权重段
+// 第一个进程把已转换为Kernel内存布局的权重写入命名的共享内存，之后的进程以只读方式映射同一段内存，
+// 权重Tensor直接使用其中的内存：不再转换权重，各进程的私有内存只剩激活Tensor。
+// 名称以'/'开头且不含其他'/'时使用POSIX共享内存（shm_open），否则视为文件路径，使用文件映射。
+// 段在最后一个进程退出后仍然存在，需调用Remove删除；模型更新后键不再匹配，旧的段不会被使用。
+// 创建的进程在写入完毕之前退出时，段始终未置位，之后的进程在Attach等待超时后删除它并重新创建
+//
+// 段的布局：| 文件头（Header） | 目录：各权重的名称、偏移量、元素数 | 权重值：各按64字节对齐 |
+// 注意：不支持共享内存的平台上Create、Attach总是失败，计算图退化为各自持有权重
+class SharedWeightSegment {
+public:
+  // 段的标识
+  static constexpr char kMagic[8] = {'T', 'I', 'N', 'Y', 'I', 'N', 'F', 'S'};
+  // 段的格式版本，格式或权重的内存布局变化时递增
+  static constexpr uint32_t kVersion = 1;
+  // 权重的对齐字节数
+  static constexpr size_t kAlignment = 64;
+
+  // 模型的键，结构文件内容或权重文件变化时随之变化
+  struct ModelKey {
+    uint64_t hash[2] = {0, 0};
+
+    bool operator==(const ModelKey &other) const {
+      return hash[0] == other.hash[0] && hash[1] == other.hash[1];
+    }
+  };
+
+  // 写入段中的一组权重
+  struct Entry {
+    std::string name;             // 权重名称，例如conv1.weight
+    std::vector<sftensor> tensors; // 已转换为Kernel内存布局的权重Tensor
+  };
+
+  /**
+   * 生成模型的键：结构文件内容的哈希值，以及权重文件的大小、修改时间和文件编号
+   * @param param_path 结构文件路径
+   * @param bin_path 权重文件路径
+   * @param key 模型的键
+   * @return 是否生成成功
+   */
+  static bool MakeModelKey(const std::string &param_path,
+                           const std::string &bin_path, ModelKey &key);
+
+  /**
+   * 创建权重段并写入权重，写入完毕后才对其他进程可见
+   * @param name 段的名称
+   * @param key 模型的键
+   * @param entries 写入的权重
+   * @return 创建的段（可写入，之后只读使用），段已存在或创建失败时返回空
+   */
+  static std::shared_ptr<SharedWeightSegment>
+  Create(const std::string &name, const ModelKey &key,
+         const std::vector<Entry> &entries);
+
+  /**
+   * 以只读方式映射已有的权重段
+   * 段正由其他进程写入时最多等待wait_ms毫秒，超时仍未写入完毕时删除该段
+   * @param name 段的名称
+   * @param key 模型的键，与段中记录的不同时映射失败
+   * @param wait_ms 等待其他进程写入完毕的最长时间（毫秒），应大于创建段所需的时间
+   * @param exists 段是否存在，不存在或已被删除时当前进程可以创建
+   * @return 映射的段，段不存在、未写入完毕或与模型不符时返回空
+   */
+  static std::shared_ptr<SharedWeightSegment>
+  Attach(const std::string &name, const ModelKey &key, uint32_t wait_ms,
+         bool &exists);
+
+  /**
+   * 删除权重段，已映射的进程不受影响
+   * @param name 段的名称
+   * @return 是否删除成功
+   */
+  static bool Remove(const std::string &name);
+
+  SharedWeightSegment(const SharedWeightSegment &) = delete;
+
+  SharedWeightSegment &operator=(const SharedWeightSegment &) = delete;
+
+  ~SharedWeightSegment();
+
+  /**
+   * 查找权重
+   * @param entry_name 权重名称
+   * @param elem_ct 期望的元素数目
+   * @return 权重值，不存在或元素数目不符时返回空
+   * 注意：映射的段是只读的，不能修改其中的权重
+   */
+  const float *Find(const std::string &entry_name, size_t elem_ct) const;
+
+  /**
+   * 返回段的名称
+   */
+  const std::string &name() const;
+
+  /**
+   * 返回段的大小（字节）
+   */
+  size_t size() const;
+
+private:
+  // 段的文件头
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t ready; // 写入完毕后置为1，原子访问
+    uint64_t key[2];
+    uint64_t entry_count;
+    uint64_t directory_offset; // 目录的偏移量
+    uint64_t directory_size;   // 目录的大小
+    uint64_t data_offset;      // 权重值的偏移量
+    uint64_t data_size;        // 权重值的大小
+  };
+
+  // 目录中的一项：权重值的偏移量（相对于段的起始地址）和元素数
+  struct Location {
+    uint64_t offset = 0;
+    uint64_t elem_ct = 0;
+  };
+
+  SharedWeightSegment() = default;
+
+  /**
+   * 解析目录，检查各权重值的范围
+   * @return 是否解析成功
+   */
+  bool ParseDirectory();
+
+  std::string name_;
+  uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  std::unordered_map<std::string, Location> locations_;
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_SHARED_WEIGHT_SEGMENT_HPP_
@@ -16,9 +16,16 @@
 #define PNNX_STOREZIP_H
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "runtime/mapped_file.hpp"
+
+namespace TinyInfer {
+class ThreadPool;
+} // namespace TinyInfer
+
 namespace pnnx {
 
 class StoreZipReader
@@ -27,47 +34,97 @@ class StoreZipReader
   StoreZipReader();
   ~StoreZipReader();
 
-  int open(const std::string& path);
+  // map_file: also map the whole file into memory, so that entries can be accessed in place
+  // stored and deflated entries are supported, deflated entries are decompressed into memory on open,
+  // the entries are then accessed as if they were stored in a mapped file
+  // num_threads: decompress several deflated entries in parallel, 0 for hardware concurrency,
+  // the threads are only started when the file contains deflated entries
+  int open(const std::string& path, bool map_file = false, int num_threads = 1);
 
-  size_t get_file_size(const std::string& name);
+  // pool: decompress several deflated entries in parallel in an existing pool, null to decompress them one by one
+  int open(const std::string& path, bool map_file, TinyInfer::ThreadPool* pool);
+
+  // uncompressed size of the entry
+  size_t get_file_size(const std::string& name) const;
 
   int read_file(const std::string& name, char* data);
 
+  // entry data inside the mapped file, null if the file is not mapped or no such entry
+  // lookups do not modify the reader, so they may be called from several threads at once
+  const char* get_file_data(const std::string& name) const;
+
+  // the mapped file, or the decompressed entries when the file contains deflated entries
+  std::shared_ptr<TinyInfer::MappedFile> get_mapped_file() const;
+
+  // number of deflated entries
+  size_t get_compressed_file_count() const;
+
+  // names of all entries
+  std::vector<std::string> get_names() const;
+
   int close();
 
  private:
+  static const size_t DATA_ALIGNMENT = 64;
+
+  // decompress the deflated entries, together with the stored entries if map_file,
+  // into an aligned buffer that replaces the file mapping
+  // pool: null to start up to num_threads threads of its own
+  int decode_files(const std::string& path, bool map_file, TinyInfer::ThreadPool* pool, int num_threads);
+
+  int open(const std::string& path, bool map_file, TinyInfer::ThreadPool* pool, int num_threads);
+
   FILE* fp;
 
+  std::shared_ptr<TinyInfer::MappedFile> mapped_file;
+
+  // decompressed entries
+  std::shared_ptr<TinyInfer::MappedFile> decoded_file;
+
   struct StoreZipMeta
   {
     size_t offset;
-    size_t size;
+    size_t size;              // size in the zip file
+    size_t uncompressed_size;
+    uint16_t compression;     // 0 = stored, 8 = deflated
+    uint32_t crc32;
+    size_t decoded_offset;    // offset in the decoded buffer, -1 if not decoded
   };
 
   std::map<std::string, StoreZipMeta> filemetas;
 };
 
+// entry data is aligned to DATA_ALIGNMENT bytes by padding the extra field,
+// so that the reader can use the mapped entries as float arrays directly
 class StoreZipWriter
 {
  public:
   StoreZipWriter();
   ~StoreZipWriter();
 
-  int open(const std::string& path);
+  // compression_level: deflate the entries with zlib level 1-9, 0 to store them uncompressed
+  // entries that do not shrink are stored anyway
+  int open(const std::string& path, int compression_level = 0);
 
   int write_file(const std::string& name, const char* data, size_t size);
 
   int close();
 
  private:
+  static const size_t DATA_ALIGNMENT = 64;
+
   FILE* fp;
 
+  int compression_level;
+
   struct StoreZipMeta
   {
     std::string name;
     size_t lfh_offset;
     uint32_t crc32;
     uint32_t size;
+    uint32_t compressed_size;
+    uint16_t compression;
   };
 
   std::vector<StoreZipMeta> filemetas;
@@ -0,0 +1,97 @@
+#ifndef TINY_INFER_RUNTIME_THREAD_POOL_HPP_
+#define TINY_INFER_RUNTIME_THREAD_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TinyInfer {
+
+// 工作窃取线程池
+// 每个工作线程拥有自己的任务队列：工作线程提交的任务放入自己队列的尾部并优先从尾部取出执行，
+// 自己的队列为空时从其他线程队列的头部窃取任务
+class ThreadPool {
+public:
+  using Task = std::function<void()>;
+
+  /**
+   * 创建线程池
+   * @param thread_num 工作线程数目
+   */
+  explicit ThreadPool(uint32_t thread_num);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * 提交任务
+   * @param task 待执行的任务
+   */
+  void Submit(Task task);
+
+  /**
+   * 等待所有已提交的任务执行完毕
+   * 注意：不能在工作线程中调用
+   */
+  void Wait();
+
+  /**
+   * 返回工作线程数目
+   */
+  uint32_t thread_num() const;
+
+private:
+  // 工作线程的任务队列
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  /**
+   * 工作线程的执行循环
+   * @param index 工作线程编号
+   */
+  void WorkerLoop(uint32_t index);
+
+  /**
+   * 取出一个任务：先从自己的队列尾部取，再从其他队列头部窃取
+   * @param index 工作线程编号
+   * @param task 取出的任务
+   * @return 是否取到任务
+   */
+  bool PopTask(uint32_t index, Task &task);
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_; // 每个工作线程的任务队列
+  std::vector<std::thread> workers_;               // 工作线程
+
+  std::mutex mutex_;
+  std::condition_variable task_cv_; // 有新任务或线程池停止时唤醒工作线程
+  std::condition_variable done_cv_; // 所有任务执行完毕时唤醒等待者
+  std::atomic<uint32_t> queued_{0};   // 队列中尚未取出的任务数
+  std::atomic<uint32_t> unfinished_{0}; // 尚未执行完毕的任务数
+  std::atomic<uint32_t> next_queue_{0}; // 外部线程提交任务时轮流选择的队列
+  bool stop_ = false;
+};
+
+/**
+ * 把[0, count)划分为若干段，在线程池中并行处理，并等待处理完毕
+ * 注意：不能在线程池的工作线程中调用
+ * @param pool 线程池，为空时在当前线程中依次处理
+ * @param count 元素数目
+ * @param func 处理一段元素[begin, end)的函数，不同段可能被同时调用
+ */
+void ParallelFor(ThreadPool *pool, size_t count,
+                 const std::function<void(size_t, size_t)> &func);
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_THREAD_POOL_HPP_
@@ -0,0 +1,76 @@
+#ifndef TINY_INFER_RUNTIME_WEIGHT_STORE_HPP_
+#define TINY_INFER_RUNTIME_WEIGHT_STORE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace TinyInfer {
+
+// 进程内共享的只读权重仓库
+// 以权重内容的128位哈希、字节数和权重Tensor的维度为键，保存已转换为Kernel内存布局的权重值：
+// 同一进程中由相同权重构建的多个计算图（例如批次大小不同的同一模型）共享一份权重，各自持有自己的激活内存。
+// 仓库只保存弱引用，不再有Kernel使用时权重即被释放
+class WeightStore {
+public:
+  using Blob = std::vector<float>;
+
+  /**
+   * 返回进程内唯一的权重仓库
+   */
+  static WeightStore &Instance();
+
+  WeightStore(const WeightStore &) = delete;
+
+  WeightStore &operator=(const WeightStore &) = delete;
+
+  /**
+   * 生成权重的键
+   * @param data 权重值（按权重文件中的布局存放），不要求对齐
+   * @param byte_size 权重值的字节数
+   * @param layout 各权重Tensor的维度，依次为通道数、行数、列数
+   * @return 权重的键
+   */
+  static std::string MakeKey(const char *data, size_t byte_size,
+                             const std::vector<uint32_t> &layout);
+
+  /**
+   * 查找键相同的权重，找不到时调用create生成并放入仓库
+   * 可被多个线程同时调用，create在锁外执行；同一键被同时生成时只保留先放入仓库的一份
+   * @param key 权重的键，见MakeKey
+   * @param create 生成Kernel内存布局的权重值
+   * @return 共享的权重值，只读
+   */
+  std::shared_ptr<const Blob> GetOrCreate(const std::string &key,
+                                          const std::function<Blob()> &create);
+
+  /**
+   * 返回仓库中仍被使用的权重数目
+   */
+  size_t blob_count() const;
+
+  /**
+   * 返回仓库中仍被使用的权重占用的内存大小（字节）
+   */
+  size_t blob_bytes() const;
+
+private:
+  WeightStore() = default;
+
+  /**
+   * 删除已被释放的权重，须持有mutex_
+   */
+  void RemoveExpired();
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::weak_ptr<const Blob>> blobs_;
+};
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_RUNTIME_WEIGHT_STORE_HPP_
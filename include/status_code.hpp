@@ -46,6 +46,8 @@ enum class ParseParamAttrStatus {
   AttrMissingBias = 14,
   AttrMissingWeight = 15,
   AttrMissingOutFeatures = 16,
+
+  ParamUnsupportedActivation = 17,
 };
 
 } // namespace TinyInfer
@@ -1,7 +1,11 @@
 #include "data/load_data.hpp"
+#include "runtime/mapped_file.hpp"
+#include <algorithm>
 #include <armadillo>
-#include <fstream>
+#include <charconv>
+#include <cstring>
 #include <glog/logging.h>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -15,91 +19,88 @@ arma::fmat CSVDataLoader::LoadData(const std::string &file_path,
     return data;
   }
 
-  std::ifstream in(file_path);
-  if (!in.is_open() || !in.good()) {
+  const std::shared_ptr<MappedFile> file = MappedFile::Open(file_path);
+  if (file == nullptr) {
     LOG(ERROR) << "File open failed: " << file_path;
     return data;
   }
 
-  std::string line_str;
-  std::stringstream line_stream;
-
-  const auto &[rows, cols] = CSVDataLoader::GetMatrixSize(in, split_char);
-  data.zeros(rows, cols); // 初始化全0的fmat，行列数为(rows, cols)
-
-  size_t row = 0;
-  while (in.good()) {
-    // 读取一行到line_str
-    std::getline(in, line_str);
-    if (line_str.empty()) {
-      break;
-    }
-
-    std::string token;
-    line_stream.clear();
-
-    line_stream.str(line_str);
-    size_t col = 0;
-    while (line_stream.good()) {
-      // 读取一行中的每个字符到token
-      std::getline(line_stream, token, split_char);
-      try {
-        data.at(row, col) = std::stof(token);
-      } catch (std::exception &e) {
-        DLOG(ERROR) << "Parse CSV File meet error: " << e.what()
-                    << " row: " << row << " col: " << col;
-      }
-      col += 1;
-      CHECK(col <= cols) << "There are excessive elements on the column";
-    }
-
-    row += 1;
-    CHECK(row <= rows) << "There are excessive elements on the row";
+  const std::vector<std::string_view> lines = SplitLines(std::string_view(
+      reinterpret_cast<const char *>(file->data()), file->size()));
+  const int64_t rows = lines.size();
+
+  // 列数为各行元素数的最大值，元素数为分隔符数加1
+  size_t cols = 0;
+#pragma omp parallel for reduction(max : cols)
+  for (int64_t row = 0; row < rows; ++row) {
+    const std::string_view &line = lines.at(row);
+    const size_t line_cols = std::count(line.begin(), line.end(), split_char) + 1;
+    cols = std::max(cols, line_cols);
   }
 
+  // 初始化全0的fmat，行列数为(rows, cols)，各行互不相关，并行解析
+  data.zeros(rows, cols);
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int64_t row = 0; row < rows; ++row) {
+    ParseLine(lines.at(row), split_char, row, data);
+  }
   return data;
 }
 
-std::pair<size_t, size_t> CSVDataLoader::GetMatrixSize(std::ifstream &file,
-                                                       char split_char) {
-  bool load_ok = file.good();
-  file.clear();
-  size_t fn_rows = 0;
-  size_t fn_cols = 0;
-  const std::ifstream::pos_type start_pos = file.tellg();
-
-  std::string token;
-  std::string line_str;
-  std::stringstream line_stream;
-
-  while (file.good() && load_ok) {
-    // 读入一行到line_str
-    std::getline(file, line_str);
-    if (line_str.empty()) {
+std::vector<std::string_view>
+CSVDataLoader::SplitLines(std::string_view text) {
+  std::vector<std::string_view> lines;
+  size_t start = 0;
+  while (start < text.size()) {
+    const void *newline =
+        std::memchr(text.data() + start, '\n', text.size() - start);
+    const size_t end = newline != nullptr
+                           ? static_cast<const char *>(newline) - text.data()
+                           : text.size();
+    if (end == start) {
       break;
     }
+    lines.push_back(text.substr(start, end - start));
+    start = end + 1;
+  }
+  return lines;
+}
 
-    // 将string对象转化为stringstream对象
-    line_stream.clear();
-    line_stream.str(line_str);
-
-    size_t line_cols = 0;
-    std::string row_token;
-    while (line_stream.good()) {
-      // 读取一行中的每个字符到row_token
-      std::getline(line_stream, row_token, split_char);
-      ++line_cols;
+void CSVDataLoader::ParseLine(std::string_view line, char split_char,
+                              size_t row, arma::fmat &data) {
+  size_t col = 0;
+  size_t start = 0;
+  while (true) {
+    size_t end = line.find(split_char, start);
+    if (end == std::string_view::npos) {
+      end = line.size();
     }
 
-    if (line_cols > fn_cols) {
-      fn_cols = line_cols;
+    // 与std::stof相同，跳过开头的空白字符和正号
+    const char *first = line.data() + start;
+    const char *last = line.data() + end;
+    while (first < last && (*first == ' ' || *first == '\t')) {
+      ++first;
+    }
+    if (first < last && *first == '+') {
+      ++first;
+    }
+    float value = 0.f;
+    const auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec == std::errc()) {
+      data.at(row, col) = value;
+    } else {
+      DLOG(ERROR) << "Parse CSV File meet error: "
+                  << std::string(line.substr(start, end - start))
+                  << " row: " << row << " col: " << col;
     }
 
-    ++fn_rows;
+    col += 1;
+    if (end == line.size()) {
+      break;
+    }
+    start = end + 1;
   }
-  file.clear();
-  file.seekg(start_pos);
-  return {fn_rows, fn_cols};
 }
 
-} // namespace TinyInfer
\ No newline at end of file
+} // namespace TinyInfer
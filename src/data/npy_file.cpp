@@ -0,0 +1,446 @@
+#include "data/npy_file.hpp"
+#include "runtime/mapped_file.hpp"
+#include "runtime/store_zip.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <glog/logging.h>
+#include <string_view>
+
+namespace TinyInfer {
+
+namespace {
+constexpr char kNpyMagic[] = "\x93NUMPY";
+constexpr size_t kNpyMagicSize = 6;
+// 文件头（含魔数）按64字节对齐，数组数据随之对齐
+constexpr size_t kNpyAlignment = 64;
+
+// .npy文件头描述的数组
+struct NpyArray {
+  char type = 'f';           // 元素类型：f浮点数，i有符号整数，u无符号整数
+  uint32_t elem_size = 4;    // 元素的字节数
+  bool fortran_order = false; // 是否按列主序存放
+  std::vector<uint64_t> shape;
+  const uint8_t *data = nullptr; // 数组数据的起始地址
+  size_t elem_ct = 0;            // 元素数目
+};
+
+// 取出文件头字典中key对应的值，值以','或'}'结束，元组以')'结束
+bool FindHeaderValue(std::string_view header, std::string_view key,
+                     std::string_view &value) {
+  const size_t key_pos = header.find(key);
+  if (key_pos == std::string_view::npos) {
+    return false;
+  }
+  size_t start = header.find(':', key_pos + key.size());
+  if (start == std::string_view::npos) {
+    return false;
+  }
+  start = header.find_first_not_of(' ', start + 1);
+  if (start == std::string_view::npos) {
+    return false;
+  }
+  const size_t end = header[start] == '('
+                         ? header.find(')', start)
+                         : header.find_first_of(",}", start);
+  if (end == std::string_view::npos) {
+    return false;
+  }
+  value = header.substr(start, end - start + (header[start] == '(' ? 1 : 0));
+  return true;
+}
+
+/**
+ * 解析.npy文件头
+ * @param data 文件内容
+ * @param size 文件大小（字节）
+ * @param file_path 文件路径，用于报错
+ * @param array 文件头描述的数组
+ * @return 是否解析成功
+ */
+bool ParseNpy(const uint8_t *data, size_t size, const std::string &file_path,
+              NpyArray &array) {
+  if (size < kNpyMagicSize + 4 ||
+      std::memcmp(data, kNpyMagic, kNpyMagicSize) != 0) {
+    LOG(ERROR) << "Not a npy file: " << file_path;
+    return false;
+  }
+
+  // 1.0版本的文件头长度为2字节，2.0、3.0版本为4字节
+  const uint8_t major_version = data[kNpyMagicSize];
+  size_t header_start = kNpyMagicSize + 2;
+  uint32_t header_size = 0;
+  if (major_version == 1) {
+    uint16_t header_size16 = 0;
+    std::memcpy(&header_size16, data + header_start, sizeof(uint16_t));
+    header_size = header_size16;
+    header_start += sizeof(uint16_t);
+  } else if (major_version == 2 || major_version == 3) {
+    if (size < header_start + sizeof(uint32_t)) {
+      LOG(ERROR) << "The npy file is truncated: " << file_path;
+      return false;
+    }
+    std::memcpy(&header_size, data + header_start, sizeof(uint32_t));
+    header_start += sizeof(uint32_t);
+  } else {
+    LOG(ERROR) << "Unsupported npy version " << int(major_version) << ": "
+               << file_path;
+    return false;
+  }
+  if (size < header_start + header_size) {
+    LOG(ERROR) << "The npy file is truncated: " << file_path;
+    return false;
+  }
+
+  // 文件头为Python字典：{'descr': '<f4', 'fortran_order': False, 'shape': (2, 3), }
+  const std::string_view header(
+      reinterpret_cast<const char *>(data + header_start), header_size);
+  std::string_view descr;
+  std::string_view fortran_order;
+  std::string_view shape;
+  if (!FindHeaderValue(header, "'descr'", descr) ||
+      !FindHeaderValue(header, "'fortran_order'", fortran_order) ||
+      !FindHeaderValue(header, "'shape'", shape)) {
+    LOG(ERROR) << "Can not parse the npy header " << header << ": "
+               << file_path;
+    return false;
+  }
+
+  // 元素类型形如'<f4'：字节序、类型、字节数
+  if (descr.size() < 5 || descr.front() != '\'' || descr.back() != '\'') {
+    LOG(ERROR) << "Unsupported npy dtype " << descr << ": " << file_path;
+    return false;
+  }
+  const char byte_order = descr[1];
+  array.type = descr[2];
+  const std::string_view elem_size = descr.substr(3, descr.size() - 4);
+  const auto [size_end, size_ec] = std::from_chars(
+      elem_size.data(), elem_size.data() + elem_size.size(), array.elem_size);
+  const bool supported =
+      size_ec == std::errc() &&
+      size_end == elem_size.data() + elem_size.size() &&
+      ((array.type == 'f' && (array.elem_size == 4 || array.elem_size == 8)) ||
+       (array.type == 'i' && (array.elem_size == 4 || array.elem_size == 8)) ||
+       (array.type == 'u' && array.elem_size == 1));
+  if (!supported ||
+      (byte_order == '>' && array.elem_size > 1)) {
+    LOG(ERROR) << "Unsupported npy dtype " << descr << ": " << file_path;
+    return false;
+  }
+  array.fortran_order = fortran_order == "True";
+
+  // 维度为元组：()、(3,)或(2, 3)
+  array.shape.clear();
+  array.elem_ct = 1;
+  std::string_view dims = shape.substr(1, shape.size() - 2);
+  while (!dims.empty()) {
+    const size_t start = dims.find_first_not_of(" ,");
+    if (start == std::string_view::npos) {
+      break;
+    }
+    dims = dims.substr(start);
+    uint64_t dim = 0;
+    const auto [ptr, ec] =
+        std::from_chars(dims.data(), dims.data() + dims.size(), dim);
+    if (ec != std::errc() || dim == 0 || dim > UINT32_MAX) {
+      LOG(ERROR) << "Unsupported npy shape " << shape << ": " << file_path;
+      return false;
+    }
+    array.shape.push_back(dim);
+    array.elem_ct *= dim;
+    dims = dims.substr(ptr - dims.data());
+  }
+
+  array.data = data + header_start + header_size;
+  if (array.elem_ct > (size - header_start - header_size) / array.elem_size) {
+    LOG(ERROR) << "The npy file is truncated: " << file_path;
+    return false;
+  }
+  return true;
+}
+
+template <typename T> float ElementAt(const uint8_t *data, size_t index) {
+  T value;
+  std::memcpy(&value, data + index * sizeof(T), sizeof(T));
+  return static_cast<float>(value);
+}
+
+// 读取数组中的一个元素并转换为float
+float ElementAt(const NpyArray &array, size_t index) {
+  if (array.type == 'f') {
+    return array.elem_size == 4 ? ElementAt<float>(array.data, index)
+                                : ElementAt<double>(array.data, index);
+  } else if (array.type == 'i') {
+    return array.elem_size == 4 ? ElementAt<int32_t>(array.data, index)
+                                : ElementAt<int64_t>(array.data, index);
+  }
+  return ElementAt<uint8_t>(array.data, index);
+}
+
+/**
+ * 把数组划分为一个批次的Tensor
+ * @param array 数组
+ * @param batch 批次大小，即第一维的大小；不划分时为1
+ * @param sample_dims 每个Tensor的维度（第一维之后的各维），最多3维
+ * @param file 数组所在的映射内存，直接使用时由Tensor持有
+ * @return 一个批次的Tensor
+ */
+std::vector<sftensor> MakeTensors(const NpyArray &array, uint32_t batch,
+                                  const std::vector<uint64_t> &sample_dims,
+                                  const std::shared_ptr<MappedFile> &file) {
+  // 每个Tensor的通道数、行数、列数
+  uint32_t dims[3] = {1, 1, 1};
+  std::copy(sample_dims.begin(), sample_dims.end(),
+            dims + 3 - sample_dims.size());
+  const uint32_t channels = dims[0];
+  const uint32_t rows = dims[1];
+  const uint32_t cols = dims[2];
+  const size_t plane = size_t(rows) * cols;
+  const size_t sample_size = plane * channels;
+
+  // 行主序时每个通道的行数或列数为1，列主序时只有一个Tensor、一个通道，内存布局与Tensor相同
+  const bool same_layout = array.fortran_order
+                               ? batch == 1 && channels == 1
+                               : rows == 1 || cols == 1;
+  const bool zero_copy =
+      same_layout && array.type == 'f' && array.elem_size == sizeof(float) &&
+      reinterpret_cast<uintptr_t>(array.data) % alignof(float) == 0;
+
+  std::vector<sftensor> tensors;
+  tensors.reserve(batch);
+  for (uint32_t b = 0; b < batch; ++b) {
+    if (zero_copy) {
+      // 映射的内存为私有映射，修改Tensor不会写回文件
+      float *raw_ptr = reinterpret_cast<float *>(
+                           const_cast<uint8_t *>(array.data)) +
+                       b * sample_size;
+      tensors.push_back(
+          sftensor(new ftensor(raw_ptr, channels, rows, cols),
+                   [file](ftensor *tensor) { delete tensor; }));
+      continue;
+    }
+
+    sftensor tensor = std::make_shared<ftensor>(channels, rows, cols);
+    float *dst = tensor->data().memptr();
+    for (uint32_t c = 0; c < channels; ++c) {
+      for (uint32_t r = 0; r < rows; ++r) {
+        for (uint32_t col = 0; col < cols; ++col) {
+          // 行主序：((b * C + c) * R + r) * W + col，列主序：b + B * (c + C * (r + R * col))
+          const size_t index =
+              array.fortran_order
+                  ? b + size_t(batch) * (c + size_t(channels) *
+                                                 (r + size_t(rows) * col))
+                  : b * sample_size + c * plane + size_t(r) * cols + col;
+          dst[c * plane + size_t(col) * rows + r] = ElementAt(array, index);
+        }
+      }
+    }
+    tensors.push_back(tensor);
+  }
+  return tensors;
+}
+
+// 把数组按第一维划分为一个批次的Tensor
+std::vector<sftensor> MakeBatch(const NpyArray &array,
+                                const std::string &file_path,
+                                const std::shared_ptr<MappedFile> &file) {
+  if (array.shape.empty() || array.shape.size() > 4) {
+    LOG(ERROR) << "Can not load a batch from the " << array.shape.size()
+               << "-d array: " << file_path;
+    return {};
+  }
+  const std::vector<uint64_t> sample_dims(array.shape.begin() + 1,
+                                          array.shape.end());
+  return MakeTensors(array, array.shape.front(), sample_dims, file);
+}
+
+// 生成数组的.npy文件内容：文件头以及按行主序存放的float32数据
+std::string MakeNpy(const std::vector<uint64_t> &shape,
+                    const std::vector<sftensor> &tensors) {
+  std::string dict = "{'descr': '<f4', 'fortran_order': False, 'shape': (";
+  for (size_t i = 0; i < shape.size(); ++i) {
+    dict += std::to_string(shape.at(i)) + (shape.size() == 1 ? "," : "");
+    if (i + 1 < shape.size()) {
+      dict += ", ";
+    }
+  }
+  dict += "), }";
+
+  // 用空格补齐文件头，以换行符结束
+  const size_t unpadded = kNpyMagicSize + 2 + sizeof(uint16_t) + dict.size() + 1;
+  dict.append((kNpyAlignment - unpadded % kNpyAlignment) % kNpyAlignment, ' ');
+  dict += '\n';
+
+  size_t elem_ct = 0;
+  for (const sftensor &tensor : tensors) {
+    elem_ct += tensor->size();
+  }
+  std::string npy(kNpyMagic, kNpyMagicSize);
+  npy += '\x01';
+  npy += '\x00';
+  const uint16_t header_size = dict.size();
+  npy.append(reinterpret_cast<const char *>(&header_size), sizeof(uint16_t));
+  npy += dict;
+
+  // Tensor的每个通道按列主序存放，转换为行主序
+  const size_t data_start = npy.size();
+  npy.resize(data_start + elem_ct * sizeof(float));
+  float *dst = reinterpret_cast<float *>(npy.data() + data_start);
+  for (const sftensor &tensor : tensors) {
+    const uint32_t rows = tensor->rows();
+    const uint32_t cols = tensor->cols();
+    const float *src = tensor->raw_ptr();
+    for (uint32_t c = 0; c < tensor->channels(); ++c) {
+      for (uint32_t r = 0; r < rows; ++r) {
+        for (uint32_t col = 0; col < cols; ++col) {
+          *dst++ = src[size_t(col) * rows + r];
+        }
+      }
+      src += size_t(rows) * cols;
+    }
+  }
+  return npy;
+}
+
+// 检查一个批次的Tensor维度相同，返回数组的维度：批次大小和Tensor的维度
+bool BatchShape(const std::vector<sftensor> &tensors,
+                std::vector<uint64_t> &shape) {
+  if (tensors.empty() || tensors.front() == nullptr ||
+      tensors.front()->empty()) {
+    return false;
+  }
+  const std::vector<uint32_t> &raw_shape = tensors.front()->raw_shape();
+  for (const sftensor &tensor : tensors) {
+    if (tensor == nullptr || tensor->raw_shape() != raw_shape) {
+      return false;
+    }
+  }
+  shape.assign({tensors.size()});
+  shape.insert(shape.end(), raw_shape.begin(), raw_shape.end());
+  return true;
+}
+
+bool WriteFile(const std::string &file_path, const std::string &content) {
+  std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+  file.write(content.data(), content.size());
+  if (!file) {
+    LOG(ERROR) << "Can not write the file: " << file_path;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+sftensor NpyFile::Load(const std::string &file_path) {
+  const std::shared_ptr<MappedFile> file = MappedFile::Open(file_path);
+  NpyArray array;
+  if (file == nullptr ||
+      !ParseNpy(file->data(), file->size(), file_path, array)) {
+    return nullptr;
+  }
+
+  // 第一维为1的4维数组视为一个Tensor
+  std::vector<uint64_t> dims = array.shape;
+  if (dims.size() == 4 && dims.front() == 1) {
+    dims.erase(dims.begin());
+  }
+  if (dims.size() > 3) {
+    LOG(ERROR) << "Can not load a tensor from the " << array.shape.size()
+               << "-d array: " << file_path;
+    return nullptr;
+  }
+  return MakeTensors(array, 1, dims, file).front();
+}
+
+std::vector<sftensor> NpyFile::LoadBatch(const std::string &file_path) {
+  const std::shared_ptr<MappedFile> file = MappedFile::Open(file_path);
+  NpyArray array;
+  if (file == nullptr ||
+      !ParseNpy(file->data(), file->size(), file_path, array)) {
+    return {};
+  }
+  return MakeBatch(array, file_path, file);
+}
+
+std::map<std::string, std::vector<sftensor>>
+NpyFile::LoadNpz(const std::string &file_path) {
+  // 压缩的数组在打开时解压到内存中，之后与不压缩的数组相同，都直接使用映射的内存
+  pnnx::StoreZipReader reader;
+  if (reader.open(file_path, true) != 0) {
+    LOG(ERROR) << "Can not open the npz file: " << file_path;
+    return {};
+  }
+
+  std::map<std::string, std::vector<sftensor>> arrays;
+  const std::string suffix = ".npy";
+  for (const std::string &name : reader.get_names()) {
+    if (name.size() <= suffix.size() ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+      continue;
+    }
+    const std::string entry_path = file_path + "/" + name;
+    NpyArray array;
+    if (!ParseNpy(reinterpret_cast<const uint8_t *>(reader.get_file_data(name)),
+                  reader.get_file_size(name), entry_path, array)) {
+      return {};
+    }
+    std::vector<sftensor> tensors =
+        MakeBatch(array, entry_path, reader.get_mapped_file());
+    if (tensors.empty()) {
+      return {};
+    }
+    arrays.insert({name.substr(0, name.size() - suffix.size()),
+                   std::move(tensors)});
+  }
+  return arrays;
+}
+
+bool NpyFile::Save(const std::string &file_path, const sftensor &tensor) {
+  if (tensor == nullptr || tensor->empty()) {
+    LOG(ERROR) << "Can not save an empty tensor: " << file_path;
+    return false;
+  }
+  const std::vector<uint32_t> &raw_shape = tensor->raw_shape();
+  const std::vector<uint64_t> shape(raw_shape.begin(), raw_shape.end());
+  return WriteFile(file_path, MakeNpy(shape, {tensor}));
+}
+
+bool NpyFile::SaveBatch(const std::string &file_path,
+                        const std::vector<sftensor> &tensors) {
+  std::vector<uint64_t> shape;
+  if (!BatchShape(tensors, shape)) {
+    LOG(ERROR) << "The tensors in the batch are empty or have different "
+                  "shapes: "
+               << file_path;
+    return false;
+  }
+  return WriteFile(file_path, MakeNpy(shape, tensors));
+}
+
+bool NpyFile::SaveNpz(
+    const std::string &file_path,
+    const std::map<std::string, std::vector<sftensor>> &arrays,
+    int compression_level) {
+  pnnx::StoreZipWriter writer;
+  if (writer.open(file_path, compression_level) != 0) {
+    LOG(ERROR) << "Can not write the file: " << file_path;
+    return false;
+  }
+  for (const auto &[name, tensors] : arrays) {
+    std::vector<uint64_t> shape;
+    if (!BatchShape(tensors, shape)) {
+      LOG(ERROR) << "The tensors in the batch " << name
+                 << " are empty or have different shapes: " << file_path;
+      writer.close();
+      std::remove(file_path.c_str());
+      return false;
+    }
+    const std::string npy = MakeNpy(shape, tensors);
+    writer.write_file(name + ".npy", npy.data(), npy.size());
+  }
+  writer.close();
+  return true;
+}
+
+} // namespace TinyInfer
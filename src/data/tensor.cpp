@@ -34,6 +34,22 @@ Tensor<float>::Tensor(const std::vector<uint32_t> &shape) {
   }
 }
 
+Tensor<float>::Tensor(float *raw_ptr, uint32_t channels, uint32_t rows,
+                      uint32_t cols)
+    : data_(raw_ptr, rows, cols, channels, false, true) {
+  // 直接使用外部内存（不拷贝），且不允许改变元素数目
+  CHECK(raw_ptr != nullptr);
+  CHECK(channels >= 1 && rows >= 1 && cols >= 1);
+
+  if (channels == 1 && rows == 1) {
+    this->raw_shape_ = std::vector<uint32_t>{cols};
+  } else if (channels == 1) {
+    this->raw_shape_ = std::vector<uint32_t>{rows, cols};
+  } else {
+    this->raw_shape_ = std::vector<uint32_t>{channels, rows, cols};
+  }
+}
+
 Tensor<float>::Tensor(const Tensor &tensor) {
   if (this != &tensor) {
     this->data_ = tensor.data_;
@@ -1,26 +1,41 @@
 #include "kernel/abstract/attr_kernel.hpp"
+#include "runtime/weight_store.hpp"
+#include <cstdint>
+#include <cstring>
 #include <glog/logging.h>
 
 namespace TinyInfer {
 
+namespace {
+// 在一块连续的内存上依次创建count个维度相同的Tensor，每个Tensor都持有这块内存
+// 权重连续存放时，Kernel可以把全部权重当作一个矩阵直接使用
+std::vector<sftensor> MakeContiguousTensors(uint32_t count, uint32_t channel,
+                                            uint32_t height, uint32_t width) {
+  const size_t tensor_size = size_t(channel) * height * width;
+  auto block = std::make_shared<std::vector<float>>(count * tensor_size);
+  std::vector<sftensor> tensors(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    tensors.at(i) =
+        sftensor(new ftensor(block->data() + i * tensor_size, channel, height,
+                             width),
+                 [block](ftensor *tensor) { delete tensor; });
+  }
+  return tensors;
+}
+} // namespace
+
 AttrKernel::AttrKernel(const std::string &name) : Kernel(name) {}
 
 void AttrKernel::InitWeights(const uint32_t count, const uint32_t channel,
                              const uint32_t height, const uint32_t width) {
-  this->weights_ = std::vector<sftensor>(count);
-  // 为每个权重Tensor开辟内存空间
-  for (uint32_t i = 0; i < count; ++i) {
-    this->weights_.at(i) = std::make_shared<ftensor>(channel, height, width);
-  }
+  // 为权重Tensor开辟一块连续的内存空间
+  this->weights_ = MakeContiguousTensors(count, channel, height, width);
 }
 
 void AttrKernel::InitBias(const uint32_t count, const uint32_t channel,
                           const uint32_t height, const uint32_t width) {
-  this->bias_ = std::vector<sftensor>(count);
-  //为每个偏置Tensor开辟内存空间
-  for (uint32_t i = 0; i < count; ++i) {
-    this->bias_.at(i) = std::make_shared<ftensor>(channel, height, width);
-  }
+  //为偏置Tensor开辟一块连续的内存空间
+  this->bias_ = MakeContiguousTensors(count, channel, height, width);
 }
 
 void AttrKernel::set_weights(const std::vector<sftensor> &weights) {
@@ -36,6 +51,7 @@ void AttrKernel::set_weights(const std::vector<sftensor> &weights) {
   }
 
   this->weights_ = weights;
+  this->WeightsUpdated();
 }
 
 void AttrKernel::set_weights(const std::vector<float> &weights) {
@@ -58,6 +74,7 @@ void AttrKernel::set_weights(const std::vector<float> &weights) {
         std::vector<float>{weights.begin() + start, weights.begin() + end};
     this->weights_.at(i)->Fill(sub_vals, true);
   }
+  this->WeightsUpdated();
 }
 
 void AttrKernel::set_bias(const std::vector<sftensor> &bias) {
@@ -97,10 +114,161 @@ void AttrKernel::set_bias(const std::vector<float> &bias) {
   }
 }
 
+namespace {
+// 将已初始化的Tensor替换为data中对应位置的视图，Tensor的维度保持不变
+void WrapTensors(std::vector<sftensor> &tensors, float *data, size_t size) {
+  size_t elem_ct = 0;
+  for (const auto &tensor : tensors) {
+    elem_ct += tensor->size();
+  }
+  CHECK_EQ(elem_ct, size) << "Packed weight size do not match";
+
+  float *raw_ptr = data;
+  for (auto &tensor : tensors) {
+    const uint32_t tensor_size = tensor->size();
+    tensor = std::make_shared<ftensor>(raw_ptr, tensor->channels(),
+                                       tensor->rows(), tensor->cols());
+    raw_ptr += tensor_size;
+  }
+}
+
+// 把按权重文件布局存放的权重值原地转换为Tensor的内存布局
+// 权重文件中每个通道按行主序存放，Tensor按列主序存放：行数或列数为1的通道两者相同，不修改内存；
+// 其余通道原地转置
+void TransposeChannels(const std::vector<sftensor> &tensors, float *data) {
+  std::vector<float> plane_buffer;
+  float *channel_ptr = data;
+  for (const auto &tensor : tensors) {
+    const uint32_t rows = tensor->rows();
+    const uint32_t cols = tensor->cols();
+    const uint32_t plane = rows * cols;
+    for (uint32_t c = 0; c < tensor->channels(); ++c) {
+      if (rows > 1 && cols > 1) {
+        plane_buffer.assign(channel_ptr, channel_ptr + plane);
+        for (uint32_t r = 0; r < rows; ++r) {
+          for (uint32_t col = 0; col < cols; ++col) {
+            channel_ptr[col * rows + r] = plane_buffer[r * cols + col];
+          }
+        }
+      }
+      channel_ptr += plane;
+    }
+  }
+}
+
+// 把映射的权重值原地转换为Tensor的内存布局，转换后作为打包好的权重值使用
+// 不需要转置的通道不修改内存，页面仍与页缓存共享；只有被转置的页面会复制一份（写时复制）
+// 映射的权重值未按float对齐或数目不符时不做转换，之后复制加载
+void PackMappedTensors(const std::vector<sftensor> &tensors,
+                       RuntimeAttr &attr) {
+  if (attr.mapped_data == nullptr || attr.packed_data != nullptr ||
+      attr.type != RuntimeDataType::TypeFloat32 ||
+      reinterpret_cast<uintptr_t>(attr.mapped_data) % alignof(float) != 0) {
+    return;
+  }
+  size_t elem_ct = 0;
+  for (const auto &tensor : tensors) {
+    elem_ct += tensor->size();
+  }
+  if (elem_ct * sizeof(float) != attr.mapped_size) {
+    return;
+  }
+
+  // 权重文件以私有可写方式映射，修改不会写回文件
+  float *raw_ptr =
+      reinterpret_cast<float *>(const_cast<char *>(attr.mapped_data));
+  TransposeChannels(tensors, raw_ptr);
+
+  attr.packed_data = raw_ptr;
+  attr.packed_size = elem_ct;
+  attr.clear();
+}
+} // namespace
+
+bool AttrKernel::ShareTensors(std::vector<sftensor> &tensors,
+                              RuntimeAttr &attr) {
+  // 打包好的权重位于映射的模型文件中，本身就与页缓存共享
+  if (!attr.share || attr.packed_data != nullptr ||
+      attr.type != RuntimeDataType::TypeFloat32) {
+    return false;
+  }
+  const bool mapped = attr.weight_data.empty();
+  const char *raw_data = mapped ? attr.mapped_data : attr.weight_data.data();
+  const size_t byte_size = mapped ? attr.mapped_size : attr.weight_data.size();
+  if (raw_data == nullptr) {
+    return false;
+  }
+
+  size_t elem_ct = 0;
+  std::vector<uint32_t> layout;
+  for (const auto &tensor : tensors) {
+    elem_ct += tensor->size();
+    layout.push_back(tensor->channels());
+    layout.push_back(tensor->rows());
+    layout.push_back(tensor->cols());
+  }
+  if (elem_ct * sizeof(float) != byte_size) {
+    return false;
+  }
+
+  const std::string key = WeightStore::MakeKey(raw_data, byte_size, layout);
+  auto blob = WeightStore::Instance().GetOrCreate(key, [&]() {
+    WeightStore::Blob packed(elem_ct);
+    std::memcpy(packed.data(), raw_data, byte_size);
+    TransposeChannels(tensors, packed.data());
+    return packed;
+  });
+
+  // 共享的权重只读，Kernel不会修改权重Tensor
+  WrapTensors(tensors, const_cast<float *>(blob->data()), blob->size());
+  shared_weights_.push_back(std::move(blob));
+  attr.clear();
+  return true;
+}
+
+void AttrKernel::LoadWeights(RuntimeAttr &attr) {
+  if (ShareTensors(this->weights_, attr)) {
+    this->WeightsUpdated();
+    return;
+  }
+  PackMappedTensors(this->weights_, attr);
+  if (attr.packed_data != nullptr) {
+    WrapTensors(this->weights_, attr.packed_data, attr.packed_size);
+    this->WeightsUpdated();
+  } else {
+    this->set_weights(attr.get<float>());
+  }
+}
+
+void AttrKernel::LoadBias(RuntimeAttr &attr) {
+  if (ShareTensors(this->bias_, attr)) {
+    return;
+  }
+  PackMappedTensors(this->bias_, attr);
+  if (attr.packed_data != nullptr) {
+    WrapTensors(this->bias_, attr.packed_data, attr.packed_size);
+  } else {
+    this->set_bias(attr.get<float>());
+  }
+}
+
 const std::vector<sftensor> &AttrKernel::weights() const {
   return this->weights_;
 }
 
 const std::vector<sftensor> &AttrKernel::bias() const { return this->bias_; }
 
+void AttrKernel::WeightsUpdated() {}
+
+size_t AttrKernel::weight_bytes() const {
+  size_t bytes = 0;
+  for (const auto &weight : this->weights_) {
+    bytes += weight->size() * sizeof(float);
+  }
+  for (const auto &bias : this->bias_) {
+    bytes += bias->size() * sizeof(float);
+  }
+  return bytes;
+}
+
 } // namespace TinyInfer
@@ -26,11 +26,12 @@ void KernelRegister::RegisterCreator(const std::string &op_type,
 skernel KernelRegister::CreateKernel(const srunop &op) {
   Registry &registry = CreateRegistry(); // 取出注册表
 
+  // 只查找不插入，构建时多个线程可以同时创建Kernel
   const std::string &op_type = op->type;
-  CHECK(registry.find(op_type) != registry.end())
-      << "Can not find the kernel type: " << op_type;
+  const auto iter = registry.find(op_type);
+  CHECK(iter != registry.end()) << "Can not find the kernel type: " << op_type;
 
-  const auto &creator = registry[op_type];
+  const auto &creator = iter->second;
   CHECK(creator != nullptr) << "Kernel creator is empty!";
 
   // 调用creator创建op对应的kernel
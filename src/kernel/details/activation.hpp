@@ -0,0 +1,56 @@
+#ifndef TINY_INFER_SOURCE_KERNEL_ACTIVATION_HPP_
+#define TINY_INFER_SOURCE_KERNEL_ACTIVATION_HPP_
+
+#include "platform.hpp"
+#include <string>
+
+namespace TinyInfer {
+
+// 融合进前一个Kernel的激活函数类型
+enum class ActivationType {
+  ActivationNone = 0,      // 不做激活
+  ActivationRelu = 1,      // nn.ReLU
+  ActivationHardSwish = 2, // nn.Hardswish
+};
+
+/**
+ * 由计算节点类型得到激活函数类型
+ * @param op_type 激活节点的类型，如nn.ReLU
+ * @param activation 激活函数类型
+ * @return 是否支持该类型的激活节点
+ */
+inline bool ParseActivationType(const std::string &op_type,
+                                ActivationType &activation) {
+  if (op_type == "nn.ReLU") {
+    activation = ActivationType::ActivationRelu;
+  } else if (op_type == "nn.Hardswish") {
+    activation = ActivationType::ActivationHardSwish;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * 计算单个元素的激活值，与对应激活Kernel的逐元素计算一致
+ */
+template <ActivationType activation>
+TINY_FORCEINLINE float Activate(float in) {
+  if constexpr (activation == ActivationType::ActivationRelu) {
+    return in > 0.f ? in : 0.f;
+  } else if constexpr (activation == ActivationType::ActivationHardSwish) {
+    if (in <= -3.f) {
+      return 0.f;
+    } else if (in >= 3.f) {
+      return in;
+    } else {
+      return in * (in + 3) / 6;
+    }
+  } else {
+    return in;
+  }
+}
+
+} // namespace TinyInfer
+
+#endif // TINY_INFER_SOURCE_KERNEL_ACTIVATION_HPP_
@@ -10,7 +10,7 @@ AdaptAvgPooling::AdaptAvgPooling(uint32_t output_h, uint32_t output_w)
       output_w_(output_w) {}
 
 InferStatus AdaptAvgPooling::Forward(const std::vector<sftensor> &inputs,
-                                     std::vector<sftensor> &outputs) {
+                                     std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -82,6 +82,34 @@ InferStatus AdaptAvgPooling::Forward(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+bool AdaptAvgPooling::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                                 std::vector<uint32_t> &output_shape) const {
+  if (input_shapes.size() != 1 || input_shapes.front().size() != 3) {
+    LOG(ERROR) << "The input shape of AdaptAvgPooling is wrong";
+    return false;
+  }
+  const auto &in_shape = input_shapes.front();
+  if (in_shape.at(1) < output_h_ || in_shape.at(2) < output_w_) {
+    LOG(ERROR) << "The input shape of AdaptAvgPooling is wrong";
+    return false;
+  }
+
+  // 输出的高度和宽度固定，与输入无关
+  output_shape = {in_shape.at(0), output_h_, output_w_};
+  return true;
+}
+
+uint64_t AdaptAvgPooling::Flops(const std::vector<std::vector<uint32_t>> &input_shapes,
+                                const std::vector<uint32_t> &output_shape) const {
+  // 每个输入元素累加一次，每个输出元素再做一次除法
+  const auto &in_shape = input_shapes.front();
+  const uint64_t in_elem =
+      uint64_t(in_shape.at(0)) * in_shape.at(1) * in_shape.at(2);
+  const uint64_t out_elem =
+      uint64_t(output_shape.at(0)) * output_shape.at(1) * output_shape.at(2);
+  return in_elem + out_elem;
+}
+
 ParseParamAttrStatus AdaptAvgPooling::Creator(const srunop &op,
                                               skernel &adapt_avgpooling) {
   if (op == nullptr) {
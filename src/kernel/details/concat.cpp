@@ -7,7 +7,7 @@ namespace TinyInfer {
 Concat::Concat(int dim) : NoAttrKernel("Concat"), dim_(dim) {}
 
 InferStatus Concat::Forward(const std::vector<sftensor> &inputs,
-                            std::vector<sftensor> &outputs) {
+                            std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -66,6 +66,27 @@ InferStatus Concat::Forward(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+bool Concat::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                        std::vector<uint32_t> &output_shape) const {
+  if (input_shapes.empty()) {
+    LOG(ERROR) << "The input shape of Concat is empty";
+    return false;
+  }
+
+  // 沿Channel维度拼接，Forward要求各来源的Tensor维度相同
+  const auto &in_shape = input_shapes.front();
+  for (const auto &shape : input_shapes) {
+    if (shape.size() != 3 || shape != in_shape) {
+      LOG(ERROR) << "The input shapes of Concat do not match";
+      return false;
+    }
+  }
+
+  const uint32_t packet_sz = input_shapes.size();
+  output_shape = {in_shape.at(0) * packet_sz, in_shape.at(1), in_shape.at(2)};
+  return true;
+}
+
 ParseParamAttrStatus Concat::Creator(const srunop &op, skernel &concat) {
   if (op == nullptr) {
     LOG(ERROR) << "Operator is nullptr";
@@ -10,7 +10,10 @@ public:
   explicit Concat(int dim = 0);
 
   InferStatus Forward(const std::vector<sftensor> &inputs,
-                      std::vector<sftensor> &outputs) override;
+                      std::vector<sftensor> &outputs) const override;
+
+  bool InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                  std::vector<uint32_t> &output_shape) const override;
 
   static ParseParamAttrStatus Creator(const srunop &op, skernel &concat);
 
@@ -13,32 +13,345 @@
 
 namespace TinyInfer {
 
+namespace {
+/**
+ * 卷积的后处理：对一个输出通道依次加偏置、加残差并激活，只遍历一次数据
+ * @param out_ptr 输出通道
+ * @param residual_ptr 残差输入的对应通道，为空表示没有残差
+ * @param bias 偏置
+ * @param size 通道内的元素数目
+ */
+template <ActivationType activation>
+void ConvEpilogue(float *out_ptr, const float *residual_ptr, float bias,
+                  uint32_t size) {
+  if (residual_ptr != nullptr) {
+    for (uint32_t i = 0; i < size; ++i) {
+      out_ptr[i] = Activate<activation>(out_ptr[i] + bias + residual_ptr[i]);
+    }
+  } else {
+    for (uint32_t i = 0; i < size; ++i) {
+      out_ptr[i] = Activate<activation>(out_ptr[i] + bias);
+    }
+  }
+}
+
+// Winograd F(4x4, 3x3)：输入6x6的分块变换后与变换后的3x3 kernel逐元素相乘，再还原为4x4的输出
+// 变换矩阵取插值点0, ±1, ±2和无穷远，见Lavin & Gray, Fast Algorithms for Convolutional
+// Neural Networks
+constexpr uint32_t kWinogradTileSize = 36; // 变换后分块内的元素数目，6x6
+
+/**
+ * kernel变换：U = G * g * G^T
+ * @param g 3x3的kernel
+ * @param u 变换后的6x6矩阵
+ */
+void WinogradKernelTransform(const float g[3][3], float u[6][6]) {
+  static const float G[6][3] = {{1.f / 4, 0.f, 0.f},
+                                {-1.f / 6, -1.f / 6, -1.f / 6},
+                                {-1.f / 6, 1.f / 6, -1.f / 6},
+                                {1.f / 24, 1.f / 12, 1.f / 6},
+                                {1.f / 24, -1.f / 12, 1.f / 6},
+                                {0.f, 0.f, 1.f}};
+  float tmp[6][3];
+  for (uint32_t a = 0; a < 6; ++a) {
+    for (uint32_t j = 0; j < 3; ++j) {
+      tmp[a][j] = G[a][0] * g[0][j] + G[a][1] * g[1][j] + G[a][2] * g[2][j];
+    }
+  }
+  for (uint32_t a = 0; a < 6; ++a) {
+    for (uint32_t b = 0; b < 6; ++b) {
+      u[a][b] = tmp[a][0] * G[b][0] + tmp[a][1] * G[b][1] + tmp[a][2] * G[b][2];
+    }
+  }
+}
+
+/**
+ * 输入变换：V = B^T * d * B
+ * @param d 输入中6x6的分块
+ * @param v 变换后的6x6矩阵
+ */
+void WinogradInputTransform(const float d[6][6], float v[6][6]) {
+  // 对一列（或一行）6个元素左乘B^T
+  const auto transform = [](float d0, float d1, float d2, float d3, float d4,
+                            float d5, float *r, uint32_t step) {
+    r[0] = 4.f * d0 - 5.f * d2 + d4;
+    r[step] = -4.f * (d1 + d2) + d3 + d4;
+    r[2 * step] = 4.f * (d1 - d2) - d3 + d4;
+    r[3 * step] = 2.f * (d3 - d1) - d2 + d4;
+    r[4 * step] = 2.f * (d1 - d3) - d2 + d4;
+    r[5 * step] = 4.f * d1 - 5.f * d3 + d5;
+  };
+  float tmp[6][6];
+  for (uint32_t j = 0; j < 6; ++j) {
+    transform(d[0][j], d[1][j], d[2][j], d[3][j], d[4][j], d[5][j], &tmp[0][j],
+              6);
+  }
+  for (uint32_t a = 0; a < 6; ++a) {
+    transform(tmp[a][0], tmp[a][1], tmp[a][2], tmp[a][3], tmp[a][4], tmp[a][5],
+              v[a], 1);
+  }
+}
+
+/**
+ * 输出变换：Y = A^T * m * A
+ * @param m 逐元素相乘并累加后的6x6矩阵
+ * @param y 还原的4x4输出
+ */
+void WinogradOutputTransform(const float m[6][6], float y[4][4]) {
+  // 对一列（或一行）6个元素左乘A^T
+  const auto transform = [](float m0, float m1, float m2, float m3, float m4,
+                            float m5, float *r, uint32_t step) {
+    r[0] = m0 + m1 + m2 + m3 + m4;
+    r[step] = m1 - m2 + 2.f * (m3 - m4);
+    r[2 * step] = m1 + m2 + 4.f * (m3 + m4);
+    r[3 * step] = m1 - m2 + 8.f * (m3 - m4) + m5;
+  };
+  float tmp[4][6];
+  for (uint32_t b = 0; b < 6; ++b) {
+    transform(m[0][b], m[1][b], m[2][b], m[3][b], m[4][b], m[5][b], &tmp[0][b],
+              6);
+  }
+  for (uint32_t p = 0; p < 4; ++p) {
+    transform(tmp[p][0], tmp[p][1], tmp[p][2], tmp[p][3], tmp[p][4], tmp[p][5],
+              y[p], 1);
+  }
+}
+
+/**
+ * 深度卷积的一个通道：直接在输入上滑动kernel，不做im2col
+ * 扩充与计算融合：只把当前通道扩充到线程自己的缓冲区中（通常在缓存中），不扩充整个输入；
+ * 步长为2时缓冲区中每列的偶数行、奇数行分开存放，计算时连续读取
+ * 输出的一列在内存中连续，同一列的各行一起计算，由编译器向量化
+ * @param in 输入通道（未扩充），列主序
+ * @param in_h 输入的行数
+ * @param in_w 输入的列数
+ * @param kernel kernel_size * kernel_size的kernel，列主序
+ * @param pad_h 上下两侧扩充的行数
+ * @param pad_w 左右两侧扩充的列数
+ * @param dilation_h kernel行之间的间隔
+ * @param dilation_w kernel列之间的间隔
+ * @param out 输出通道，列主序
+ * @param out_h 输出的行数
+ * @param out_w 输出的列数
+ */
+template <uint32_t kernel_size, uint32_t stride>
+void DepthwiseChannel(const float *in, uint32_t in_h, uint32_t in_w,
+                      const float *kernel, uint32_t pad_h, uint32_t pad_w,
+                      uint32_t dilation_h, uint32_t dilation_w, float *out,
+                      uint32_t out_h, uint32_t out_w) {
+  float weights[kernel_size * kernel_size];
+  std::copy(kernel, kernel + kernel_size * kernel_size, weights);
+
+  // 扩充后的一列按行号除以步长的余数分为stride段，每段phase_h个元素
+  const uint32_t padded_h = in_h + 2 * pad_h;
+  const uint32_t padded_w = in_w + 2 * pad_w;
+  const uint32_t phase_h = (padded_h + stride - 1) / stride;
+  const uint32_t col_size = phase_h * stride;
+  const float *padded_ptr = in;
+  if (pad_h > 0 || pad_w > 0 || stride > 1) {
+    // 每个线程复用一块缓冲区
+    thread_local std::vector<float> padded;
+    padded.resize(size_t(col_size) * padded_w);
+    // 只需把扩充的行、列置零
+    std::fill(padded.begin(), padded.begin() + size_t(pad_w) * col_size, 0.f);
+    std::fill(padded.begin() + size_t(pad_w + in_w) * col_size, padded.end(),
+              0.f);
+    for (uint32_t c = 0; c < in_w; ++c) {
+      float *padded_col = padded.data() + size_t(c + pad_w) * col_size;
+      const float *in_col = in + size_t(c) * in_h;
+      if (stride == 1) {
+        std::fill(padded_col, padded_col + pad_h, 0.f);
+        std::copy(in_col, in_col + in_h, padded_col + pad_h);
+        std::fill(padded_col + pad_h + in_h, padded_col + col_size, 0.f);
+        continue;
+      }
+      // 扩充后的行q * stride + p保存在第p段的第q个元素，行号在[pad_h, pad_h + in_h)内的来自输入
+      const auto padded_row = [&](uint32_t q, uint32_t p) {
+        const uint32_t r = q * stride + p;
+        return r >= pad_h && r < pad_h + in_h ? in_col[r - pad_h] : 0.f;
+      };
+      // 各段均来自输入的区间[q_begin, q_end)内一次读取连续的stride行，其余逐个判断
+      const uint32_t q_begin = std::min(phase_h, (pad_h + stride - 1) / stride);
+      const uint32_t q_end = std::max(q_begin, (pad_h + in_h) / stride);
+      for (uint32_t q = 0; q < q_begin; ++q) {
+        for (uint32_t p = 0; p < stride; ++p) {
+          padded_col[p * phase_h + q] = padded_row(q, p);
+        }
+      }
+      for (uint32_t q = q_begin; q < q_end; ++q) {
+        const float *in_rows = in_col + (q * stride - pad_h);
+        for (uint32_t p = 0; p < stride; ++p) {
+          padded_col[p * phase_h + q] = in_rows[p];
+        }
+      }
+      for (uint32_t q = q_end; q < phase_h; ++q) {
+        for (uint32_t p = 0; p < stride; ++p) {
+          padded_col[p * phase_h + q] = padded_row(q, p);
+        }
+      }
+    }
+    padded_ptr = padded.data();
+  }
+
+  // kernel第i行对应扩充后的行r * stride + i * dilation_h，在列中的位置为row_offsets[i] + r
+  size_t row_offsets[kernel_size];
+  for (uint32_t i = 0; i < kernel_size; ++i) {
+    row_offsets[i] = (i * dilation_h % stride) * phase_h + i * dilation_h / stride;
+  }
+
+  for (uint32_t c = 0; c < out_w; ++c) {
+    // kernel各列对应的输入列
+    const float *in_cols[kernel_size];
+    for (uint32_t j = 0; j < kernel_size; ++j) {
+      in_cols[j] = padded_ptr + size_t(c * stride + j * dilation_w) * col_size;
+    }
+    float *out_col = out + size_t(c) * out_h;
+#pragma omp simd
+    for (int32_t r = 0; r < int32_t(out_h); ++r) {
+      float sum = 0.f;
+      for (uint32_t j = 0; j < kernel_size; ++j) {
+        for (uint32_t i = 0; i < kernel_size; ++i) {
+          sum += weights[j * kernel_size + i] * (in_cols[j] + row_offsets[i])[r];
+        }
+      }
+      out_col[r] = sum;
+    }
+  }
+}
+
+using DepthwiseFunc = void (*)(const float *, uint32_t, uint32_t, const float *,
+                               uint32_t, uint32_t, uint32_t, uint32_t, float *,
+                               uint32_t, uint32_t);
+} // namespace
+
 Convolution::Convolution(uint32_t out_channels, uint32_t in_channels,
                          uint32_t kernel_h, uint32_t kernel_w,
                          uint32_t padding_h, uint32_t padding_w,
                          uint32_t stride_h, uint32_t stride_w, uint32_t groups,
-                         bool use_bias)
+                         bool use_bias, ActivationType activation,
+                         bool residual, uint32_t dilation_h,
+                         uint32_t dilation_w)
     : AttrKernel("Convolution"), padding_h_(padding_h), padding_w_(padding_w),
-      stride_h_(stride_h), stride_w_(stride_w), groups_(groups),
-      use_bias_(use_bias) {
+      stride_h_(stride_h), stride_w_(stride_w), dilation_h_(dilation_h),
+      dilation_w_(dilation_w), groups_(groups), use_bias_(use_bias),
+      activation_(activation), residual_(residual) {
+  CHECK(dilation_h_ > 0 && dilation_w_ > 0) << "Dilation must greater than 0";
 
   in_channels /= groups_;
+  use_winograd_ = IsWinogradEligible(kernel_h, kernel_w) &&
+                  in_channels >= kWinogradMinChannels;
 
   this->InitWeights(out_channels, in_channels, kernel_h, kernel_w);
 
   if (use_bias_) {
     this->InitBias(out_channels, 1, 1, 1);
   }
+  this->PackWeights();
+}
+
+void Convolution::WeightsUpdated() { this->PackWeights(); }
+
+bool Convolution::IsWinogradEligible(uint32_t kernel_h,
+                                     uint32_t kernel_w) const {
+  return kernel_h == 3 && kernel_w == 3 && stride_h_ == 1 && stride_w_ == 1 &&
+         dilation_h_ == 1 && dilation_w_ == 1 && groups_ == 1;
+}
+
+bool Convolution::IsDepthwiseDirect(uint32_t kernel_c, uint32_t kernel_h,
+                                    uint32_t kernel_w) const {
+  return groups_ > 1 && kernel_c == 1 && kernel_h == kernel_w &&
+         (kernel_h == 3 || kernel_h == 5) && stride_h_ == stride_w_ &&
+         (stride_h_ == 1 || stride_h_ == 2);
+}
+
+void Convolution::set_use_winograd(bool use_winograd) {
+  if (use_winograd) {
+    CHECK(!this->weights_.empty() &&
+          IsWinogradEligible(this->weights_.front()->rows(),
+                             this->weights_.front()->cols()))
+        << "Winograd only supports 3x3 convolutions with stride 1, dilation 1 "
+           "and groups 1";
+  }
+  use_winograd_ = use_winograd;
+  this->PackWeights();
+}
+
+bool Convolution::use_winograd() const { return use_winograd_; }
+
+void Convolution::PackWeights() {
+  packed_weights_.clear();
+  winograd_weights_.reset();
+  const uint32_t kernel_ct = this->weights_.size();
+  if (kernel_ct == 0 || kernel_ct % groups_ != 0) {
+    return;
+  }
+  const uint32_t gkernel_ct = kernel_ct / groups_;
+  const uint32_t kernel_size = this->weights_.front()->size();
+  for (const auto &kernel : this->weights_) {
+    // kernel的维度不一致时在Forward中报错
+    if (kernel == nullptr || kernel->size() != kernel_size) {
+      return;
+    }
+  }
+
+  // ! 预留空间，避免扩容时复制矩阵（使用权重内存的矩阵会被复制为新的内存）
+  packed_weights_.reserve(groups_);
+  for (uint32_t g = 0; g < groups_; ++g) {
+    const float *base = this->weights_.at(g * gkernel_ct)->raw_ptr();
+    bool contiguous = true;
+    for (uint32_t k = 1; k < gkernel_ct && contiguous; ++k) {
+      contiguous = this->weights_.at(g * gkernel_ct + k)->raw_ptr() ==
+                   base + size_t(k) * kernel_size;
+    }
+    if (contiguous) {
+      packed_weights_.emplace_back(const_cast<float *>(base), kernel_size,
+                                   gkernel_ct, false, true);
+    } else {
+      arma::fmat &packed = packed_weights_.emplace_back(kernel_size, gkernel_ct);
+      for (uint32_t k = 0; k < gkernel_ct; ++k) {
+        const auto &kernel = this->weights_.at(g * gkernel_ct + k);
+        std::copy(kernel->raw_ptr(), kernel->raw_ptr() + kernel_size,
+                  packed.colptr(k));
+      }
+    }
+  }
+
+  // 预先变换Winograd所用的kernel，第xi个切片为各kernel变换后的第xi个元素[kernel_c, kernel_ct]
+  const auto &front = this->weights_.front();
+  if (!use_winograd_ || front->rows() != 3 || front->cols() != 3) {
+    return;
+  }
+  const uint32_t kernel_c = front->channels();
+  winograd_weights_.set_size(kernel_c, kernel_ct, kWinogradTileSize);
+#pragma omp parallel for
+  for (uint32_t k = 0; k < kernel_ct; ++k) {
+    const auto &kernel = this->weights_.at(k);
+    float g[3][3];
+    float u[6][6];
+    for (uint32_t c = 0; c < kernel_c; ++c) {
+      for (uint32_t i = 0; i < 3; ++i) {
+        for (uint32_t j = 0; j < 3; ++j) {
+          g[i][j] = kernel->at(c, i, j);
+        }
+      }
+      WinogradKernelTransform(g, u);
+      for (uint32_t xi = 0; xi < kWinogradTileSize; ++xi) {
+        winograd_weights_.at(c, k, xi) = u[xi / 6][xi % 6];
+      }
+    }
+  }
 }
 
 InferStatus Convolution::Forward(const std::vector<sftensor> &inputs,
-                                 std::vector<sftensor> &outputs) {
+                                 std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "Input tensor array empty";
     return InferStatus::InferFailedInputEmpty;
   }
 
-  if (inputs.size() != outputs.size()) {
+  // ! 融合了残差相加时，inputs按顺序保存卷积输入和残差输入：[input1,...,residual1,...]
+  const uint32_t in_packet = residual_ ? 2 : 1;
+  if (inputs.size() != outputs.size() * in_packet) {
     LOG(ERROR) << "Input and output tensor array batch do not match";
     return InferStatus::InferFailedBatchMatchError;
   }
@@ -74,60 +387,37 @@ InferStatus Convolution::Forward(const std::vector<sftensor> &inputs,
     }
   }
 
-  const uint32_t gkernel_ct = kernel_ct / groups_; // 每组的kernel数目
-  const uint32_t plane = kernel_h * kernel_w; // kernel单个通道内的元素数
-
-  std::vector<std::shared_ptr<arma::frowvec>> kernel_rows(
-      kernel_ct); // 保存单分组下所有展平的kernels
-  std::vector<std::vector<std::shared_ptr<arma::frowvec>>> gkernel_rows_vec(
-      groups_, // 保存多分组下所有展平的kernels
-      std::vector<std::shared_ptr<arma::frowvec>>(gkernel_ct));
-
-  // 展平kernels
-  // 单分组
-  if (groups_ == 1) {
-    for (uint32_t k = 0; k < kernel_ct; ++k) {
-      const auto &kernel = this->weights_.at(k);
-      // ! 直接复用kernel的内存，不必开辟新空间保存展平后的kernel
-      kernel_rows.at(k) = std::make_shared<arma::frowvec>(
-          const_cast<float *>(kernel->raw_ptr()), kernel_c * plane, false,
-          true);
-    }
-  }
-  // 多分组
-  else {
-    for (uint32_t g = 0; g < groups_; ++g) {
-      std::vector<std::shared_ptr<arma::frowvec>> gkernel_rows(
-          gkernel_ct); // 保存一个分组内展平的kernels
-      for (uint32_t k = 0; k < gkernel_ct; ++k) {
-        const auto &kernel = this->weights_.at(g * gkernel_ct + k);
-        gkernel_rows.at(k) = std::make_shared<arma::frowvec>(
-            const_cast<float *>(kernel->raw_ptr()), kernel_c * plane, false,
-            true);
-      }
-      gkernel_rows_vec.at(g) = std::move(gkernel_rows);
-    }
+  CHECK(packed_weights_.size() == groups_ &&
+        packed_weights_.front().n_rows == kernel_c * kernel_h * kernel_w)
+      << "Packed weights do not match the kernels";
+  if (use_winograd_) {
+    CHECK(kernel_h == 3 && kernel_w == 3 && winograd_weights_.n_rows == kernel_c &&
+          winograd_weights_.n_cols == kernel_ct)
+        << "Winograd weights do not match the kernels";
   }
 
-  const uint32_t batch = inputs.size();
+  // kernel在特征图上覆盖的范围，kernel元素之间间隔dilation
+  const uint32_t extent_h = dilation_h_ * (kernel_h - 1) + 1;
+  const uint32_t extent_w = dilation_w_ * (kernel_w - 1) + 1;
+
+  const bool depthwise = IsDepthwiseDirect(kernel_c, kernel_h, kernel_w);
+  const uint32_t batch = outputs.size();
 
 #pragma omp parallel for num_threads(batch)
   for (uint32_t b = 0; b < batch; ++b) {
     const auto &input = inputs.at(b);
     CHECK(input != nullptr && !input->empty()) << b << " input tensor empty";
 
-    // 扩充输入特征图
-    sftensor input_;
-    if (padding_h_ > 0 || padding_w_ > 0) {
+    // 扩充输入特征图，深度卷积在计算时处理扩充的部分，不实际扩充
+    sftensor input_ = input;
+    if ((padding_h_ > 0 || padding_w_ > 0) && !depthwise) {
       input_ =
           Pad(input, {padding_h_, padding_h_, padding_w_, padding_w_}, 0.f);
-    } else {
-      input_ = input;
     }
 
-    const uint32_t input_c = input_->channels();
-    const uint32_t input_w = input_->cols();
-    const uint32_t input_h = input_->rows();
+    const uint32_t input_c = input->channels();
+    const uint32_t input_w = input->cols() + 2 * padding_w_; // 扩充后的列数
+    const uint32_t input_h = input->rows() + 2 * padding_h_; // 扩充后的行数
     CHECK(input_c % groups_ == 0) << b << " input tensor channel error";
 
     uint32_t ginput_c = input_c / groups_; // 每组的特征图通道数
@@ -136,10 +426,12 @@ InferStatus Convolution::Forward(const std::vector<sftensor> &inputs,
     CHECK(ginput_c == kernel_c)
         << b << " input tensor grouped channel not equal to kernel channel";
 
+    CHECK(input_h >= extent_h && input_w >= extent_w)
+        << b << " output shape error";
     const uint32_t output_h =
-        uint32_t(std::floor((input_h - kernel_h) / stride_h_ + 1));
+        uint32_t(std::floor((input_h - extent_h) / stride_h_ + 1));
     const uint32_t output_w =
-        uint32_t(std::floor((input_w - kernel_w) / stride_w_ + 1));
+        uint32_t(std::floor((input_w - extent_w) / stride_w_ + 1));
     CHECK(output_h > 0 && output_w > 0) << b << " output shape error";
 
     auto &output = outputs.at(b);
@@ -151,56 +443,300 @@ InferStatus Convolution::Forward(const std::vector<sftensor> &inputs,
           output->cols() == output_w)
         << b << " output tensor shape error";
 
-    uint32_t out_plane = output_h * output_w; // 输出特征图单个通道内元素数目
-
-    // 分组进行im2col和gemm
-    for (uint32_t g = 0; g < groups_; ++g) {
-      // 展平该组内的特征图通道
-      arma::fmat in_mat(ginput_c * plane, out_plane); // 保存im2col后的特征图
-      for (uint32_t ic = 0; ic < ginput_c; ++ic) {
-        const auto &in_channel =
-            input_->slice(g * ginput_c + ic); // 特征图单个通道
-        int in_mat_c_idx = 0;                 // in_mat的列号
-        // 自左而右、自上而下滑动
-        for (uint32_t w = 0; w < input_w - kernel_w + 1; w += stride_w_) {
-          for (uint32_t r = 0; r < input_h - kernel_h + 1; r += stride_h_) {
-            float *in_mat_c_ptr =
-                in_mat.colptr(in_mat_c_idx) + ic * plane; // in_mat的列指针
-            in_mat_c_idx += 1;
-            // 按列展平一个kernel窗口内的元素
-            for (uint32_t kw = 0; kw < kernel_w; ++kw) {
-              const float *window_ptr =
-                  in_channel.colptr(w + kw) + r; // 窗口内的列指针
-              memcpy(in_mat_c_ptr, window_ptr, kernel_h * sizeof(float));
-              in_mat_c_ptr += kernel_h;
+    sftensor residual;
+    if (residual_) {
+      residual = inputs.at(batch + b);
+      CHECK(residual != nullptr && residual->channels() == kernel_ct &&
+            residual->rows() == output_h && residual->cols() == output_w)
+          << b << " residual tensor shape error";
+    }
+
+    if (depthwise) {
+      ConvDepthwise(input_, output);
+    } else if (use_winograd_) {
+      ConvWinograd(input_, output);
+    } else if (kernel_h == 1 && kernel_w == 1) {
+      ConvPointwise(input_, output);
+    } else {
+      ConvIm2col(input_, output);
+    }
+    ApplyEpilogue(output, residual);
+  }
+
+  return InferStatus::InferSuccess;
+}
+
+void Convolution::ConvIm2col(const sftensor &input,
+                             const sftensor &output) const {
+  const uint32_t kernel_ct = this->weights_.size();
+  const uint32_t gkernel_ct = kernel_ct / groups_; // 每组的kernel数目
+  const uint32_t kernel_h = this->weights_.front()->rows();
+  const uint32_t kernel_w = this->weights_.front()->cols();
+  const uint32_t plane = kernel_h * kernel_w; // kernel单个通道内的元素数
+  const uint32_t ginput_c = input->channels() / groups_; // 每组的特征图通道数
+  const uint32_t output_h = output->rows();
+  const uint32_t output_w = output->cols();
+  const uint32_t out_plane = output_h * output_w; // 输出特征图单个通道内元素数目
+
+  // 分组进行im2col和gemm
+  for (uint32_t g = 0; g < groups_; ++g) {
+    // 展平该组内的特征图通道，每行为一个kernel窗口，每列为窗口内的同一位置
+    // 这样一组的输出[out_plane, gkernel_ct]恰好是连续存放的gkernel_ct个输出通道
+    arma::fmat in_mat(out_plane, ginput_c * plane); // 保存im2col后的特征图
+#pragma omp parallel for
+    for (uint32_t ic = 0; ic < ginput_c; ++ic) {
+      const auto &in_channel = input->slice(g * ginput_c + ic); // 特征图单个通道
+      // 按列展平一个kernel窗口内的元素，窗口自左而右、自上而下滑动
+      for (uint32_t kw = 0; kw < kernel_w; ++kw) {
+        for (uint32_t kh = 0; kh < kernel_h; ++kh) {
+          float *in_mat_c_ptr =
+              in_mat.colptr(ic * plane + kw * kernel_h + kh); // in_mat的列指针
+          for (uint32_t w = 0; w < output_w; ++w) {
+            const float *window_ptr =
+                in_channel.colptr(w * stride_w_ + kw * dilation_w_) +
+                kh * dilation_h_; // 各窗口在该列的起始位置
+            if (stride_h_ == 1) {
+              memcpy(in_mat_c_ptr, window_ptr, output_h * sizeof(float));
+            } else {
+              for (uint32_t r = 0; r < output_h; ++r) {
+                in_mat_c_ptr[r] = window_ptr[r * stride_h_];
+              }
             }
+            in_mat_c_ptr += output_h;
           }
         }
       }
+    }
 
-      // 执行该组的矩阵乘法
-#pragma omp parallel for schedule(dynamic)
-      for (uint32_t k = 0; k < gkernel_ct; ++k) {
-        arma::fmat out_channel(output->slice(g * gkernel_ct + k).memptr(),
-                               output_h, output_w, false, true);
+    // 执行该组的矩阵乘法，结果直接写入输出特征图
+    arma::fmat out_mat(output->slice(g * gkernel_ct).memptr(), out_plane,
+                       gkernel_ct, false, true);
+    out_mat = in_mat * packed_weights_.at(g);
+  }
+}
+
+void Convolution::ConvPointwise(const sftensor &input,
+                                const sftensor &output) const {
+  const uint32_t kernel_ct = this->weights_.size();
+  const uint32_t gkernel_ct = kernel_ct / groups_; // 每组的kernel数目
+  const uint32_t ginput_c = input->channels() / groups_; // 每组的特征图通道数
+  const uint32_t output_h = output->rows();
+  const uint32_t output_w = output->cols();
+  const uint32_t out_plane = output_h * output_w; // 输出特征图单个通道内元素数目
+
+  for (uint32_t g = 0; g < groups_; ++g) {
+    arma::fmat out_mat(output->slice(g * gkernel_ct).memptr(), out_plane,
+                       gkernel_ct, false, true);
+    // ! 步长为1时，该组连续存放的输入通道本身就是[out_plane, ginput_c]的矩阵，直接使用
+    if (stride_h_ == 1 && stride_w_ == 1) {
+      const arma::fmat in_mat(
+          const_cast<float *>(input->slice(g * ginput_c).memptr()), out_plane,
+          ginput_c, false, true);
+      out_mat = in_mat * packed_weights_.at(g);
+      continue;
+    }
+
+    // 步长大于1时按步长抽取输入的元素
+    arma::fmat in_mat(out_plane, ginput_c, arma::fill::none);
+#pragma omp parallel for
+    for (uint32_t ic = 0; ic < ginput_c; ++ic) {
+      const arma::fmat &in_channel = input->slice(g * ginput_c + ic);
+      float *in_mat_c_ptr = in_mat.colptr(ic);
+      for (uint32_t w = 0; w < output_w; ++w) {
+        const float *col_ptr = in_channel.colptr(w * stride_w_);
+        for (uint32_t r = 0; r < output_h; ++r) {
+          in_mat_c_ptr[r] = col_ptr[r * stride_h_];
+        }
+        in_mat_c_ptr += output_h;
+      }
+    }
+    out_mat = in_mat * packed_weights_.at(g);
+  }
+}
+
+void Convolution::ConvDepthwise(const sftensor &input,
+                                const sftensor &output) const {
+  const uint32_t kernel_ct = output->channels();
+  const uint32_t multiplier = kernel_ct / groups_; // 每个输入通道对应的kernel数目
+  const uint32_t kernel_size = this->weights_.front()->rows();
+  DepthwiseFunc channel_func = nullptr;
+  if (kernel_size == 3) {
+    channel_func = stride_h_ == 1 ? DepthwiseChannel<3, 1> : DepthwiseChannel<3, 2>;
+  } else {
+    channel_func = stride_h_ == 1 ? DepthwiseChannel<5, 1> : DepthwiseChannel<5, 2>;
+  }
+
+#pragma omp parallel for
+  for (uint32_t k = 0; k < kernel_ct; ++k) {
+    const uint32_t g = k / multiplier;
+    channel_func(input->slice(g).memptr(), input->rows(), input->cols(),
+                 packed_weights_.at(g).colptr(k % multiplier), padding_h_,
+                 padding_w_, dilation_h_, dilation_w_,
+                 output->slice(k).memptr(), output->rows(), output->cols());
+  }
+}
 
-        if (groups_ == 1) {
-          out_channel = *kernel_rows.at(k) * in_mat;
+void Convolution::ConvWinograd(const sftensor &input,
+                               const sftensor &output) const {
+  const uint32_t input_c = input->channels();
+  const uint32_t input_h = input->rows();
+  const uint32_t input_w = input->cols();
+  const uint32_t kernel_ct = output->channels();
+  const uint32_t output_h = output->rows();
+  const uint32_t output_w = output->cols();
+  // 输出按4x4分块，每块对应输入中6x6的区域，超出边界的部分补零
+  const uint32_t tiles_h = (output_h + 3) / 4;
+  const uint32_t tiles_w = (output_w + 3) / 4;
+  const uint32_t tile_ct = tiles_h * tiles_w;
+
+  // 输入变换：第xi个切片保存各分块、各输入通道变换后的第xi个元素
+  arma::fcube in_cube(tile_ct, input_c, kWinogradTileSize, arma::fill::none);
+#pragma omp parallel for
+  for (uint32_t c = 0; c < input_c; ++c) {
+    const arma::fmat &in_channel = input->slice(c);
+    float tile[6][6];
+    float transformed[6][6];
+    for (uint32_t tc = 0; tc < tiles_w; ++tc) {
+      for (uint32_t tr = 0; tr < tiles_h; ++tr) {
+        const uint32_t row = tr * 4;
+        const uint32_t col = tc * 4;
+        if (row + 6 <= input_h && col + 6 <= input_w) {
+          for (uint32_t j = 0; j < 6; ++j) {
+            const float *col_ptr = in_channel.colptr(col + j) + row;
+            for (uint32_t i = 0; i < 6; ++i) {
+              tile[i][j] = col_ptr[i];
+            }
+          }
         } else {
-          out_channel = *gkernel_rows_vec.at(g).at(k) * in_mat;
+          for (uint32_t j = 0; j < 6; ++j) {
+            for (uint32_t i = 0; i < 6; ++i) {
+              tile[i][j] = (row + i < input_h && col + j < input_w)
+                               ? in_channel.at(row + i, col + j)
+                               : 0.f;
+            }
+          }
+        }
+        WinogradInputTransform(tile, transformed);
+        const uint32_t t = tc * tiles_h + tr;
+        for (uint32_t xi = 0; xi < kWinogradTileSize; ++xi) {
+          in_cube.at(t, c, xi) = transformed[xi / 6][xi % 6];
         }
-        CHECK(out_channel.size() == out_plane);
+      }
+    }
+  }
+
+  // 逐元素相乘并在输入通道上累加，对每个元素位置即一次矩阵乘法
+  arma::fcube out_cube(tile_ct, kernel_ct, kWinogradTileSize, arma::fill::none);
+  for (uint32_t xi = 0; xi < kWinogradTileSize; ++xi) {
+    out_cube.slice(xi) = in_cube.slice(xi) * winograd_weights_.slice(xi);
+  }
 
-        // 加上偏置
-        if (this->use_bias_) {
-          const auto &bias = this->bias_.at(g * gkernel_ct + k);
-          out_channel += bias->index(0);
+  // 输出变换：每块还原为4x4的输出，只写入输出特征图范围内的部分
+#pragma omp parallel for
+  for (uint32_t k = 0; k < kernel_ct; ++k) {
+    arma::fmat &out_channel = output->slice(k);
+    float transformed[6][6];
+    float tile[4][4];
+    for (uint32_t tc = 0; tc < tiles_w; ++tc) {
+      for (uint32_t tr = 0; tr < tiles_h; ++tr) {
+        const uint32_t t = tc * tiles_h + tr;
+        for (uint32_t xi = 0; xi < kWinogradTileSize; ++xi) {
+          transformed[xi / 6][xi % 6] = out_cube.at(t, k, xi);
+        }
+        WinogradOutputTransform(transformed, tile);
+        const uint32_t row = tr * 4;
+        const uint32_t col = tc * 4;
+        const uint32_t rows = std::min(4u, output_h - row);
+        const uint32_t cols = std::min(4u, output_w - col);
+        for (uint32_t j = 0; j < cols; ++j) {
+          float *col_ptr = out_channel.colptr(col + j) + row;
+          for (uint32_t i = 0; i < rows; ++i) {
+            col_ptr[i] = tile[i][j];
+          }
         }
       }
     }
   }
+}
 
-  return InferStatus::InferSuccess;
+void Convolution::ApplyEpilogue(const sftensor &output,
+                                const sftensor &residual) const {
+  const uint32_t kernel_ct = output->channels();
+  const uint32_t out_plane = output->rows() * output->cols();
+  // 加上偏置，再加上残差并激活
+#pragma omp parallel for
+  for (uint32_t out_c = 0; out_c < kernel_ct; ++out_c) {
+    float *out_ptr = output->slice(out_c).memptr();
+    const float bias = this->use_bias_ ? this->bias_.at(out_c)->index(0) : 0.f;
+    const float *residual_ptr =
+        residual != nullptr ? residual->slice(out_c).memptr() : nullptr;
+    if (activation_ == ActivationType::ActivationNone &&
+        residual_ptr == nullptr) {
+      if (this->use_bias_) {
+        output->slice(out_c) += bias;
+      }
+    } else if (activation_ == ActivationType::ActivationRelu) {
+      ConvEpilogue<ActivationType::ActivationRelu>(out_ptr, residual_ptr, bias,
+                                                   out_plane);
+    } else if (activation_ == ActivationType::ActivationHardSwish) {
+      ConvEpilogue<ActivationType::ActivationHardSwish>(out_ptr, residual_ptr,
+                                                        bias, out_plane);
+    } else {
+      ConvEpilogue<ActivationType::ActivationNone>(out_ptr, residual_ptr, bias,
+                                                   out_plane);
+    }
+  }
+}
+
+bool Convolution::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                             std::vector<uint32_t> &output_shape) const {
+  const uint32_t in_packet = residual_ ? 2 : 1;
+  if (input_shapes.size() != in_packet || input_shapes.front().size() != 3) {
+    LOG(ERROR) << "The input shape of Convolution is wrong";
+    return false;
+  }
+  CHECK(!this->weights_.empty()) << "Weight count must greater than 0";
+  const sftensor &kernel = this->weights_.front();
+  const uint32_t kernel_ct = this->weights_.size();
+  const uint32_t kernel_c = kernel->channels();
+  const uint32_t kernel_h = kernel->rows();
+  const uint32_t kernel_w = kernel->cols();
+
+  const uint32_t extent_h = dilation_h_ * (kernel_h - 1) + 1;
+  const uint32_t extent_w = dilation_w_ * (kernel_w - 1) + 1;
+
+  const auto &in_shape = input_shapes.front();
+  const uint32_t input_h = in_shape.at(1) + 2 * padding_h_;
+  const uint32_t input_w = in_shape.at(2) + 2 * padding_w_;
+  if (in_shape.at(0) != kernel_c * groups_ || input_h < extent_h ||
+      input_w < extent_w) {
+    LOG(ERROR) << "The input shape of Convolution is wrong";
+    return false;
+  }
+
+  output_shape = {kernel_ct, (input_h - extent_h) / stride_h_ + 1,
+                  (input_w - extent_w) / stride_w_ + 1};
+  // 残差与卷积输出逐元素相加，维度须相同
+  if (residual_ && input_shapes.back() != output_shape) {
+    LOG(ERROR) << "The residual shape of Convolution is wrong";
+    return false;
+  }
+  return true;
+}
+
+uint64_t Convolution::Flops(const std::vector<std::vector<uint32_t>> &input_shapes,
+                            const std::vector<uint32_t> &output_shape) const {
+  // 每个输出元素做一次长度为kernel_c * kernel_h * kernel_w的乘加，再加上偏置、残差和激活
+  CHECK(!this->weights_.empty()) << "Weight count must greater than 0";
+  const sftensor &kernel = this->weights_.front();
+  const uint64_t out_elem =
+      uint64_t(output_shape.at(0)) * output_shape.at(1) * output_shape.at(2);
+  const uint64_t window = uint64_t(kernel->channels()) * kernel->rows() *
+                          kernel->cols();
+  uint64_t epilogue = use_bias_ ? 1 : 0;
+  epilogue += residual_ ? 1 : 0;
+  epilogue += activation_ != ActivationType::ActivationNone ? 1 : 0;
+  return out_elem * (2 * window + epilogue);
 }
 
 ParseParamAttrStatus Convolution::Creator(const srunop &op,
@@ -288,8 +824,10 @@ ParseParamAttrStatus Convolution::Creator(const srunop &op,
     return ParseParamAttrStatus::ParamMissingDilation;
   }
 
-  CHECK(dilation->value.at(0) != 1 || dilation->value.at(1))
-      << "Unsupported dilation value";
+  if (dilation->value.at(0) < 1 || dilation->value.at(1) < 1) {
+    LOG(ERROR) << "Dilation parameter must be greater than 0";
+    return ParseParamAttrStatus::ParamMissingDilation;
+  }
 
   if (params.find("bias") == params.end()) {
     LOG(ERROR) << "Bias parameter missing";
@@ -322,11 +860,28 @@ ParseParamAttrStatus Convolution::Creator(const srunop &op,
 
   CHECK(stride_val.size() == dims) << "Stride parameter size error";
 
+  // 计算图融合了后续的激活节点时，参数中记录了激活节点的类型
+  ActivationType activation = ActivationType::ActivationNone;
+  if (params.find("fused_activation") != params.end()) {
+    const auto &fused_activation =
+        dynamic_cast<RuntimeParamStr *>(params.at("fused_activation"));
+    if (!fused_activation ||
+        !ParseActivationType(fused_activation->value, activation)) {
+      LOG(ERROR) << "Fused activation parameter unsupported";
+      return ParseParamAttrStatus::ParamUnsupportedActivation;
+    }
+  }
+
+  // 计算图融合了后续的残差相加时，节点有第二个来源的输入
+  const bool residual = op->in_oprands_seq.size() == 2;
+
   // 创建convolution kernel
-  convolution = std::make_shared<Convolution>(
+  auto conv_kernel = std::make_shared<Convolution>(
       out_channels->value, in_channels->value, kernel_size_val.at(0),
       kernel_size_val.at(1), padding_val.at(0), padding_val.at(1),
-      stride_val.at(0), stride_val.at(1), groups->value, bias->value);
+      stride_val.at(0), stride_val.at(1), groups->value, bias->value,
+      activation, residual, dilation->value.at(0), dilation->value.at(1));
+  convolution = conv_kernel;
 
   // 加载权重
   const auto &attrs = op->attrs;
@@ -337,9 +892,7 @@ ParseParamAttrStatus Convolution::Creator(const srunop &op,
   }
   const auto &weight = attrs.at("weight");
   CHECK(!weight->shape.empty()) << "Weight attribute shape error";
-
-  const std::vector<float> &weight_vals = weight->get<float>();
-  convolution->set_weights(weight_vals);
+  conv_kernel->LoadWeights(*weight);
 
   // 加载偏置
   if (bias->value) {
@@ -351,8 +904,7 @@ ParseParamAttrStatus Convolution::Creator(const srunop &op,
     CHECK(!bias->shape.empty() && bias->shape.at(0) == out_channels->value)
         << "Bias attribute shape error";
 
-    const std::vector<float> &bias_vals = bias->get<float>();
-    convolution->set_bias(bias_vals);
+    conv_kernel->LoadBias(*bias);
   }
 
   return ParseParamAttrStatus::ParamAttrParseSuccess;
@@ -1,8 +1,10 @@
 #ifndef TINY_INFER_SOURCE_KERNEL_CONVOLUTION_HPP_
 #define TINY_INFER_SOURCE_KERNEL_CONVOLUTION_HPP_
 
+#include "activation.hpp"
 #include "kernel/abstract/attr_kernel.hpp"
 #include <cstdint>
+#include <vector>
 
 namespace TinyInfer {
 
@@ -12,20 +14,87 @@ public:
                        uint32_t kernel_h, uint32_t kernel_w,
                        uint32_t padding_h = 0, uint32_t padding_w = 0,
                        uint32_t stride_h = 1, uint32_t stride_w = 1,
-                       uint32_t groups = 1, bool use_bias = false);
+                       uint32_t groups = 1, bool use_bias = false,
+                       ActivationType activation = ActivationType::ActivationNone,
+                       bool residual = false, uint32_t dilation_h = 1,
+                       uint32_t dilation_w = 1);
 
   InferStatus Forward(const std::vector<sftensor> &inputs,
-                      std::vector<sftensor> &outputs) override;
+                      std::vector<sftensor> &outputs) const override;
+
+  bool InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                  std::vector<uint32_t> &output_shape) const override;
+
+  uint64_t Flops(const std::vector<std::vector<uint32_t>> &input_shapes,
+                 const std::vector<uint32_t> &output_shape) const override;
 
   static ParseParamAttrStatus Creator(const srunop &op, skernel &convolution);
 
+  /**
+   * 设置是否使用Winograd F(4x4, 3x3)计算，开启时预先变换kernel
+   * 构造时对3x3、步长为1、不膨胀、不分组且输入通道数不少于kWinogradMinChannels的卷积自动开启，
+   * 其余卷积使用im2col和gemm计算
+   * 与im2col路径相比，Winograd的变换会放大舍入误差：输入和kernel取标准正态分布时，
+   * 输出的绝对误差不超过kWinogradTolerance * sqrt(kernel_c * 9)
+   * @param use_winograd 是否使用Winograd，开启时须为3x3、步长为1、不膨胀且不分组的卷积
+   */
+  void set_use_winograd(bool use_winograd);
+
+  /**
+   * 返回是否使用Winograd计算
+   */
+  bool use_winograd() const;
+
+  // 自动开启Winograd所需的最少输入通道数，通道数较少时变换的开销大于节省的乘法
+  static constexpr uint32_t kWinogradMinChannels = 16;
+  // Winograd与im2col路径输出的误差上限系数，见set_use_winograd
+  static constexpr float kWinogradTolerance = 5e-5f;
+
+protected:
+  void WeightsUpdated() override;
+
 private:
+  /**
+   * 把权重整理为每组一个[kernel_c * kernel_h * kernel_w, 分组的kernel数目]的矩阵
+   * 一组的kernel在内存中连续存放时矩阵直接使用权重的内存，否则复制一份
+   */
+  void PackWeights();
+
+  // 是否可以使用Winograd计算
+  bool IsWinogradEligible(uint32_t kernel_h, uint32_t kernel_w) const;
+
+  // 是否使用直接计算的深度卷积：每组一个输入通道，3x3或5x5的kernel，步长同为1或2
+  bool IsDepthwiseDirect(uint32_t kernel_c, uint32_t kernel_h,
+                         uint32_t kernel_w) const;
+
+  // 直接计算一个输入（未扩充）的深度卷积，各输出通道并行计算
+  void ConvDepthwise(const sftensor &input, const sftensor &output) const;
+
+  // 使用im2col和gemm计算一个输入（已扩充）的卷积
+  void ConvIm2col(const sftensor &input, const sftensor &output) const;
+
+  // 计算一个输入（已扩充）的1x1卷积，不做im2col，步长为1时直接使用输入的内存
+  void ConvPointwise(const sftensor &input, const sftensor &output) const;
+
+  // 使用Winograd F(4x4, 3x3)计算一个输入（已扩充）的卷积
+  void ConvWinograd(const sftensor &input, const sftensor &output) const;
+
+  // 对输出依次加偏置、加残差并激活，residual为空表示没有残差
+  void ApplyEpilogue(const sftensor &output, const sftensor &residual) const;
+
   uint32_t padding_h_;
   uint32_t padding_w_;
   uint32_t stride_h_;
   uint32_t stride_w_;
+  uint32_t dilation_h_; // kernel行之间的间隔，为1时即普通卷积
+  uint32_t dilation_w_; // kernel列之间的间隔
   uint32_t groups_; // 分组卷积的组数
   bool use_bias_;
+  ActivationType activation_; // 融合的激活函数
+  bool residual_; // 是否融合了残差相加，此时输入为[卷积输入..., 残差输入...]
+  bool use_winograd_ = false; // 是否使用Winograd计算
+  std::vector<arma::fmat> packed_weights_; // 每组展平后的kernels，每列为一个kernel
+  arma::fcube winograd_weights_; // Winograd变换后的kernels，每个切片为[kernel_c, kernel_ct]
 };
 
 } // namespace TinyInfer
@@ -11,10 +11,15 @@ namespace TinyInfer {
 
 Expression::Expression(std::string statement)
     : NoAttrKernel("Expression"),
-      parser_(std::make_unique<ExprParser>(std::move(statement))) {}
+      parser_(std::make_unique<ExprParser>(std::move(statement))) {
+  // 表达式在推理过程中不会改变，构造时完成词法和语法分析，Forward只读取逆波兰式
+  this->parser_->Tokenize(false);
+  CHECK(!this->parser_->Tokens().empty()) << "Tokenize failed";
+  this->token_nodes_ = this->parser_->Generate();
+}
 
 InferStatus Expression::Forward(const std::vector<sftensor> &inputs,
-                                std::vector<sftensor> &outputs) {
+                                std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -51,14 +56,9 @@ InferStatus Expression::Forward(const std::vector<sftensor> &inputs,
     output->Fill(0.f);
   }
 
-  // 词法分析
-  CHECK(this->parser_ != nullptr) << "The parser is empty";
-  this->parser_->Tokenize(false);
-  const auto &tokens = this->parser_->Tokens();
-  CHECK(!tokens.empty()) << "Tokenize failed";
-
-  std::stack<std::vector<sftensor>> stk;               // 运算数栈
-  const auto &token_nodes = this->parser_->Generate(); // 获取逆波兰式
+  std::stack<std::vector<sftensor>> stk;          // 运算数栈
+  const auto &token_nodes = this->token_nodes_; // 逆波兰式
+  CHECK(!token_nodes.empty()) << "The expression is empty";
   // 依据逆波兰式执行表达式
   for (const auto &token_node : token_nodes) {
     // 运算数入栈
@@ -113,12 +113,79 @@ InferStatus Expression::Forward(const std::vector<sftensor> &inputs,
   for (int b = 0; b < batch; ++b) {
     auto &output = outputs.at(b);
     CHECK(output->shape() == output_node.at(b)->shape());
-    output = output_node.at(b);
+    // 拷贝到已有的输出Tensor中，输出Tensor可能位于计算图规划好的内存中
+    output->set_data(output_node.at(b)->data());
   }
 
   return InferStatus::InferSuccess;
 }
 
+bool Expression::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                            std::vector<uint32_t> &output_shape) const {
+  for (const auto &shape : input_shapes) {
+    if (shape.size() != 3) {
+      LOG(ERROR) << "The input shape of Expression is wrong";
+      return false;
+    }
+  }
+
+  // 按逆波兰式模拟一遍计算，二元运算的结果维度遵循ElemAdd和ElemMul的广播规则
+  std::stack<std::vector<uint32_t>> stk;
+  for (const auto &token_node : this->token_nodes_) {
+    if (token_node->num >= 0) {
+      if (token_node->num >= int(input_shapes.size())) {
+        LOG(ERROR) << "The input count of Expression is wrong";
+        return false;
+      }
+      stk.push(input_shapes.at(token_node->num));
+      continue;
+    }
+
+    if (stk.size() < 2) {
+      LOG(ERROR) << "The number of operand is less than two";
+      return false;
+    }
+    const auto shape2 = stk.top();
+    stk.pop();
+    const auto shape1 = stk.top();
+    stk.pop();
+
+    if (shape1 == shape2) {
+      stk.push(shape1);
+    } else if (shape1.at(0) == shape2.at(0) && shape2.at(1) == 1 &&
+               shape2.at(2) == 1) {
+      stk.push(shape1);
+    } else if (shape1.at(0) == shape2.at(0) && shape1.at(1) == 1 &&
+               shape1.at(2) == 1) {
+      stk.push(shape2);
+    } else {
+      LOG(ERROR) << "Tensors shape are not adapting";
+      return false;
+    }
+  }
+
+  if (stk.size() != 1) {
+    LOG(ERROR) << "The expression is wrong";
+    return false;
+  }
+  output_shape = stk.top();
+  return true;
+}
+
+uint64_t Expression::Flops(const std::vector<std::vector<uint32_t>> &input_shapes,
+                           const std::vector<uint32_t> &output_shape) const {
+  // 每个二元运算对每个输出元素做一次运算
+  uint64_t op_ct = 0;
+  for (const auto &token_node : this->token_nodes_) {
+    if (token_node->num < 0) {
+      op_ct += 1;
+    }
+  }
+  const uint64_t out_elem =
+      uint64_t(output_shape.at(0)) * output_shape.at(1) * output_shape.at(2);
+  return out_elem * op_ct;
+}
+
 ParseParamAttrStatus Expression::Creator(const srunop &op,
                                          skernel &expression) {
 
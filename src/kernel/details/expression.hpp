@@ -11,12 +11,19 @@ public:
   explicit Expression(std::string statement);
 
   InferStatus Forward(const std::vector<sftensor> &inputs,
-                      std::vector<sftensor> &outputs) override;
+                      std::vector<sftensor> &outputs) const override;
+
+  bool InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                  std::vector<uint32_t> &output_shape) const override;
+
+  uint64_t Flops(const std::vector<std::vector<uint32_t>> &input_shapes,
+                 const std::vector<uint32_t> &output_shape) const override;
 
   static ParseParamAttrStatus Creator(const srunop &op, skernel &expression);
 
 private:
-  std::unique_ptr<ExprParser> parser_; // 表达式解析器
+  std::unique_ptr<ExprParser> parser_;   // 表达式解析器
+  std::vector<stokennode> token_nodes_; // 表达式的逆波兰式
 };
 
 } // namespace TinyInfer
@@ -9,7 +9,7 @@ Flatten::Flatten(int start_dim, int end_dim)
     : NoAttrKernel("Flatten"), start_dim_(start_dim), end_dim_(end_dim) {}
 
 InferStatus Flatten::Forward(const std::vector<sftensor> &inputs,
-                             std::vector<sftensor> &outputs) {
+                             std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -89,6 +89,39 @@ InferStatus Flatten::Forward(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+bool Flatten::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                         std::vector<uint32_t> &output_shape) const {
+  if (input_shapes.size() != 1 || input_shapes.front().size() != 3) {
+    LOG(ERROR) << "The input shape of Flatten is wrong";
+    return false;
+  }
+  int start_dim = start_dim_ < 0 ? 4 + start_dim_ : start_dim_;
+  int end_dim = end_dim_ < 0 ? 4 + end_dim_ : end_dim_;
+  start_dim -= 1;
+  end_dim -= 1;
+  if (end_dim > 2 || start_dim < 0 || end_dim <= start_dim) {
+    LOG(ERROR) << "Flatten dimension error: "
+               << "start_dim: " << start_dim_ << " end_dim: " << end_dim_;
+    return false;
+  }
+
+  const auto &in_shape = input_shapes.front();
+  uint32_t elem_ct = 1;
+  for (int i = start_dim; i <= end_dim; ++i) {
+    elem_ct *= in_shape.at(i);
+  }
+
+  // 与Forward中的Reshape保持一致
+  if (start_dim == 0 && end_dim == 2) {
+    output_shape = {1, elem_ct, 1};
+  } else if (start_dim == 1 && end_dim == 2) {
+    output_shape = {1, in_shape.at(0), elem_ct};
+  } else {
+    output_shape = {1, elem_ct, in_shape.at(2)};
+  }
+  return true;
+}
+
 ParseParamAttrStatus Flatten::Creator(const srunop &op, skernel &flatten) {
   if (op == nullptr) {
     LOG(ERROR) << "Operator is empty";
@@ -8,7 +8,7 @@ namespace TinyInfer {
 HardSigmoid::HardSigmoid() : NoAttrKernel("HardSigmoid") {}
 
 InferStatus HardSigmoid::Forward(const std::vector<sftensor> &inputs,
-                                 std::vector<sftensor> &outputs) {
+                                 std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -54,6 +54,16 @@ InferStatus HardSigmoid::Forward(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+bool HardSigmoid::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                             std::vector<uint32_t> &output_shape) const {
+  if (input_shapes.size() != 1 || input_shapes.front().size() != 3) {
+    LOG(ERROR) << "The input shape of HardSigmoid is wrong";
+    return false;
+  }
+  output_shape = input_shapes.front();
+  return true;
+}
+
 ParseParamAttrStatus HardSigmoid::Creator(const srunop &op,
                                           skernel &hardsigmoid) {
   if (op == nullptr) {
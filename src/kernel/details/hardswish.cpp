@@ -7,7 +7,7 @@ namespace TinyInfer {
 HardSwish::HardSwish() : NoAttrKernel("HardSwish"){};
 
 InferStatus HardSwish::Forward(const std::vector<sftensor> &inputs,
-                               std::vector<sftensor> &outputs) {
+                               std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -53,6 +53,16 @@ InferStatus HardSwish::Forward(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+bool HardSwish::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                           std::vector<uint32_t> &output_shape) const {
+  if (input_shapes.size() != 1 || input_shapes.front().size() != 3) {
+    LOG(ERROR) << "The input shape of HardSwish is wrong";
+    return false;
+  }
+  output_shape = input_shapes.front();
+  return true;
+}
+
 ParseParamAttrStatus HardSwish::Creator(const srunop &op, skernel &hardswish) {
   if (op == nullptr) {
     LOG(ERROR) << "Operator is empty";
@@ -22,7 +22,7 @@ Linear::Linear(uint32_t in_features, uint32_t out_features, bool use_bias)
 }
 
 InferStatus Linear::Forward(const std::vector<sftensor> &inputs,
-                            std::vector<sftensor> &outputs) {
+                            std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -97,6 +97,31 @@ InferStatus Linear::Forward(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+bool Linear::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                        std::vector<uint32_t> &output_shape) const {
+  if (input_shapes.size() != 1 || input_shapes.front().size() != 3) {
+    LOG(ERROR) << "The input shape of Linear is wrong";
+    return false;
+  }
+  const auto &in_shape = input_shapes.front();
+  if (in_shape.at(0) != 1 || in_shape.at(1) != in_features_) {
+    LOG(ERROR) << "The input shape of Linear is wrong";
+    return false;
+  }
+
+  // 每一列是一个输入特征
+  output_shape = {1, out_features_, in_shape.at(2)};
+  return true;
+}
+
+uint64_t Linear::Flops(const std::vector<std::vector<uint32_t>> &input_shapes,
+                       const std::vector<uint32_t> &output_shape) const {
+  // 每个输出元素做一次长度为in_features的乘加
+  const uint64_t out_elem =
+      uint64_t(output_shape.at(0)) * output_shape.at(1) * output_shape.at(2);
+  return out_elem * (2 * uint64_t(in_features_) + (use_bias_ ? 1 : 0));
+}
+
 ParseParamAttrStatus Linear::Creator(const srunop &op, skernel &linear) {
   if (op == nullptr) {
     LOG(ERROR) << "Operator is empty";
@@ -153,13 +178,15 @@ ParseParamAttrStatus Linear::Creator(const srunop &op, skernel &linear) {
   int32_t in_features = shape.at(1);
   const bool use_bias = bias_param->value;
 
-  linear = std::make_shared<Linear>(in_features, out_features, use_bias);
+  auto linear_kernel =
+      std::make_shared<Linear>(in_features, out_features, use_bias);
+  linear = linear_kernel;
 
   // 加载权重、偏置
-  linear->set_weights(weight->get<float>());
+  linear_kernel->LoadWeights(*weight);
 
   if (use_bias) {
-    linear->set_bias(bias->get<float>());
+    linear_kernel->LoadBias(*bias);
   }
 
   return ParseParamAttrStatus::ParamAttrParseSuccess;
@@ -16,7 +16,7 @@ MaxPooling::MaxPooling(uint32_t padding_h, uint32_t padding_w,
       stride_w_(stride_w) {}
 
 InferStatus MaxPooling::Forward(const std::vector<sftensor> &inputs,
-                                std::vector<sftensor> &outputs) {
+                                std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -95,6 +95,33 @@ InferStatus MaxPooling::Forward(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+bool MaxPooling::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                            std::vector<uint32_t> &output_shape) const {
+  if (input_shapes.size() != 1 || input_shapes.front().size() != 3) {
+    LOG(ERROR) << "The input shape of MaxPooling is wrong";
+    return false;
+  }
+  const auto &in_shape = input_shapes.front();
+  const uint32_t input_h = in_shape.at(1) + 2 * padding_h_;
+  const uint32_t input_w = in_shape.at(2) + 2 * padding_w_;
+  if (input_h < kernel_h_ || input_w < kernel_w_) {
+    LOG(ERROR) << "The input shape of MaxPooling is wrong";
+    return false;
+  }
+
+  output_shape = {in_shape.at(0), (input_h - kernel_h_) / stride_h_ + 1,
+                  (input_w - kernel_w_) / stride_w_ + 1};
+  return true;
+}
+
+uint64_t MaxPooling::Flops(const std::vector<std::vector<uint32_t>> &input_shapes,
+                           const std::vector<uint32_t> &output_shape) const {
+  // 每个输出元素比较一个池化窗口内的元素
+  const uint64_t out_elem =
+      uint64_t(output_shape.at(0)) * output_shape.at(1) * output_shape.at(2);
+  return out_elem * kernel_h_ * kernel_w_;
+}
+
 ParseParamAttrStatus MaxPooling::Creator(const srunop &op,
                                          skernel &maxpooling) {
   if (op == nullptr) {
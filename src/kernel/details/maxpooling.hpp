@@ -12,7 +12,13 @@ public:
                       uint32_t stride_h = 1, uint32_t stride_w = 1);
 
   InferStatus Forward(const std::vector<sftensor> &inputs,
-                      std::vector<sftensor> &outputs) override;
+                      std::vector<sftensor> &outputs) const override;
+
+  bool InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                  std::vector<uint32_t> &output_shape) const override;
+
+  uint64_t Flops(const std::vector<std::vector<uint32_t>> &input_shapes,
+                 const std::vector<uint32_t> &output_shape) const override;
 
   static ParseParamAttrStatus Creator(const srunop &op, skernel &maxpooling);
 
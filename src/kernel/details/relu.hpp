@@ -15,7 +15,10 @@ public:
    * @param outputs 输出Tensor
    */
   InferStatus Forward(const std::vector<sftensor> &inputs,
-                      std::vector<sftensor> &outputs) override;
+                      std::vector<sftensor> &outputs) const override;
+
+  bool InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                  std::vector<uint32_t> &output_shape) const override;
 
   /**
    * 解析op，获得kernel的参数和权重，创建ReLU kernel
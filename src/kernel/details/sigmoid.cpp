@@ -11,7 +11,7 @@ namespace TinyInfer {
 Sigmoid::Sigmoid() : NoAttrKernel("Sigmoid") {}
 
 InferStatus Sigmoid::Forward(const std::vector<sftensor> &inputs,
-                             std::vector<sftensor> &outputs) {
+                             std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -71,6 +71,16 @@ InferStatus Sigmoid::Forward(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+bool Sigmoid::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                         std::vector<uint32_t> &output_shape) const {
+  if (input_shapes.size() != 1 || input_shapes.front().size() != 3) {
+    LOG(ERROR) << "The input shape of Sigmoid is wrong";
+    return false;
+  }
+  output_shape = input_shapes.front();
+  return true;
+}
+
 ParseParamAttrStatus Sigmoid::Creator(const srunop &op, skernel &sigmoid) {
   if (op == nullptr) {
     LOG(ERROR) << "Operator is empty";
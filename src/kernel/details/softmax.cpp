@@ -14,7 +14,7 @@ namespace TinyInfer {
 Softmax::Softmax(int dim) : NoAttrKernel("Softmax"), dim_(dim) {}
 
 InferStatus Softmax::Forward(const std::vector<sftensor> &inputs,
-                             std::vector<sftensor> &outputs) {
+                             std::vector<sftensor> &outputs) const {
   if (inputs.empty()) {
     LOG(ERROR) << "The input tensor array is empty";
     return InferStatus::InferFailedInputEmpty;
@@ -114,6 +114,17 @@ InferStatus Softmax::Forward(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+bool Softmax::InferShape(const std::vector<std::vector<uint32_t>> &input_shapes,
+                         std::vector<uint32_t> &output_shape) const {
+  if (input_shapes.size() != 1 || input_shapes.front().size() != 3) {
+    LOG(ERROR) << "The input shape of Softmax is wrong";
+    return false;
+  }
+  // softmax不改变维度
+  output_shape = input_shapes.front();
+  return true;
+}
+
 ParseParamAttrStatus Softmax::Creator(const srunop &op, skernel &softmax) {
   if (op == nullptr) {
     LOG(ERROR) << "Operator is empty";
@@ -0,0 +1,617 @@
+#include "runtime/compiled_model.hpp"
+#include "kernel/abstract/attr_kernel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <glog/logging.h>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace TinyInfer {
+
+constexpr char CompiledModel::kMagic[8];
+
+namespace {
+// 向内存缓冲区依次写入定长数值、数组和字符串
+class BinaryWriter {
+public:
+  template <typename T> void Write(const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value);
+    buffer_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T> void WriteArray(const std::vector<T> &values) {
+    static_assert(std::is_trivially_copyable<T>::value);
+    Write<uint32_t>(values.size());
+    buffer_.append(reinterpret_cast<const char *>(values.data()),
+                   values.size() * sizeof(T));
+  }
+
+  void WriteString(const std::string &str) {
+    Write<uint32_t>(str.size());
+    buffer_.append(str);
+  }
+
+  void WriteStringArray(const std::vector<std::string> &strs) {
+    Write<uint32_t>(strs.size());
+    for (const std::string &str : strs) {
+      WriteString(str);
+    }
+  }
+
+  const std::string &buffer() const { return buffer_; }
+
+private:
+  std::string buffer_;
+};
+
+// 从内存中依次读取BinaryWriter写入的内容，越界时读取失败，之后的读取均失败
+class BinaryReader {
+public:
+  BinaryReader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T> bool Read(T &value) {
+    static_assert(std::is_trivially_copyable<T>::value);
+    if (!ok_ || size_ - pos_ < sizeof(T)) {
+      ok_ = false;
+      return false;
+    }
+    std::memcpy(&value, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  template <typename T> bool ReadArray(std::vector<T> &values) {
+    uint32_t count = 0;
+    if (!Read(count) || (size_ - pos_) / sizeof(T) < count) {
+      ok_ = false;
+      return false;
+    }
+    values.resize(count);
+    std::memcpy(values.data(), data_ + pos_, count * sizeof(T));
+    pos_ += count * sizeof(T);
+    return true;
+  }
+
+  bool ReadString(std::string &str) {
+    uint32_t length = 0;
+    if (!Read(length) || size_ - pos_ < length) {
+      ok_ = false;
+      return false;
+    }
+    str.assign(reinterpret_cast<const char *>(data_ + pos_), length);
+    pos_ += length;
+    return true;
+  }
+
+  bool ReadStringArray(std::vector<std::string> &strs) {
+    uint32_t count = 0;
+    if (!Read(count) || size_ - pos_ < count) {
+      ok_ = false;
+      return false;
+    }
+    strs.resize(count);
+    for (std::string &str : strs) {
+      if (!ReadString(str)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool ok() const { return ok_; }
+
+  bool finished() const { return ok_ && pos_ == size_; }
+
+private:
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+size_t AlignSize(size_t size) {
+  return (size + CompiledModel::kAlignment - 1) / CompiledModel::kAlignment *
+         CompiledModel::kAlignment;
+}
+
+void WriteOprand(BinaryWriter &writer, const RuntimeOprand &oprand) {
+  writer.WriteString(oprand.name);
+  writer.WriteArray(oprand.shape);
+  writer.Write<uint32_t>(uint32_t(oprand.type));
+}
+
+srunoprand ReadOprand(BinaryReader &reader) {
+  srunoprand oprand = std::make_shared<RuntimeOprand>();
+  uint32_t type = 0;
+  reader.ReadString(oprand->name);
+  reader.ReadArray(oprand->shape);
+  reader.Read(type);
+  oprand->type = RuntimeDataType(type);
+  return oprand;
+}
+
+bool WriteParam(BinaryWriter &writer, const RuntimeParam *param) {
+  writer.Write<uint32_t>(uint32_t(param->type));
+  switch (param->type) {
+  case RuntimeParamType::ParamUnknown: {
+    break;
+  }
+  case RuntimeParamType::ParamBool: {
+    writer.Write<uint8_t>(dynamic_cast<const RuntimeParamBool *>(param)->value);
+    break;
+  }
+  case RuntimeParamType::ParamInt: {
+    writer.Write<int32_t>(dynamic_cast<const RuntimeParamInt *>(param)->value);
+    break;
+  }
+  case RuntimeParamType::ParamFloat: {
+    writer.Write<float>(dynamic_cast<const RuntimeParamFloat *>(param)->value);
+    break;
+  }
+  case RuntimeParamType::ParamStr: {
+    writer.WriteString(dynamic_cast<const RuntimeParamStr *>(param)->value);
+    break;
+  }
+  case RuntimeParamType::ParamIntArray: {
+    writer.WriteArray(dynamic_cast<const RuntimeParamIntArr *>(param)->value);
+    break;
+  }
+  case RuntimeParamType::ParamFloatArray: {
+    writer.WriteArray(
+        dynamic_cast<const RuntimeParamFloatArr *>(param)->value);
+    break;
+  }
+  case RuntimeParamType::ParamStrArray: {
+    writer.WriteStringArray(
+        dynamic_cast<const RuntimeParamStrArr *>(param)->value);
+    break;
+  }
+  default: {
+    return false;
+  }
+  }
+  return true;
+}
+
+RuntimeParam *ReadParam(BinaryReader &reader) {
+  uint32_t type = 0;
+  if (!reader.Read(type)) {
+    return nullptr;
+  }
+  switch (RuntimeParamType(type)) {
+  case RuntimeParamType::ParamUnknown: {
+    return new RuntimeParam;
+  }
+  case RuntimeParamType::ParamBool: {
+    uint8_t value = 0;
+    reader.Read(value);
+    auto param = new RuntimeParamBool;
+    param->value = value != 0;
+    return param;
+  }
+  case RuntimeParamType::ParamInt: {
+    auto param = new RuntimeParamInt;
+    reader.Read(param->value);
+    return param;
+  }
+  case RuntimeParamType::ParamFloat: {
+    auto param = new RuntimeParamFloat;
+    reader.Read(param->value);
+    return param;
+  }
+  case RuntimeParamType::ParamStr: {
+    auto param = new RuntimeParamStr;
+    reader.ReadString(param->value);
+    return param;
+  }
+  case RuntimeParamType::ParamIntArray: {
+    auto param = new RuntimeParamIntArr;
+    reader.ReadArray(param->value);
+    return param;
+  }
+  case RuntimeParamType::ParamFloatArray: {
+    auto param = new RuntimeParamFloatArr;
+    reader.ReadArray(param->value);
+    return param;
+  }
+  case RuntimeParamType::ParamStrArray: {
+    auto param = new RuntimeParamStrArr;
+    reader.ReadStringArray(param->value);
+    return param;
+  }
+  default: {
+    return nullptr;
+  }
+  }
+}
+} // namespace
+
+bool CompiledModel::Save(const RuntimeGraph &graph, const std::string &path) {
+  if (graph.graph_state_ != RuntimeGraph::GraphState::Complete) {
+    LOG(ERROR) << "The graph must be built before saving";
+    return false;
+  }
+
+  // 只保存输出依赖的节点，以及指定的输入、输出节点
+  const auto &ops = graph.ops_;
+  std::vector<uint32_t> saved_ops;
+  std::unordered_set<std::string> saved_names;
+  for (uint32_t i = 0; i < ops.size(); ++i) {
+    const srunop &op = ops.at(i);
+    const auto &input_names = graph.input_names_;
+    const auto &output_names = graph.output_names_;
+    const bool saved =
+        graph.required_ops_.at(i) ||
+        (op->type == "pnnx.Input" &&
+         std::find(input_names.begin(), input_names.end(), op->name) !=
+             input_names.end()) ||
+        (op->type == "pnnx.Output" &&
+         std::find(output_names.begin(), output_names.end(), op->name) !=
+             output_names.end());
+    if (saved) {
+      saved_ops.push_back(i);
+      saved_names.insert(op->name);
+    }
+  }
+
+  BinaryWriter writer;
+  std::string weight_buffer;
+  writer.WriteStringArray(graph.input_names_);
+  writer.WriteStringArray(graph.output_names_);
+  writer.Write<uint32_t>(graph.max_concurrent_ops_);
+  writer.Write<uint8_t>(graph.fuse_ops_);
+
+  writer.Write<uint32_t>(saved_ops.size());
+  for (const uint32_t idx : saved_ops) {
+    const srunop &op = ops.at(idx);
+    writer.WriteString(op->name);
+    writer.WriteString(op->type);
+
+    writer.Write<uint32_t>(op->in_oprands_seq.size());
+    for (const auto &in_oprand : op->in_oprands_seq) {
+      WriteOprand(writer, *in_oprand);
+    }
+    writer.Write<uint8_t>(op->out_oprand != nullptr);
+    if (op->out_oprand != nullptr) {
+      WriteOprand(writer, *op->out_oprand);
+    }
+
+    // 后继节点按名称排序，保证同一计算图生成的文件相同
+    std::vector<std::string> out_names;
+    for (const auto &[name, _] : op->out_ops) {
+      if (saved_names.find(name) != saved_names.end()) {
+        out_names.push_back(name);
+      }
+    }
+    std::sort(out_names.begin(), out_names.end());
+    writer.WriteStringArray(out_names);
+
+    std::vector<std::string> param_names;
+    for (const auto &[name, _] : op->params) {
+      param_names.push_back(name);
+    }
+    std::sort(param_names.begin(), param_names.end());
+    writer.Write<uint32_t>(param_names.size());
+    for (const std::string &name : param_names) {
+      writer.WriteString(name);
+      if (!WriteParam(writer, op->params.at(name))) {
+        LOG(ERROR) << "Unsupported parameter type of " << op->name << "."
+                   << name;
+        return false;
+      }
+    }
+
+    // 权重取自Kernel，即已转换为Kernel内存布局的权重Tensor
+    std::vector<std::pair<std::string, const std::vector<sftensor> *>> packed;
+    const auto attr_kernel = dynamic_cast<const AttrKernel *>(op->kernel.get());
+    if (attr_kernel != nullptr) {
+      if (!attr_kernel->weights().empty()) {
+        packed.emplace_back("weight", &attr_kernel->weights());
+      }
+      if (!attr_kernel->bias().empty()) {
+        packed.emplace_back("bias", &attr_kernel->bias());
+      }
+    }
+    for (const auto &[name, _] : op->attrs) {
+      const bool is_packed =
+          std::find_if(packed.begin(), packed.end(), [&](const auto &item) {
+            return item.first == name;
+          }) != packed.end();
+      if (!is_packed) {
+        LOG(ERROR) << "The attribute " << op->name << "." << name
+                   << " is not held by the kernel";
+        return false;
+      }
+    }
+
+    writer.Write<uint32_t>(packed.size());
+    for (const auto &[name, tensors] : packed) {
+      const auto attr = op->attrs.find(name);
+      if (attr == op->attrs.end()) {
+        LOG(ERROR) << "The attribute " << op->name << "." << name
+                   << " is missing";
+        return false;
+      }
+      weight_buffer.resize(AlignSize(weight_buffer.size()), 0);
+      const uint64_t offset = weight_buffer.size();
+      uint64_t elem_ct = 0;
+      for (const sftensor &tensor : *tensors) {
+        weight_buffer.append(reinterpret_cast<const char *>(tensor->raw_ptr()),
+                             tensor->size() * sizeof(float));
+        elem_ct += tensor->size();
+      }
+
+      writer.WriteString(name);
+      writer.WriteArray(attr->second->shape);
+      writer.Write<uint32_t>(uint32_t(RuntimeDataType::TypeFloat32));
+      writer.Write<uint64_t>(offset);
+      writer.Write<uint64_t>(elem_ct);
+    }
+  }
+
+  // 结构文件中声明的输入维度下的激活布局，槽位按保存的节点重新编号
+  const ActivationLayout &layout = *graph.default_layout_;
+  writer.Write<uint32_t>(layout.input_shapes.size());
+  for (const auto &input_shape : layout.input_shapes) {
+    writer.WriteArray(input_shape);
+  }
+  for (const uint32_t idx : saved_ops) {
+    const SlotLayout &info = layout.slots.at(idx);
+    writer.Write<uint8_t>(info.used);
+    writer.Write<uint32_t>(info.channels);
+    writer.Write<uint32_t>(info.rows);
+    writer.Write<uint32_t>(info.cols);
+    writer.Write<uint8_t>(info.planned);
+    writer.Write<uint64_t>(info.offset);
+    writer.Write<uint64_t>(info.sample_bytes);
+  }
+  writer.Write<uint64_t>(layout.naive_bytes);
+  writer.Write<uint64_t>(layout.planned_bytes);
+  writer.Write<uint64_t>(layout.live_peak_bytes);
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.header_size = sizeof(Header);
+  header.graph_offset = sizeof(Header);
+  header.graph_size = writer.buffer().size();
+  header.weight_offset = AlignSize(header.graph_offset + header.graph_size);
+  header.weight_size = weight_buffer.size();
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    LOG(ERROR) << "Can not open the compiled model file: " << path;
+    return false;
+  }
+  const std::string padding(
+      header.weight_offset - header.graph_offset - header.graph_size, 0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+  file.write(writer.buffer().data(), writer.buffer().size());
+  file.write(padding.data(), padding.size());
+  file.write(weight_buffer.data(), weight_buffer.size());
+  if (!file.good()) {
+    LOG(ERROR) << "Write the compiled model file failed: " << path;
+    return false;
+  }
+  return true;
+}
+
+std::unique_ptr<RuntimeGraph> CompiledModel::Load(const std::string &path) {
+  const auto load_start = std::chrono::steady_clock::now();
+  const auto elapsed_ms = [](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  };
+  std::shared_ptr<MappedFile> file = MappedFile::Open(path);
+  if (file == nullptr) {
+    return nullptr;
+  }
+
+  // 检查文件头及各段的范围
+  Header header{};
+  if (file->size() < sizeof(Header)) {
+    LOG(ERROR) << "The compiled model file is too small: " << path;
+    return nullptr;
+  }
+  std::memcpy(&header, file->data(), sizeof(Header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.header_size != sizeof(Header)) {
+    LOG(ERROR) << "Not a compiled model file: " << path;
+    return nullptr;
+  }
+  if (header.version != kVersion) {
+    LOG(ERROR) << "The compiled model version " << header.version
+               << " is not supported, recompile the model: " << path;
+    return nullptr;
+  }
+  if (header.graph_offset > file->size() ||
+      header.graph_size > file->size() - header.graph_offset ||
+      header.weight_offset > file->size() ||
+      header.weight_size > file->size() - header.weight_offset ||
+      header.weight_offset % kAlignment != 0) {
+    LOG(ERROR) << "The compiled model file is truncated or broken: " << path;
+    return nullptr;
+  }
+
+  std::unique_ptr<RuntimeGraph> graph = std::make_unique<RuntimeGraph>(path, "");
+  BinaryReader reader(file->data() + header.graph_offset, header.graph_size);
+  uint32_t max_concurrent_ops = 1;
+  uint8_t fuse_ops = 0;
+  reader.ReadStringArray(graph->input_names_);
+  reader.ReadStringArray(graph->output_names_);
+  reader.Read(max_concurrent_ops);
+  reader.Read(fuse_ops);
+  graph->max_concurrent_ops_ = std::max(max_concurrent_ops, 1u);
+  graph->fuse_ops_ = fuse_ops != 0;
+
+  // 恢复计算图节点
+  uint32_t op_count = 0;
+  reader.Read(op_count);
+  float *weight_base =
+      reinterpret_cast<float *>(file->data() + header.weight_offset);
+  std::unordered_map<std::string, srunop> op_map;
+  for (uint32_t i = 0; i < op_count && reader.ok(); ++i) {
+    srunop op = std::make_shared<RuntimeOp>();
+    reader.ReadString(op->name);
+    reader.ReadString(op->type);
+
+    uint32_t in_count = 0;
+    reader.Read(in_count);
+    for (uint32_t j = 0; j < in_count && reader.ok(); ++j) {
+      srunoprand in_oprand = ReadOprand(reader);
+      op->in_oprands_seq.push_back(in_oprand);
+      op->in_oprands.insert({in_oprand->name, in_oprand});
+    }
+    uint8_t has_output = 0;
+    reader.Read(has_output);
+    if (has_output) {
+      op->out_oprand = ReadOprand(reader);
+    }
+
+    std::vector<std::string> out_names;
+    reader.ReadStringArray(out_names);
+    for (const std::string &out_name : out_names) {
+      op->out_ops.insert({out_name, nullptr});
+    }
+
+    uint32_t param_count = 0;
+    reader.Read(param_count);
+    for (uint32_t j = 0; j < param_count && reader.ok(); ++j) {
+      std::string name;
+      reader.ReadString(name);
+      RuntimeParam *param = ReadParam(reader);
+      if (param == nullptr) {
+        LOG(ERROR) << "Unsupported parameter type of " << op->name << "."
+                   << name;
+        return nullptr;
+      }
+      op->params.insert({name, param});
+    }
+
+    // 权重属性指向映射内存中打包好的权重
+    uint32_t attr_count = 0;
+    reader.Read(attr_count);
+    for (uint32_t j = 0; j < attr_count && reader.ok(); ++j) {
+      std::string name;
+      uint32_t type = 0;
+      uint64_t offset = 0;
+      uint64_t elem_ct = 0;
+      srunattr attr = std::make_shared<RuntimeAttr>();
+      reader.ReadString(name);
+      reader.ReadArray(attr->shape);
+      reader.Read(type);
+      reader.Read(offset);
+      reader.Read(elem_ct);
+      if (offset % sizeof(float) != 0 || offset > header.weight_size ||
+          elem_ct > (header.weight_size - offset) / sizeof(float)) {
+        LOG(ERROR) << "The attribute " << op->name << "." << name
+                   << " is out of the weight section";
+        return nullptr;
+      }
+      attr->type = RuntimeDataType(type);
+      attr->packed_data = weight_base + offset / sizeof(float);
+      attr->packed_size = elem_ct;
+      op->attrs.insert({name, attr});
+    }
+
+    op_map.insert({op->name, op});
+    graph->ops_.push_back(op);
+  }
+
+  // 恢复激活布局
+  auto layout = std::make_shared<ActivationLayout>();
+  uint32_t input_count = 0;
+  reader.Read(input_count);
+  for (uint32_t i = 0; i < input_count && reader.ok(); ++i) {
+    std::vector<uint32_t> input_shape;
+    reader.ReadArray(input_shape);
+    layout->input_shapes.push_back(std::move(input_shape));
+  }
+  layout->slots.resize(graph->ops_.size());
+  for (SlotLayout &info : layout->slots) {
+    uint8_t used = 0;
+    uint8_t planned = 0;
+    uint64_t offset = 0;
+    uint64_t sample_bytes = 0;
+    reader.Read(used);
+    reader.Read(info.channels);
+    reader.Read(info.rows);
+    reader.Read(info.cols);
+    reader.Read(planned);
+    reader.Read(offset);
+    reader.Read(sample_bytes);
+    info.used = used != 0;
+    info.planned = planned != 0;
+    info.offset = offset;
+    info.sample_bytes = sample_bytes;
+  }
+  uint64_t naive_bytes = 0;
+  uint64_t planned_bytes = 0;
+  uint64_t live_peak_bytes = 0;
+  reader.Read(naive_bytes);
+  reader.Read(planned_bytes);
+  reader.Read(live_peak_bytes);
+  layout->naive_bytes = naive_bytes;
+  layout->planned_bytes = planned_bytes;
+  layout->live_peak_bytes = live_peak_bytes;
+
+  if (!reader.finished() || op_count != graph->ops_.size()) {
+    LOG(ERROR) << "The compiled model file is broken: " << path;
+    return nullptr;
+  }
+
+  // 连接后继节点
+  for (const auto &op : graph->ops_) {
+    for (auto &[name, next_op] : op->out_ops) {
+      const auto iter = op_map.find(name);
+      if (iter == op_map.end()) {
+        LOG(ERROR) << "Can not find the operator " << name << " after "
+                   << op->name;
+        return nullptr;
+      }
+      next_op = iter->second;
+    }
+    if (op->type == "pnnx.Input") {
+      graph->input_ops.insert({op->name, op});
+    } else if (op->type == "pnnx.Output") {
+      graph->output_ops.insert({op->name, op});
+    }
+  }
+
+  // 节点已融合、剪枝，直接构造Kernel并生成执行计划，激活布局使用保存的规划结果
+  graph->ResolveGraphIO();
+  StartupTimings &timings = graph->startup_timings_;
+  timings.init_ms = elapsed_ms(load_start);
+
+  const auto kernel_start = std::chrono::steady_clock::now();
+  {
+    const std::unique_ptr<ThreadPool> build_pool = graph->CreateBuildPool();
+    timings.threads = build_pool ? build_pool->thread_num() : 1;
+    graph->CreateKernels(build_pool.get());
+  }
+  timings.kernel_ms = elapsed_ms(kernel_start);
+
+  const auto plan_start = std::chrono::steady_clock::now();
+  graph->BuildExecPlan();
+  if (layout->input_shapes.size() != graph->input_slots_.size()) {
+    LOG(ERROR) << "The activation layout do not match the graph inputs";
+    return nullptr;
+  }
+  graph->default_layout_ = std::move(layout);
+  graph->plan_version_ += 1;
+
+  if (graph->max_concurrent_ops_ > 1) {
+    graph->op_pool_ =
+        std::make_unique<ThreadPool>(graph->max_concurrent_ops_);
+  }
+  timings.plan_ms = elapsed_ms(plan_start);
+  graph->mapped_model_ = std::move(file);
+  graph->graph_state_ = RuntimeGraph::GraphState::Complete;
+  return graph;
+}
+
+} // namespace TinyInfer
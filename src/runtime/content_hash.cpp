@@ -0,0 +1,74 @@
+#include "runtime/content_hash.hpp"
+#include <cstring>
+
+namespace TinyInfer {
+
+namespace {
+uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+uint64_t FinalMix(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+} // namespace
+
+// 数据按16字节分块读取，不足16字节的尾部补零
+void ContentHash(const char *data, size_t size, uint64_t &h1, uint64_t &h2) {
+  constexpr uint64_t c1 = 0x87c37b91114253d5ULL;
+  constexpr uint64_t c2 = 0x4cf5ad432745937fULL;
+  h1 = 0;
+  h2 = 0;
+
+  const size_t block_ct = size / 16;
+  for (size_t i = 0; i < block_ct; ++i) {
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    std::memcpy(&k1, data + i * 16, sizeof(uint64_t));
+    std::memcpy(&k2, data + i * 16 + 8, sizeof(uint64_t));
+
+    k1 *= c1;
+    k1 = Rotl(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 = Rotl(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= c2;
+    k2 = Rotl(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+    h2 = Rotl(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
+  }
+
+  // 不足16字节的尾部
+  uint64_t tail[2] = {0, 0};
+  std::memcpy(tail, data + block_ct * 16, size % 16);
+  uint64_t k1 = tail[0];
+  uint64_t k2 = tail[1];
+  k2 *= c2;
+  k2 = Rotl(k2, 33);
+  k2 *= c1;
+  h2 ^= k2;
+  k1 *= c1;
+  k1 = Rotl(k1, 31);
+  k1 *= c2;
+  h1 ^= k1;
+
+  h1 ^= size;
+  h2 ^= size;
+  h1 += h2;
+  h2 += h1;
+  h1 = FinalMix(h1);
+  h2 = FinalMix(h2);
+  h1 += h2;
+  h2 += h1;
+}
+
+} // namespace TinyInfer
@@ -0,0 +1,25 @@
+#include "runtime/execution_context.hpp"
+
+namespace TinyInfer {
+
+ExecutionContext::ExecutionContext(const RuntimeGraph *graph,
+                                   uint64_t plan_version)
+    : graph_(graph), plan_version_(plan_version) {}
+
+const RuntimeGraph *ExecutionContext::graph() const { return graph_; }
+
+size_t ExecutionContext::activation_bytes() const {
+  size_t bytes = arena_ != nullptr ? arena_->size() : 0;
+  for (const auto &output_tensors : output_tensors_) {
+    for (const sftensor &output : output_tensors) {
+      bytes += output->size() * sizeof(float);
+    }
+  }
+  return bytes;
+}
+
+uint32_t ExecutionContext::batch() const { return batch_; }
+
+const Profiler &ExecutionContext::profiler() const { return profiler_; }
+
+} // namespace TinyInfer
@@ -688,12 +688,18 @@ static void load_attribute(Operator* op, const std::string& key, const std::stri
     {
         fprintf(stderr, "file size not match expect %lu but got %lu\n", bytesize, filesize);
     }
+    else if (szr.get_mapped_file())
+    {
+        // refer to the entry in the mapped file directly
+        a.mapped_data = szr.get_file_data(filename);
+        return;
+    }
 
     a.data.resize(bytesize);
     szr.read_file(filename, (char*)a.data.data());
 }
 
-int Graph::load(const std::string& parampath, const std::string& binpath)
+int Graph::load(const std::string& parampath, const std::string& binpath, bool map_weights, int num_threads)
 {
     std::ifstream is(parampath, std::ios::in | std::ios::binary);
     if (!is.good())
@@ -702,8 +708,9 @@ int Graph::load(const std::string& parampath, const std::string& binpath)
         return -1;
     }
 
+    // deflated weight entries are decompressed in parallel when the bin file is opened
     StoreZipReader szr;
-    if (szr.open(binpath) != 0)
+    if (szr.open(binpath, map_weights, num_threads) != 0)
     {
         fprintf(stderr, "open failed\n");
         return -1;
@@ -798,10 +805,12 @@ int Graph::load(const std::string& parampath, const std::string& binpath)
         }
     }
 
+    weight_file = szr.get_mapped_file();
+
     return 0;
 }
 
-int Graph::save(const std::string& parampath, const std::string& binpath)
+int Graph::save(const std::string& parampath, const std::string& binpath, int compression_level)
 {
     FILE* paramfp = fopen(parampath.c_str(), "wb");
     if (!paramfp)
@@ -811,7 +820,7 @@ int Graph::save(const std::string& parampath, const std::string& binpath)
     }
 
     StoreZipWriter szw;
-    if (szw.open(binpath) != 0)
+    if (szw.open(binpath, compression_level) != 0)
     {
         fprintf(stderr, "open failed\n");
         return -1;
@@ -917,7 +926,19 @@ int Graph::save(const std::string& parampath, const std::string& binpath)
             fprintf(paramfp, type_to_string(attr.type));
 
             std::string filename = op->name + "." + it.first;
-            szw.write_file(filename, attr.data.data(), attr.data.size());
+            if (attr.data.empty() && attr.mapped_data)
+            {
+                size_t bytesize = type_to_elemsize(attr.type);
+                for (int i : attr.shape)
+                {
+                    bytesize *= i;
+                }
+                szw.write_file(filename, attr.mapped_data, bytesize);
+            }
+            else
+            {
+                szw.write_file(filename, attr.data.data(), attr.data.size());
+            }
         }
 
         if (op->inputnames.size() == op->inputs.size())
@@ -0,0 +1,105 @@
+#include "runtime/mapped_file.hpp"
+#include <fstream>
+#include <glog/logging.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TinyInfer {
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string &path) {
+  std::shared_ptr<MappedFile> file(new MappedFile());
+  file->path_ = path;
+
+#ifndef _WIN32
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "Can not open the file: " << path;
+    return nullptr;
+  }
+  struct stat file_stat {};
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+    LOG(ERROR) << "The file is empty or can not be accessed: " << path;
+    close(fd);
+    return nullptr;
+  }
+  file->size_ = file_stat.st_size;
+
+  // 私有映射：页面可写，但修改只对当前进程可见
+  void *addr = mmap(nullptr, file->size_, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "Can not map the file: " << path;
+    return nullptr;
+  }
+  file->data_ = static_cast<uint8_t *>(addr);
+  file->mapped_ = true;
+#else
+  std::ifstream stream(path, std::ios::binary | std::ios::ate);
+  if (!stream.is_open()) {
+    LOG(ERROR) << "Can not open the file: " << path;
+    return nullptr;
+  }
+  file->size_ = stream.tellg();
+  if (file->size_ == 0) {
+    LOG(ERROR) << "The file is empty: " << path;
+    return nullptr;
+  }
+  file->buffer_.resize(file->size_);
+  stream.seekg(0);
+  stream.read(reinterpret_cast<char *>(file->buffer_.data()), file->size_);
+  if (!stream) {
+    LOG(ERROR) << "Can not read the file: " << path;
+    return nullptr;
+  }
+  file->data_ = file->buffer_.data();
+#endif
+  return file;
+}
+
+std::shared_ptr<MappedFile> MappedFile::Allocate(const std::string &path,
+                                                 size_t size) {
+  std::shared_ptr<MappedFile> file(new MappedFile());
+  file->path_ = path;
+  file->size_ = size;
+  if (size == 0) {
+    return file;
+  }
+
+#ifndef _WIN32
+  // 匿名映射按页对齐，且未写入的页面不占用物理内存
+  void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "Can not allocate " << size << " bytes for the file: " << path;
+    return nullptr;
+  }
+  file->data_ = static_cast<uint8_t *>(addr);
+  file->mapped_ = true;
+#else
+  file->buffer_.resize(size);
+  file->data_ = file->buffer_.data();
+#endif
+  return file;
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (mapped_ && data_ != nullptr) {
+    munmap(data_, size_);
+  }
+#endif
+}
+
+uint8_t *MappedFile::data() const { return data_; }
+
+size_t MappedFile::size() const { return size_; }
+
+const std::string &MappedFile::path() const { return path_; }
+
+} // namespace TinyInfer
@@ -0,0 +1,208 @@
+#include "runtime/memory_planner.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <glog/logging.h>
+#include <numeric>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace TinyInfer {
+
+size_t MemoryPlanner::AlignSize(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+uint32_t MemoryPlanner::AddBlock(size_t size, uint32_t first_step,
+                                 uint32_t last_step) {
+  CHECK(first_step <= last_step)
+      << "The first step " << first_step << " is after the last step "
+      << last_step;
+
+  Block block;
+  block.size = AlignSize(size);
+  block.first_step = first_step;
+  block.last_step = last_step;
+  block.use_steps = {first_step, last_step};
+  blocks_.push_back(block);
+  planned_ = false;
+  return blocks_.size() - 1;
+}
+
+uint32_t MemoryPlanner::AddBlock(size_t size, uint32_t first_step,
+                                 const std::vector<uint32_t> &use_steps) {
+  uint32_t last_step = first_step;
+  for (const uint32_t step : use_steps) {
+    last_step = std::max(last_step, step);
+  }
+  const uint32_t block_id = AddBlock(size, first_step, last_step);
+  Block &block = blocks_.at(block_id);
+  block.use_steps.insert(block.use_steps.end(), use_steps.begin(),
+                         use_steps.end());
+  return block_id;
+}
+
+void MemoryPlanner::SetDependencies(
+    const std::vector<std::vector<uint32_t>> &next_steps) {
+  // 逆序遍历各步骤，一个步骤可达的步骤为其后继及后继可达的步骤
+  const uint32_t step_num = next_steps.size();
+  reachable_.assign(step_num, std::vector<bool>(step_num, false));
+  for (uint32_t i = step_num; i > 0; --i) {
+    const uint32_t step = i - 1;
+    for (const uint32_t next : next_steps.at(step)) {
+      CHECK(next > step && next < step_num)
+          << "The step " << next << " can not depend on the step " << step;
+      reachable_.at(step).at(next) = true;
+      for (uint32_t j = next + 1; j < step_num; ++j) {
+        if (reachable_.at(next).at(j)) {
+          reachable_.at(step).at(j) = true;
+        }
+      }
+    }
+  }
+  planned_ = false;
+}
+
+bool MemoryPlanner::Before(const Block &block1, const Block &block2) const {
+  for (const uint32_t step : block1.use_steps) {
+    if (step >= reachable_.size() || block2.first_step >= reachable_.size() ||
+        !reachable_.at(step).at(block2.first_step)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MemoryPlanner::Conflict(const Block &block1, const Block &block2) const {
+  if (reachable_.empty()) {
+    // 各步骤依次执行，生命周期区间重叠即冲突
+    return block1.first_step <= block2.last_step &&
+           block2.first_step <= block1.last_step;
+  }
+  return !Before(block1, block2) && !Before(block2, block1);
+}
+
+size_t MemoryPlanner::Plan() {
+  // 按大小降序依次放置内存块，大块优先能减少碎片
+  std::vector<uint32_t> order(blocks_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+    return blocks_.at(a).size > blocks_.at(b).size;
+  });
+
+  planned_bytes_ = 0;
+  std::vector<uint32_t> placed;
+  placed.reserve(blocks_.size());
+  for (const uint32_t id : order) {
+    Block &block = blocks_.at(id);
+
+    // 找出已放置的、与当前块生命周期重叠的内存块
+    std::vector<const Block *> conflicts;
+    for (const uint32_t placed_id : placed) {
+      const Block &other = blocks_.at(placed_id);
+      if (Conflict(block, other)) {
+        conflicts.push_back(&other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [](const Block *a, const Block *b) {
+                return a->offset < b->offset;
+              });
+
+    // 从低地址开始寻找第一个能容纳当前块的空隙
+    size_t offset = 0;
+    for (const Block *other : conflicts) {
+      if (offset + block.size <= other->offset) {
+        break;
+      }
+      offset = std::max(offset, other->offset + other->size);
+    }
+    block.offset = offset;
+    planned_bytes_ = std::max(planned_bytes_, offset + block.size);
+    placed.push_back(id);
+  }
+
+  planned_ = true;
+  return planned_bytes_;
+}
+
+void MemoryPlanner::Clear() {
+  blocks_.clear();
+  reachable_.clear();
+  planned_bytes_ = 0;
+  planned_ = false;
+}
+
+size_t MemoryPlanner::offset(uint32_t block_id) const {
+  CHECK(planned_) << "The memory blocks have not been planned";
+  CHECK(block_id < blocks_.size()) << "Invalid memory block id " << block_id;
+  return blocks_.at(block_id).offset;
+}
+
+uint32_t MemoryPlanner::block_count() const { return blocks_.size(); }
+
+size_t MemoryPlanner::naive_bytes() const {
+  size_t bytes = 0;
+  for (const Block &block : blocks_) {
+    bytes += block.size;
+  }
+  return bytes;
+}
+
+size_t MemoryPlanner::live_peak_bytes() const {
+  uint32_t step_count = 0;
+  for (const Block &block : blocks_) {
+    step_count = std::max(step_count, block.last_step + 1);
+  }
+
+  // 差分统计每一步存活的内存之和
+  std::vector<int64_t> deltas(step_count + 1, 0);
+  for (const Block &block : blocks_) {
+    deltas.at(block.first_step) += block.size;
+    deltas.at(block.last_step + 1) -= block.size;
+  }
+  int64_t live = 0;
+  int64_t peak = 0;
+  for (const int64_t delta : deltas) {
+    live += delta;
+    peak = std::max(peak, live);
+  }
+  return peak;
+}
+
+size_t MemoryPlanner::planned_bytes() const {
+  CHECK(planned_) << "The memory blocks have not been planned";
+  return planned_bytes_;
+}
+
+MemoryArena::MemoryArena(size_t size)
+    : data_(nullptr), size_(MemoryPlanner::AlignSize(size)) {
+  if (size_ == 0) {
+    return;
+  }
+#ifdef _MSC_VER
+  auto *ptr = static_cast<uint8_t *>(
+      _aligned_malloc(size_, MemoryPlanner::kAlignment));
+#else
+  auto *ptr = static_cast<uint8_t *>(
+      std::aligned_alloc(MemoryPlanner::kAlignment, size_));
+#endif
+  CHECK(ptr != nullptr) << "Allocate memory arena failed, size: " << size_;
+  std::memset(ptr, 0, size_);
+  data_.reset(ptr);
+}
+
+uint8_t *MemoryArena::data() const { return data_.get(); }
+
+size_t MemoryArena::size() const { return size_; }
+
+void MemoryArena::AlignedDeleter::operator()(uint8_t *ptr) const {
+#ifdef _MSC_VER
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+} // namespace TinyInfer
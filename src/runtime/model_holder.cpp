@@ -0,0 +1,159 @@
+#include "runtime/model_holder.hpp"
+#include <atomic>
+#include <exception>
+#include <glog/logging.h>
+#include <mutex>
+#include <utility>
+
+namespace TinyInfer {
+
+class ModelHolder::Version {
+public:
+  Version(std::unique_ptr<RuntimeGraph> graph, uint64_t id)
+      : graph_(std::move(graph)), id_(id) {}
+
+  /**
+   * 取出一个空闲的执行上下文，没有时新建
+   */
+  std::unique_ptr<ExecutionContext> AcquireContext() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!free_contexts_.empty()) {
+        std::unique_ptr<ExecutionContext> context =
+            std::move(free_contexts_.back());
+        free_contexts_.pop_back();
+        return context;
+      }
+    }
+    return graph_->CreateContext();
+  }
+
+  /**
+   * 归还执行上下文，其中的激活内存留给之后的推理复用
+   */
+  void ReleaseContext(std::unique_ptr<ExecutionContext> context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_contexts_.push_back(std::move(context));
+  }
+
+  const RuntimeGraph &graph() const { return *graph_; }
+
+  uint64_t id() const { return id_; }
+
+private:
+  std::unique_ptr<RuntimeGraph> graph_;
+  uint64_t id_ = 0;
+  std::mutex mutex_; // 保护free_contexts_
+  std::vector<std::unique_ptr<ExecutionContext>> free_contexts_;
+};
+
+ModelHolder::Lease::Lease(std::shared_ptr<Version> version,
+                          std::unique_ptr<ExecutionContext> context)
+    : version_(std::move(version)), context_(std::move(context)) {}
+
+ModelHolder::Lease::~Lease() {
+  if (version_ != nullptr && context_ != nullptr) {
+    version_->ReleaseContext(std::move(context_));
+  }
+}
+
+const RuntimeGraph &ModelHolder::Lease::graph() const {
+  return version_->graph();
+}
+
+ExecutionContext &ModelHolder::Lease::context() { return *context_; }
+
+uint64_t ModelHolder::Lease::version() const { return version_->id(); }
+
+ModelHolder::ModelHolder(std::unique_ptr<RuntimeGraph> graph) {
+  CHECK(graph != nullptr) << "The initial graph is empty";
+  current_ = std::make_shared<Version>(std::move(graph), 1);
+}
+
+ModelHolder::~ModelHolder() { reload_pool_.Wait(); }
+
+ModelHolder::Lease ModelHolder::Acquire() const {
+  std::shared_ptr<Version> version = std::atomic_load(&current_);
+  std::unique_ptr<ExecutionContext> context = version->AcquireContext();
+  return Lease(std::move(version), std::move(context));
+}
+
+std::vector<sftensor>
+ModelHolder::Forward(const std::vector<sftensor> &inputs) const {
+  Lease lease = Acquire();
+  const std::vector<sftensor> outputs =
+      lease.graph().Forward(lease.context(), inputs);
+  // 输出Tensor由上下文持有，归还上下文前复制一份
+  std::vector<sftensor> results;
+  results.reserve(outputs.size());
+  for (const sftensor &output : outputs) {
+    results.push_back(output->Clone());
+  }
+  return results;
+}
+
+ModelHolder::NamedTensors
+ModelHolder::Forward(const NamedTensors &inputs) const {
+  Lease lease = Acquire();
+  const NamedTensors outputs = lease.graph().Forward(lease.context(), inputs);
+  NamedTensors results;
+  for (const auto &[name, tensors] : outputs) {
+    std::vector<sftensor> &copies = results[name];
+    copies.reserve(tensors.size());
+    for (const sftensor &tensor : tensors) {
+      copies.push_back(tensor->Clone());
+    }
+  }
+  return results;
+}
+
+std::future<bool> ModelHolder::Reload(GraphFactory factory,
+                                      NamedTensors warmup_inputs) {
+  CHECK(factory != nullptr) << "The graph factory is empty";
+  // 线程池中的任务须可复制，promise经由shared_ptr持有
+  auto promise = std::make_shared<std::promise<bool>>();
+  std::future<bool> result = promise->get_future();
+  reload_pool_.Submit(
+      [this, promise, factory = std::move(factory),
+       warmup_inputs = std::move(warmup_inputs)]() {
+        promise->set_value(DoReload(factory, warmup_inputs));
+      });
+  return result;
+}
+
+bool ModelHolder::DoReload(const GraphFactory &factory,
+                           const NamedTensors &warmup_inputs) {
+  std::shared_ptr<Version> version;
+  try {
+    std::unique_ptr<RuntimeGraph> graph = factory();
+    if (graph == nullptr) {
+      LOG(ERROR) << "Build the new model version failed, keep version "
+                 << this->version();
+      return false;
+    }
+    version = std::make_shared<Version>(std::move(graph), next_version_);
+
+    // 预热：推理一次，开辟的激活内存随上下文留给切换后的推理
+    if (!warmup_inputs.empty()) {
+      std::unique_ptr<ExecutionContext> context = version->AcquireContext();
+      version->graph().Forward(*context, warmup_inputs);
+      version->ReleaseContext(std::move(context));
+    }
+  } catch (const std::exception &e) {
+    LOG(ERROR) << "Reload the model failed: " << e.what() << ", keep version "
+               << this->version();
+    return false;
+  }
+
+  // 原子地替换当前版本，旧版本在最后一个占用结束后释放
+  std::atomic_store(&current_, version);
+  next_version_ += 1;
+  LOG(INFO) << "Switched to the model version " << version->id();
+  return true;
+}
+
+uint64_t ModelHolder::version() const {
+  return std::atomic_load(&current_)->id();
+}
+
+} // namespace TinyInfer
@@ -0,0 +1,192 @@
+#include "runtime/op_fusion.hpp"
+#include "runtime/runtime_param.hpp"
+#include <algorithm>
+#include <glog/logging.h>
+#include <unordered_set>
+
+namespace TinyInfer {
+
+const std::vector<FusionPattern> &OpFusion::Patterns() {
+  // 较长的模式优先匹配
+  static const std::vector<FusionPattern> patterns{
+      {{"nn.Conv2d", "pnnx.Expression", "nn.ReLU"}, "add(@0,@1)"},
+      {{"nn.Conv2d", "pnnx.Expression"}, "add(@0,@1)"},
+      {{"nn.Conv2d", "nn.ReLU"}, ""},
+      {{"nn.Conv2d", "nn.Hardswish"}, ""},
+  };
+  return patterns;
+}
+
+uint32_t OpFusion::Fuse(std::vector<srunop> &ops,
+                       const std::unordered_set<std::string> &kept_names) {
+  std::unordered_map<std::string, srunop> op_map;
+  for (const auto &op : ops) {
+    op_map.insert({op->name, op});
+  }
+
+  // 按原有顺序尝试以每个节点为首节点匹配，被融合的节点不再参与匹配
+  uint32_t fused_count = 0;
+  std::unordered_set<std::string> fused_names;
+  for (const auto &op : ops) {
+    if (fused_names.find(op->name) != fused_names.end()) {
+      continue;
+    }
+    for (const FusionPattern &pattern : Patterns()) {
+      std::vector<srunop> chain;
+      if (!Match(op, pattern, chain)) {
+        continue;
+      }
+      // 输出须保留的节点融合后只有作为末节点时，其输出才等于首节点的输出
+      bool kept_inside = false;
+      for (uint32_t i = 0; i + 1 < chain.size(); ++i) {
+        if (kept_names.find(chain.at(i)->name) != kept_names.end()) {
+          kept_inside = true;
+          break;
+        }
+      }
+      if (kept_inside) {
+        continue;
+      }
+      Rewrite(chain, op_map);
+      for (uint32_t i = 1; i < chain.size(); ++i) {
+        fused_names.insert(chain.at(i)->name);
+      }
+      fused_count += 1;
+      break;
+    }
+  }
+
+  // 从计算图中移除被融合的节点
+  std::vector<srunop> fused_ops;
+  fused_ops.reserve(ops.size() - fused_names.size());
+  for (const auto &op : ops) {
+    if (fused_names.find(op->name) == fused_names.end()) {
+      fused_ops.push_back(op);
+    }
+  }
+  ops = std::move(fused_ops);
+  return fused_count;
+}
+
+srunop OpFusion::FindFusedHead(const std::vector<srunop> &ops,
+                               const std::string &name) {
+  for (const auto &op : ops) {
+    const auto &fused_ops = op->params.find("fused_ops");
+    if (fused_ops == op->params.end()) {
+      continue;
+    }
+    const auto fused_param =
+        dynamic_cast<RuntimeParamStrArr *>(fused_ops->second);
+    if (fused_param != nullptr &&
+        std::find(fused_param->value.begin(), fused_param->value.end(),
+                  name) != fused_param->value.end()) {
+      return op;
+    }
+  }
+  return nullptr;
+}
+
+bool OpFusion::Match(const srunop &head, const FusionPattern &pattern,
+                     std::vector<srunop> &chain) {
+  const auto &op_types = pattern.op_types;
+  CHECK(op_types.size() >= 2) << "The fusion pattern is too short";
+  // 首节点只有一个输入，且尚未融合过其他节点
+  if (head->type != op_types.front() || head->in_oprands_seq.size() != 1 ||
+      head->out_oprand == nullptr ||
+      head->params.find("fused_ops") != head->params.end()) {
+    return false;
+  }
+
+  chain = {head};
+  srunop cur_op = head;
+  for (uint32_t i = 1; i < op_types.size(); ++i) {
+    // 中间结果只能被链上的下一个节点使用
+    if (cur_op->out_ops.size() != 1) {
+      return false;
+    }
+    const srunop next_op = cur_op->out_ops.begin()->second;
+    if (next_op == nullptr || next_op->type != op_types.at(i) ||
+        next_op->out_oprand == nullptr ||
+        next_op->out_oprand->shape != head->out_oprand->shape) {
+      return false;
+    }
+
+    if (next_op->type == "pnnx.Expression") {
+      // 表达式须为两个不同来源的逐元素相加，另一个来源与首节点输出的维度相同
+      const auto &expr = next_op->params.find("expr");
+      if (expr == next_op->params.end()) {
+        return false;
+      }
+      const auto expr_param = dynamic_cast<RuntimeParamStr *>(expr->second);
+      if (expr_param == nullptr || expr_param->value != pattern.expr ||
+          next_op->in_oprands.size() != 2 ||
+          next_op->in_oprands_seq.size() != 2) {
+        return false;
+      }
+      for (const auto &in_oprand : next_op->in_oprands_seq) {
+        if (in_oprand->name == cur_op->name) {
+          continue;
+        }
+        // 残差来自首节点的输入时，首节点的两个输入来源相同，无法区分
+        if (head->in_oprands.find(in_oprand->name) != head->in_oprands.end() ||
+            in_oprand->shape != head->out_oprand->shape) {
+          return false;
+        }
+      }
+    } else if (next_op->in_oprands_seq.size() != 1) {
+      return false;
+    }
+
+    chain.push_back(next_op);
+    cur_op = next_op;
+  }
+  return true;
+}
+
+void OpFusion::Rewrite(const std::vector<srunop> &chain,
+                       const std::unordered_map<std::string, srunop> &op_map) {
+  const srunop &head = chain.front();
+  const srunop &tail = chain.back();
+  auto fused_ops = new RuntimeParamStrArr;
+
+  for (uint32_t i = 1; i < chain.size(); ++i) {
+    const srunop &op = chain.at(i);
+    fused_ops->value.push_back(op->name);
+
+    if (op->type == "pnnx.Expression") {
+      // 表达式的另一个输入作为首节点的第二个输入（残差）
+      for (const auto &in_oprand : op->in_oprands_seq) {
+        if (in_oprand->name == chain.at(i - 1)->name) {
+          continue;
+        }
+        head->in_oprands_seq.push_back(in_oprand);
+        head->in_oprands.insert({in_oprand->name, in_oprand});
+
+        // 残差的生产节点改为输出到首节点
+        const srunop &producer = op_map.at(in_oprand->name);
+        producer->out_ops.erase(op->name);
+        producer->out_ops.insert({head->name, head});
+      }
+    } else if (i + 1 == chain.size()) {
+      // 末节点为激活节点时，由首节点完成激活
+      auto fused_activation = new RuntimeParamStr;
+      fused_activation->value = op->type;
+      head->params.insert({"fused_activation", fused_activation});
+    }
+  }
+  head->params.insert({"fused_ops", fused_ops});
+
+  // 末节点的后继节点改为接收首节点的输出
+  head->out_ops = tail->out_ops;
+  for (const auto &[_, next_op] : head->out_ops) {
+    auto in_oprand = next_op->in_oprands.find(tail->name);
+    CHECK(in_oprand != next_op->in_oprands.end())
+        << next_op->name << " has no input from " << tail->name;
+    srunoprand oprand = in_oprand->second;
+    next_op->in_oprands.erase(in_oprand);
+    oprand->name = head->name;
+    next_op->in_oprands.insert({head->name, oprand});
+  }
+}
+
+} // namespace TinyInfer
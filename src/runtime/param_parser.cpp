@@ -0,0 +1,544 @@
+#include "runtime/param_parser.hpp"
+#include "runtime/store_zip.hpp"
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <glog/logging.h>
+#include <string_view>
+#include <unordered_map>
+
+namespace TinyInfer {
+
+namespace {
+// 按空白拆分一行文本
+class Tokenizer {
+public:
+  explicit Tokenizer(std::string_view line) : line_(line) {}
+
+  bool Next(std::string_view &token) {
+    while (pos_ < line_.size() && IsSpace(line_[pos_])) {
+      ++pos_;
+    }
+    if (pos_ == line_.size()) {
+      return false;
+    }
+    const size_t start = pos_;
+    while (pos_ < line_.size() && !IsSpace(line_[pos_])) {
+      ++pos_;
+    }
+    token = line_.substr(start, pos_ - start);
+    return true;
+  }
+
+  // 尚未读取的部分
+  std::string_view Rest() const { return line_.substr(pos_); }
+
+private:
+  static bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  std::string_view line_;
+  size_t pos_ = 0;
+};
+
+// 逐行读取映射内存中的文本
+class LineReader {
+public:
+  explicit LineReader(std::string_view text) : text_(text) {}
+
+  bool Next(std::string_view &line) {
+    if (pos_ >= text_.size()) {
+      return false;
+    }
+    size_t end = text_.find('\n', pos_);
+    if (end == std::string_view::npos) {
+      end = text_.size();
+    }
+    line = text_.substr(pos_, end - pos_);
+    pos_ = end + 1;
+    line_num_ += 1;
+    return true;
+  }
+
+  uint32_t line_num() const { return line_num_; }
+
+private:
+  std::string_view text_;
+  size_t pos_ = 0;
+  uint32_t line_num_ = 0;
+};
+
+// 操作数，名称为其在结构文件中的名称
+struct OperandInfo {
+  std::string_view name;
+  int32_t producer = -1; // 生产节点的下标
+  int type = 0; // 值类型：0=null 1=f32 2=f64 3=f16 4=i32 ...，与pnnx相同
+  std::vector<int32_t> shape;
+};
+
+// 节点对操作数维度的标注（#）
+struct ShapeNote {
+  uint32_t operand = 0; // 操作数下标
+  int type = 0;
+  std::vector<int32_t> shape;
+};
+
+// 节点所在行：第一遍解析引用的操作数，其余部分留到第二遍并行解析
+struct OpLine {
+  std::vector<uint32_t> inputs;  // 输入操作数下标
+  std::vector<uint32_t> outputs; // 输出操作数下标
+  std::string_view items;        // 尚未解析的key=value部分
+  uint32_t line_num = 0;         // 行号，用于报错
+  std::vector<ShapeNote> shapes; // 操作数维度的标注，按出现顺序排列
+  std::string error;             // 第二遍及之后的解析错误，为空表示成功
+};
+
+template <typename T> bool ParseNumber(std::string_view str, T &value) {
+  const char *end = str.data() + str.size();
+  const auto [ptr, ec] = std::from_chars(str.data(), end, value);
+  return ec == std::errc() && ptr == end;
+}
+
+// 与pnnx相同：不以数字或负号加数字开头的值为字符串
+bool IsStringValue(std::string_view value) {
+  const auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+  if (value.empty()) {
+    return true;
+  }
+  if (value[0] == '-') {
+    return value.size() < 2 || !is_digit(value[1]);
+  }
+  return !is_digit(value[0]);
+}
+
+// 与pnnx相同：含有小数点或指数的数值为浮点数
+bool IsFloatValue(std::string_view value) {
+  return value.find('.') != std::string_view::npos ||
+         value.find('e') != std::string_view::npos;
+}
+
+int ParseDataType(std::string_view type) {
+  if (type == "f32") return 1;
+  if (type == "f64") return 2;
+  if (type == "f16") return 3;
+  if (type == "i32") return 4;
+  if (type == "i64") return 5;
+  if (type == "i16") return 6;
+  if (type == "i8") return 7;
+  if (type == "u8") return 8;
+  if (type == "bool") return 9;
+  if (type == "cp64") return 10;
+  if (type == "cp128") return 11;
+  if (type == "cp32") return 12;
+  return 0;
+}
+
+/**
+ * 解析参数值，类型规则与pnnx::Parameter::parse_from_string相同
+ * @return 解析得到的参数，数值格式错误时返回空
+ */
+RuntimeParam *ParseParam(std::string_view value) {
+  if (value.empty() || value == "None" || value == "()" || value == "[]") {
+    return new RuntimeParam;
+  }
+
+  if (value == "True" || value == "False") {
+    auto param = new RuntimeParamBool;
+    param->value = value == "True";
+    return param;
+  }
+
+  if (value[0] == '(' || value[0] == '[') {
+    // 列表的类型由最后一个元素决定，与pnnx相同
+    RuntimeParamType type = RuntimeParamType::ParamUnknown;
+    std::vector<int> ints;
+    std::vector<float> floats;
+    std::vector<std::string> strs;
+    std::string_view list = value.substr(1, value.size() - 2);
+    while (true) {
+      const size_t comma = list.find(',');
+      const std::string_view elem = list.substr(0, comma);
+      if (IsStringValue(elem)) {
+        type = RuntimeParamType::ParamStrArray;
+        strs.emplace_back(elem);
+      } else if (IsFloatValue(elem)) {
+        type = RuntimeParamType::ParamFloatArray;
+        floats.push_back(0.f);
+        if (!ParseNumber(elem, floats.back())) {
+          return nullptr;
+        }
+      } else {
+        type = RuntimeParamType::ParamIntArray;
+        ints.push_back(0);
+        if (!ParseNumber(elem, ints.back())) {
+          return nullptr;
+        }
+      }
+      if (comma == std::string_view::npos) {
+        break;
+      }
+      list.remove_prefix(comma + 1);
+    }
+
+    if (type == RuntimeParamType::ParamIntArray) {
+      auto param = new RuntimeParamIntArr;
+      param->value = std::move(ints);
+      return param;
+    } else if (type == RuntimeParamType::ParamFloatArray) {
+      auto param = new RuntimeParamFloatArr;
+      param->value = std::move(floats);
+      return param;
+    } else {
+      auto param = new RuntimeParamStrArr;
+      param->value = std::move(strs);
+      return param;
+    }
+  }
+
+  if (IsStringValue(value)) {
+    auto param = new RuntimeParamStr;
+    param->value = std::string(value);
+    return param;
+  }
+
+  if (IsFloatValue(value)) {
+    auto param = new RuntimeParamFloat;
+    if (!ParseNumber(value, param->value)) {
+      delete param;
+      return nullptr;
+    }
+    return param;
+  }
+
+  auto param = new RuntimeParamInt;
+  if (!ParseNumber(value, param->value)) {
+    delete param;
+    return nullptr;
+  }
+  return param;
+}
+
+/**
+ * 解析形如(1,3,?,224)f32的维度和值类型，?表示动态维度，记为-1
+ * @return 是否解析成功
+ */
+bool ParseShape(std::string_view value, std::vector<int32_t> &shape,
+                int &type) {
+  const size_t close = value.find_last_of(')');
+  if (value.empty() || value[0] != '(' || close == std::string_view::npos) {
+    return false;
+  }
+  type = ParseDataType(value.substr(close + 1));
+
+  shape.clear();
+  std::string_view list = value.substr(1, close - 1);
+  while (!list.empty()) {
+    const size_t comma = list.find(',');
+    const std::string_view elem = list.substr(0, comma);
+    if (elem == "?") {
+      shape.push_back(-1);
+    } else {
+      shape.push_back(0);
+      if (!ParseNumber(elem, shape.back())) {
+        return false;
+      }
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    list.remove_prefix(comma + 1);
+  }
+  return true;
+}
+
+/**
+ * 解析节点的参数、权重属性和操作数维度标注，只读共享的操作数表和权重文件，可被多个线程同时调用
+ * @param op 计算图节点
+ * @param line 节点所在行，解析错误记录在其中
+ * @param operand_indices 操作数名称到下标的映射
+ * @param weight_reader 映射了权重文件的读取器
+ * @return 是否解析成功
+ */
+bool ParseItems(RuntimeOp &op, OpLine &line,
+                const std::unordered_map<std::string_view, uint32_t>
+                    &operand_indices,
+                const pnnx::StoreZipReader &weight_reader) {
+  // key=value：@权重属性，$输入名称，#操作数维度，其余为参数
+  Tokenizer tokenizer(line.items);
+  std::string_view token;
+  while (tokenizer.Next(token)) {
+    const size_t eq = token.find('=');
+    if (eq == std::string_view::npos || eq == 0) {
+      line.error = "Can not parse " + std::string(token);
+      return false;
+    }
+    const std::string_view key = token.substr(0, eq);
+    const std::string_view value = token.substr(eq + 1);
+
+    if (key[0] == '@') {
+      const std::string attr_name(key.substr(1));
+      srunattr attr = std::make_shared<RuntimeAttr>();
+      int attr_type = 0;
+      if (!ParseShape(value, attr->shape, attr_type) || attr_type != 1) {
+        line.error = "Unsupported attribute " + std::string(token);
+        return false;
+      }
+      attr->type = RuntimeDataType::TypeFloat32;
+
+      size_t elem_ct = attr->shape.empty() ? 0 : 1;
+      for (const int dim : attr->shape) {
+        elem_ct *= dim;
+      }
+      const std::string entry_name = op.name + "." + attr_name;
+      const char *entry_data = weight_reader.get_file_data(entry_name);
+      if (elem_ct > 0 && entry_data != nullptr) {
+        const size_t entry_size = weight_reader.get_file_size(entry_name);
+        if (entry_size != elem_ct * sizeof(float)) {
+          line.error = "The size of " + entry_name + " is " +
+                       std::to_string(entry_size) + ", expect " +
+                       std::to_string(elem_ct * sizeof(float));
+          return false;
+        }
+        attr->mapped_data = entry_data;
+        attr->mapped_size = entry_size;
+      }
+      op.attrs[attr_name] = attr;
+    } else if (key[0] == '$') {
+      // 输入名称，计算图不使用
+      continue;
+    } else if (key[0] == '#') {
+      // 只能标注当前节点的输入、输出操作数
+      const auto iter = operand_indices.find(key.substr(1));
+      const bool own_operand =
+          iter != operand_indices.end() &&
+          (std::find(line.inputs.begin(), line.inputs.end(), iter->second) !=
+               line.inputs.end() ||
+           std::find(line.outputs.begin(), line.outputs.end(),
+                     iter->second) != line.outputs.end());
+      if (!own_operand) {
+        LOG(WARNING) << "No such operand " << key.substr(1) << " for operator "
+                     << op.name;
+        continue;
+      }
+      ShapeNote note;
+      note.operand = iter->second;
+      if (!ParseShape(value, note.shape, note.type)) {
+        line.error = "Can not parse the shape " + std::string(token);
+        return false;
+      }
+      line.shapes.push_back(std::move(note));
+    } else {
+      RuntimeParam *param = ParseParam(value);
+      if (param == nullptr) {
+        line.error = "Can not parse the parameter " + std::string(token);
+        return false;
+      }
+      RuntimeParam *&slot = op.params[std::string(key)];
+      delete slot;
+      slot = param;
+    }
+  }
+  return true;
+}
+
+/**
+ * 按操作数的最终维度初始化节点的输入、输出操作数，可被多个线程同时调用
+ * @param op 计算图节点
+ * @param line 节点所在行，错误记录在其中
+ * @param operands 所有操作数
+ * @param ops 所有计算图节点，用于查找输入操作数的生产节点
+ * @return 是否初始化成功
+ */
+bool InitOperands(RuntimeOp &op, OpLine &line,
+                  const std::vector<OperandInfo> &operands,
+                  const std::vector<srunop> &ops) {
+  for (const uint32_t idx : line.inputs) {
+    const OperandInfo &operand = operands.at(idx);
+    // 注意：输入操作数名称是其生产节点名称
+    srunoprand in_oprand = std::make_shared<RuntimeOprand>();
+    in_oprand->name = ops.at(operand.producer)->name;
+    in_oprand->shape = operand.shape;
+    if (operand.type == 1) {
+      in_oprand->type = RuntimeDataType::TypeFloat32;
+    } else if (operand.type != 0) {
+      line.error =
+          "Unsupported input operand type: " + std::to_string(operand.type);
+      return false;
+    }
+    op.in_oprands_seq.push_back(in_oprand);
+    op.in_oprands.insert({in_oprand->name, in_oprand});
+  }
+
+  if (line.outputs.size() > 1) {
+    line.error = "One operator has <= one output oprand in TinyInfer: " + op.name;
+    return false;
+  }
+  if (!line.outputs.empty()) {
+    const OperandInfo &operand = operands.at(line.outputs.front());
+    srunoprand out_oprand = std::make_shared<RuntimeOprand>();
+    out_oprand->name = std::string(operand.name) + "_output";
+    out_oprand->shape = operand.shape;
+    out_oprand->type = RuntimeDataType::TypeFloat32;
+    op.out_oprand = std::move(out_oprand);
+  }
+  return true;
+}
+
+/**
+ * 并行处理每个节点，处理完毕后按节点顺序报告第一个错误
+ * @return 是否所有节点都处理成功
+ */
+bool ForEachOp(ThreadPool *pool, const std::string &param_path,
+               std::vector<srunop> &ops, std::vector<OpLine> &lines,
+               const std::function<bool(RuntimeOp &, OpLine &)> &func) {
+  ParallelFor(pool, ops.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      func(*ops.at(i), lines.at(i));
+    }
+  });
+  for (const OpLine &line : lines) {
+    if (!line.error.empty()) {
+      LOG(ERROR) << param_path << ":" << line.line_num << ": " << line.error;
+      ops.clear();
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+bool ParamParser::Parse(const std::string &param_path,
+                        const std::string &bin_path, std::vector<srunop> &ops,
+                        std::shared_ptr<MappedFile> &weight_file,
+                        ThreadPool *pool) {
+  ops.clear();
+  weight_file.reset();
+
+  const std::shared_ptr<MappedFile> param_file = MappedFile::Open(param_path);
+  if (param_file == nullptr) {
+    return false;
+  }
+
+  // 权重文件映射到内存中，权重属性直接指向其中的内存；压缩的权重在线程池中并行解压到内存中
+  pnnx::StoreZipReader weight_reader;
+  if (weight_reader.open(bin_path, true, pool) != 0) {
+    LOG(ERROR) << "Can not open the bin file: " << bin_path;
+    return false;
+  }
+
+  LineReader reader(std::string_view(
+      reinterpret_cast<const char *>(param_file->data()), param_file->size()));
+  std::string_view line;
+  std::string_view token;
+  const auto parse_error = [&](const std::string &message) {
+    LOG(ERROR) << param_path << ":" << reader.line_num() << ": " << message;
+    ops.clear();
+    return false;
+  };
+
+  // 第一行为magic number，第二行为节点数目和操作数数目
+  uint32_t op_count = 0;
+  uint32_t operand_count = 0;
+  if (!reader.Next(line) || !reader.Next(line)) {
+    return parse_error("The param file is truncated");
+  }
+  {
+    Tokenizer tokenizer(line);
+    if (!tokenizer.Next(token) || !ParseNumber(token, op_count) ||
+        !tokenizer.Next(token) || !ParseNumber(token, operand_count)) {
+      return parse_error("Can not read the operator and operand count");
+    }
+  }
+
+  std::vector<OperandInfo> operands;
+  std::unordered_map<std::string_view, uint32_t> operand_indices;
+  std::vector<OpLine> op_lines(op_count);
+  operands.reserve(operand_count);
+  operand_indices.reserve(operand_count);
+  ops.reserve(op_count);
+
+  // 第一遍：依次读取节点类型、名称和引用的操作数，操作数表只在这一遍中修改
+  for (uint32_t i = 0; i < op_count; ++i) {
+    if (!reader.Next(line)) {
+      return parse_error("The param file is truncated");
+    }
+    Tokenizer tokenizer(line);
+
+    // 节点类型、名称，输入、输出操作数数目
+    srunop op = std::make_shared<RuntimeOp>();
+    uint32_t input_count = 0;
+    uint32_t output_count = 0;
+    std::string_view type;
+    std::string_view name;
+    if (!tokenizer.Next(type) || !tokenizer.Next(name) ||
+        !tokenizer.Next(token) || !ParseNumber(token, input_count) ||
+        !tokenizer.Next(token) || !ParseNumber(token, output_count)) {
+      return parse_error("Can not read the operator");
+    }
+    op->type = std::string(type);
+    op->name = std::string(name);
+
+    // 输入操作数，同时记录生产节点的后继节点
+    OpLine &op_line = op_lines.at(i);
+    op_line.line_num = reader.line_num();
+    for (uint32_t j = 0; j < input_count; ++j) {
+      if (!tokenizer.Next(token)) {
+        return parse_error("Can not read the input operands of " + op->name);
+      }
+      const auto iter = operand_indices.find(token);
+      if (iter == operand_indices.end()) {
+        return parse_error("Undefined operand " + std::string(token));
+      }
+      op_line.inputs.push_back(iter->second);
+      const int32_t producer = operands.at(iter->second).producer;
+      ops.at(producer)->out_ops.insert({op->name, nullptr});
+    }
+
+    // 输出操作数，同名时保留先定义的操作数，与pnnx相同
+    for (uint32_t j = 0; j < output_count; ++j) {
+      if (!tokenizer.Next(token)) {
+        return parse_error("Can not read the output operands of " + op->name);
+      }
+      OperandInfo operand;
+      operand.name = token;
+      operand.producer = int32_t(i);
+      operands.push_back(std::move(operand));
+      operand_indices.insert({token, uint32_t(operands.size() - 1)});
+      op_line.outputs.push_back(operands.size() - 1);
+    }
+    op_line.items = tokenizer.Rest();
+    ops.push_back(op);
+  }
+
+  // 第二遍：各节点的参数、权重属性和维度标注互不依赖，并行解析
+  if (!ForEachOp(pool, param_path, ops, op_lines,
+                 [&](RuntimeOp &op, OpLine &op_line) {
+                   return ParseItems(op, op_line, operand_indices,
+                                     weight_reader);
+                 })) {
+    return false;
+  }
+
+  // 同一操作数可能被多个节点标注，按节点顺序应用，以后出现的标注为准
+  for (const OpLine &op_line : op_lines) {
+    for (const ShapeNote &note : op_line.shapes) {
+      OperandInfo &operand = operands.at(note.operand);
+      operand.shape = note.shape;
+      operand.type = note.type;
+    }
+  }
+
+  // 第三遍：操作数的维度和值类型已确定，并行初始化节点的输入、输出操作数
+  if (!ForEachOp(pool, param_path, ops, op_lines,
+                 [&](RuntimeOp &op, OpLine &op_line) {
+                   return InitOperands(op, op_line, operands, ops);
+                 })) {
+    return false;
+  }
+
+  weight_file = weight_reader.get_mapped_file();
+  return true;
+}
+
+} // namespace TinyInfer
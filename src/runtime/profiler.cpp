@@ -0,0 +1,171 @@
+#include "runtime/profiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <glog/logging.h>
+#include <iomanip>
+#include <map>
+#include <numeric>
+#include <sstream>
+
+namespace TinyInfer {
+
+namespace {
+// 维度转换为(c, h, w)形式的字符串
+std::string ShapeToString(const std::vector<uint32_t> &shape) {
+  std::string str = "(";
+  for (uint32_t i = 0; i < shape.size(); ++i) {
+    if (i > 0) {
+      str += ", ";
+    }
+    str += std::to_string(shape.at(i));
+  }
+  return str + ")";
+}
+
+// 转义JSON字符串中的特殊字符
+std::string EscapeJson(const std::string &str) {
+  std::string escaped;
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      escaped += ' ';
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+} // namespace
+
+void Profiler::Begin(uint32_t step_num) {
+  records_.assign(step_num, ProfileRecord());
+  starts_.assign(step_num, Clock::time_point());
+  ends_.assign(step_num, Clock::time_point());
+  threads_.assign(step_num, std::thread::id());
+  begin_ = Clock::now();
+  end_ = begin_;
+}
+
+void Profiler::Record(uint32_t step_idx, ProfileRecord record,
+                      Clock::time_point start, Clock::time_point end) {
+  // 每个步骤只写自己的位置，并发执行时不需要加锁
+  records_.at(step_idx) = std::move(record);
+  starts_.at(step_idx) = start;
+  ends_.at(step_idx) = end;
+  threads_.at(step_idx) = std::this_thread::get_id();
+}
+
+void Profiler::End() {
+  end_ = Clock::now();
+
+  // 线程按首次执行步骤的时刻编号，调用Forward的线程通常为0
+  std::vector<uint32_t> order(records_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+    return starts_.at(a) < starts_.at(b);
+  });
+  std::map<std::thread::id, uint32_t> thread_ids;
+  for (const uint32_t idx : order) {
+    const auto iter =
+        thread_ids.insert({threads_.at(idx), uint32_t(thread_ids.size())});
+    records_.at(idx).thread_id = iter.first->second;
+  }
+
+  using Micros = std::chrono::duration<double, std::micro>;
+  for (uint32_t i = 0; i < records_.size(); ++i) {
+    ProfileRecord &record = records_.at(i);
+    record.start_us = Micros(starts_.at(i) - begin_).count();
+    record.end_us = Micros(ends_.at(i) - begin_).count();
+  }
+}
+
+const std::vector<ProfileRecord> &Profiler::records() const {
+  return records_;
+}
+
+double Profiler::total_us() const {
+  return std::chrono::duration<double, std::micro>(end_ - begin_).count();
+}
+
+bool Profiler::ExportChromeTrace(const std::string &path) const {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    LOG(ERROR) << "Can not open the trace file: " << path;
+    return false;
+  }
+
+  // 每个节点对应一个完整事件（ph为X），时间单位为微秒
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (uint32_t i = 0; i < records_.size(); ++i) {
+    const ProfileRecord &record = records_.at(i);
+    if (i > 0) {
+      file << ",";
+    }
+    file << "\n{\"name\":\"" << EscapeJson(record.name) << "\",\"cat\":\""
+         << EscapeJson(record.type) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+         << record.thread_id << ",\"ts\":" << record.start_us
+         << ",\"dur\":" << record.duration_us() << ",\"args\":{";
+    file << "\"batch\":" << record.batch << ",\"input_shapes\":\"";
+    for (uint32_t j = 0; j < record.input_shapes.size(); ++j) {
+      file << (j > 0 ? " " : "") << ShapeToString(record.input_shapes.at(j));
+    }
+    file << "\",\"output_shape\":\"" << ShapeToString(record.output_shape)
+         << "\",\"flops\":" << record.flops << ",\"bytes\":" << record.bytes;
+    if (!record.fused_ops.empty()) {
+      file << ",\"fused_ops\":\"";
+      for (uint32_t j = 0; j < record.fused_ops.size(); ++j) {
+        file << (j > 0 ? " " : "") << EscapeJson(record.fused_ops.at(j));
+      }
+      file << "\"";
+    }
+    file << "}}";
+  }
+  file << "\n]}\n";
+  return file.good();
+}
+
+std::string Profiler::TopTable(uint32_t top_n) const {
+  std::vector<uint32_t> order(records_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+    return records_.at(a).duration_us() > records_.at(b).duration_us();
+  });
+  if (order.size() > top_n) {
+    order.resize(top_n);
+  }
+
+  double busy_us = 0.; // 各节点耗时之和，并发执行时可能大于整次推理的耗时
+  for (const ProfileRecord &record : records_) {
+    busy_us += record.duration_us();
+  }
+
+  std::ostringstream table;
+  table << std::fixed << std::setprecision(3);
+  table << std::left << std::setw(6) << "rank" << std::setw(28) << "name"
+        << std::setw(18) << "type" << std::right << std::setw(12) << "time(ms)"
+        << std::setw(9) << "ratio" << std::setw(12) << "GFLOP/s"
+        << std::setw(12) << "GB/s" << std::setw(8) << "thread"
+        << "  output\n";
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    const ProfileRecord &record = records_.at(order.at(i));
+    const double duration_us = record.duration_us();
+    const double ratio = busy_us > 0. ? duration_us / busy_us * 100. : 0.;
+    // 每微秒的运算次数乘以1e-3即为GFLOP/s，访存带宽同理
+    const double gflops = duration_us > 0. ? record.flops / duration_us * 1e-3 : 0.;
+    const double gbytes = duration_us > 0. ? record.bytes / duration_us * 1e-3 : 0.;
+    table << std::left << std::setw(6) << i + 1 << std::setw(28) << record.name
+          << std::setw(18) << record.type << std::right << std::setw(12)
+          << duration_us / 1000. << std::setw(8) << ratio << "%"
+          << std::setw(12) << gflops << std::setw(12) << gbytes << std::setw(8)
+          << record.thread_id << "  " << record.batch << "x"
+          << ShapeToString(record.output_shape) << "\n";
+  }
+  table << "total: " << total_us() / 1000. << " ms, sum of nodes: "
+        << busy_us / 1000. << " ms\n";
+  return table.str();
+}
+
+} // namespace TinyInfer
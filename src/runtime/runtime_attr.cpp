@@ -7,6 +7,9 @@ void RuntimeAttr::clear() {
     std::vector<char> tmp = std::vector<char>();
     this->weight_data.swap(tmp);
   }
+  // 映射的权重值由权重文件持有，这里只解除引用
+  this->mapped_data = nullptr;
+  this->mapped_size = 0;
 }
 
 } // namespace TinyInfer
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "runtime/runtime_graph.hpp"
+#include "kernel/abstract/attr_kernel.hpp"
 #include "kernel/abstract/kernel_factory.hpp"
+#include "runtime/op_fusion.hpp"
+#include "runtime/param_parser.hpp"
 #include "tick.hpp"
 #include <algorithm>
+#include <chrono>
 #include <deque>
 #include <iostream>
 #include <memory>
@@ -12,6 +16,29 @@
 
 namespace TinyInfer {
 
+namespace {
+// 各输入的维度转换为(c, h, w)形式的字符串，以空格分隔
+std::string ShapesToString(const std::vector<std::vector<uint32_t>> &shapes) {
+  std::string str;
+  for (const auto &shape : shapes) {
+    if (!str.empty()) {
+      str += " ";
+    }
+    str += "(" + std::to_string(shape.at(0)) + ", " +
+           std::to_string(shape.at(1)) + ", " + std::to_string(shape.at(2)) +
+           ")";
+  }
+  return str;
+}
+
+// 从start到现在经过的毫秒数
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+} // namespace
+
 RuntimeGraph::RuntimeGraph(std::string param_path, std::string bin_path)
     : param_path_(std::move(param_path)), bin_path_(std::move(bin_path)),
       graph_state_(GraphState::NeedInit) {}
@@ -30,70 +57,24 @@ const std::string &RuntimeGraph::param_path() const {
 
 const std::string &RuntimeGraph::bin_path() const { return this->bin_path_; }
 
-bool RuntimeGraph::Init() {
+bool RuntimeGraph::Init(ThreadPool *pool) {
   if (this->param_path_.empty() || this->bin_path_.empty()) {
     LOG(ERROR) << "The param file path or bin file path is empty";
     return false;
   }
 
-  // 加载pnnx格式的计算图
-  this->graph_ = std::make_unique<pnnx::Graph>();
-  int load_result = this->graph_->load(param_path_, bin_path_);
-  if (load_result != 0) {
+  // 单遍解析结构文件，直接构造计算图节点；权重文件映射到内存中，不复制权重值
+  if (!ParamParser::Parse(param_path_, bin_path_, this->ops_,
+                          this->mapped_model_, pool)) {
     LOG(ERROR) << "Load param file path and bin file path error: "
                << param_path_ << " " << bin_path_;
     return false;
   }
-
-  // 读取pnnx计算图中的节点
-  std::vector<pnnx::Operator *> pnnx_ops = this->graph_->ops;
-  if (pnnx_ops.empty()) {
-    LOG(ERROR) << "Can not read the pnnx runtime graph operators";
+  if (this->ops_.empty()) {
+    LOG(ERROR) << "Can not read the runtime graph operators";
     return false;
   }
 
-  // 依据pnnx计算图节点构造TinyInfer计算图节点
-  this->ops_.clear();
-  for (const pnnx::Operator *pnnx_op : pnnx_ops) {
-    if (!pnnx_op) {
-      LOG(ERROR) << "Meet the empty operator";
-      continue;
-    } else {
-      srunop op = std::make_shared<RuntimeOp>();
-      // 初始化节点名称、类型
-      op->name = pnnx_op->name;
-      op->type = pnnx_op->type;
-
-      // 初始化节点的输入操作数
-      // 包括操作数名称、维度、值类型
-      const std::vector<pnnx::Operand *> &inputs = pnnx_op->inputs;
-      if (!inputs.empty()) {
-        InitOpInputs(inputs, op);
-      }
-
-      // 初始化节点的输出操作数
-      // 注意：这里仅记录了当前节点的后继节点名称！
-      const std::vector<pnnx::Operand *> &outputs = pnnx_op->outputs;
-      if (!outputs.empty()) {
-        InitOpOutputs(outputs, op);
-      }
-
-      // 初始化节点的参数
-      const std::map<std::string, pnnx::Parameter> &params = pnnx_op->params;
-      if (!params.empty()) {
-        InitOpParams(params, op);
-      }
-
-      // 初始化节点的权重
-      const std::map<std::string, pnnx::Attribute> &attrs = pnnx_op->attrs;
-      if (!attrs.empty()) {
-        InitOpAttrs(attrs, op);
-      }
-
-      // 保存构造好的节点
-      this->ops_.push_back(op);
-    }
-  }
   // 初始化完毕，更新计算图状态为待构建
   graph_state_ = GraphState::NeedBuild;
 
@@ -102,67 +83,129 @@ bool RuntimeGraph::Init() {
 
 void RuntimeGraph::Build(const std::string &input_name,
                          const std::string &output_name) {
+  Build(std::vector<std::string>{input_name},
+        std::vector<std::string>{output_name});
+}
+
+void RuntimeGraph::Build(const std::vector<std::string> &input_names,
+                         const std::vector<std::string> &output_names) {
+  CHECK(!input_names.empty()) << "The input operator names are empty";
+  CHECK(!output_names.empty()) << "The output operator names are empty";
+  CHECK(std::unordered_set<std::string>(input_names.begin(), input_names.end())
+            .size() == input_names.size())
+      << "The input operator names are repeated";
+  CHECK(std::unordered_set<std::string>(output_names.begin(),
+                                        output_names.end())
+            .size() == output_names.size())
+      << "The output operator names are repeated";
+
+  if (graph_state_ == GraphState::Complete) {
+    return;
+  }
+
+  // 初始化、构建时使用的线程池，构建完毕后销毁
+  const std::unique_ptr<ThreadPool> build_pool = CreateBuildPool();
+  startup_timings_ = StartupTimings();
+  startup_timings_.threads = build_pool ? build_pool->thread_num() : 1;
+  auto phase_start = std::chrono::steady_clock::now();
+
   if (graph_state_ == GraphState::NeedInit) {
-    bool init_graph = Init();
+    bool init_graph = Init(build_pool.get());
     CHECK(init_graph == true) << "Init graph failed!";
   }
 
   CHECK(graph_state_ >= GraphState::NeedBuild)
       << "Graph status error, current state is " << int(graph_state_);
 
-  if (graph_state_ == GraphState::Complete) {
-    return;
-  }
-
   CHECK(!this->ops_.empty()) << "Graph operators are empty, may be no init";
+  startup_timings_.init_ms = ElapsedMs(phase_start);
+  phase_start = std::chrono::steady_clock::now();
 
   // ! 构建计算图——遍历每个孤立的计算节点，将其与后继节点相连
+  std::unordered_map<std::string, srunop> op_map;
+  op_map.reserve(this->ops_.size());
+  for (const auto &op : this->ops_) {
+    op_map.insert({op->name, op});
+  }
   for (const auto &cur_op : this->ops_) {
-    // 获取当前节点的后继节点（仅有名称）
-    auto &out_ops = cur_op->out_ops;
-    for (const auto &next_op : this->ops_) {
-      if (next_op == cur_op) {
-        continue;
-      }
-      // 根据名称找到后继节点并保存
-      if (out_ops.find(next_op->name) != out_ops.end()) {
-        out_ops.at(next_op->name) = next_op;
+    // 获取当前节点的后继节点（仅有名称），根据名称找到后继节点并保存
+    for (auto &[name, next_op] : cur_op->out_ops) {
+      const auto iter = op_map.find(name);
+      if (iter != op_map.end() && iter->second != cur_op) {
+        next_op = iter->second;
       }
     }
   }
 
-  // 构造节点的计算Kernel
-  // 注意：单独保存输入、输出节点，不用构造Kernel
+  // 初始化节点的输入、输出空间
+  RuntimeOpUtils::InitOpsInput(this->ops_);
+  RuntimeOpUtils::InitOpsOutput(this->ops_);
+
+  input_names_ = input_names;
+  output_names_ = output_names;
+
+  // 融合卷积与其后的残差相加、激活节点，被融合的节点不再构造Kernel
+  // 作为输出的中间节点只能作为末节点被融合，以保留其输出
+  if (fuse_ops_) {
+    const uint32_t fused_count = OpFusion::Fuse(
+        this->ops_, std::unordered_set<std::string>(output_names.begin(),
+                                                    output_names.end()));
+    LOG(INFO) << "Fused " << fused_count << " operator chains";
+  }
+
+  // 单独保存输入、输出节点，不用构造Kernel
   this->input_ops.clear();
   this->output_ops.clear();
-
   for (const auto &op : this->ops_) {
     if (op->type == "pnnx.Input") {
       this->input_ops.insert({op->name, op});
     } else if (op->type == "pnnx.Output") {
       this->output_ops.insert({op->name, op});
-    } else {
-      skernel kernel = RuntimeGraph::CreateKernel(op);
-      CHECK(kernel != nullptr) << "Kernel create failed!";
-      // 将计算节点op和算子kernel绑定起来
-      op->kernel = kernel;
-      kernel->set_runtime_op(op);
     }
   }
 
-  // 初始化节点的输入、输出空间
-  RuntimeOpUtils::InitOpsInput(this->ops_);
-  RuntimeOpUtils::InitOpsOutput(graph_->ops, this->ops_);
+  // 找到计算图输入、输出所在的槽位，并标记输出依赖的节点
+  ResolveGraphIO();
 
-  graph_state_ = GraphState::Complete;
-  input_name_ = input_name;
-  output_name_ = output_name;
+  startup_timings_.link_ms = ElapsedMs(phase_start);
+  phase_start = std::chrono::steady_clock::now();
+
+  // 构造节点的计算Kernel；使用跨进程的权重段时，段已存在则直接使用其中的权重，否则构造后创建
+  const bool publish_segment =
+      !weight_segment_name_.empty() && !AttachWeightSegment();
+  CreateKernels(build_pool.get());
+  if (publish_segment) {
+    PublishWeightSegment();
+  }
+  startup_timings_.kernel_ms = ElapsedMs(phase_start);
+  phase_start = std::chrono::steady_clock::now();
 
-  // 销毁pnnx计算图
-  if (graph_ != nullptr) {
-    graph_.reset();
-    graph_ = nullptr;
+  // 生成静态执行计划，Forward时直接按计划顺序执行
+  BuildExecPlan();
+  InitDefaultLayout();
+
+  // 依据执行计划复用中间激活Tensor的内存
+  PlanActivationMemory();
+
+  // 激活Tensor由执行上下文持有，计算图节点不再保留输出空间
+  for (const auto &op : this->ops_) {
+    if (op->out_oprand != nullptr) {
+      op->out_oprand->data.clear();
+    }
+  }
+
+  if (max_concurrent_ops_ > 1) {
+    op_pool_ = std::make_unique<ThreadPool>(max_concurrent_ops_);
   }
+  startup_timings_.plan_ms = ElapsedMs(phase_start);
+
+  LOG(INFO) << "Startup with " << startup_timings_.threads
+            << " threads, init: " << startup_timings_.init_ms
+            << "ms, link: " << startup_timings_.link_ms
+            << "ms, kernel: " << startup_timings_.kernel_ms
+            << "ms, plan: " << startup_timings_.plan_ms << "ms";
+
+  graph_state_ = GraphState::Complete;
 }
 
 std::vector<sftensor> RuntimeGraph::Forward(const std::vector<sftensor> &inputs,
@@ -171,109 +214,321 @@ std::vector<sftensor> RuntimeGraph::Forward(const std::vector<sftensor> &inputs,
   if (graph_state_ < GraphState::Complete) {
     LOG(FATAL) << "Graph need be build!";
   }
-  CHECK(graph_state_ == GraphState::Complete)
-      << "Graph status error, current state is " << int(graph_state_);
 
-  // 找到计算图的输入节点
-  srunop input_op;
-  if (input_ops.find(input_name_) == input_ops.end()) {
-    LOG(FATAL) << "Can not find the input operator: " << input_name_;
-  } else {
-    input_op = input_ops.at(input_name_);
+  // 首次推理或执行计划变化后，重新创建默认的执行上下文
+  if (default_context_ == nullptr ||
+      default_context_->plan_version_ != plan_version_) {
+    default_context_ = CreateContext();
   }
+  return Forward(*default_context_, inputs, debug);
+}
 
-  // 找到计算图的输出节点
-  srunop output_op;
-  if (output_ops.find(output_name_) == output_ops.end()) {
-    LOG(FATAL) << "Can not find the output operator: " << output_name_;
-  } else {
-    output_op = output_ops.at(output_name_);
+std::map<std::string, std::vector<sftensor>> RuntimeGraph::Forward(
+    const std::map<std::string, std::vector<sftensor>> &inputs, bool debug) {
+  // 检查计算图是否构建完毕
+  if (graph_state_ < GraphState::Complete) {
+    LOG(FATAL) << "Graph need be build!";
+  }
+
+  if (default_context_ == nullptr ||
+      default_context_->plan_version_ != plan_version_) {
+    default_context_ = CreateContext();
+  }
+  return Forward(*default_context_, inputs, debug);
+}
+
+std::unique_ptr<ExecutionContext> RuntimeGraph::CreateContext() const {
+  CHECK(graph_state_ == GraphState::Complete) << "Graph need be build!";
+
+  // 激活Tensor在第一次推理、已知批次大小时创建
+  std::unique_ptr<ExecutionContext> context(
+      new ExecutionContext(this, plan_version_));
+  context->slot_tensors_.resize(ops_.size());
+  context->slots_.assign(ops_.size(), nullptr);
+  context->in_bufs_.resize(exec_plan_.size());
+  context->pending_deps_ =
+      std::make_unique<std::atomic<uint32_t>[]>(exec_plan_.size());
+  return context;
+}
+
+void RuntimeGraph::PrepareContext(
+    ExecutionContext &context,
+    const std::shared_ptr<const ActivationLayout> &layout,
+    uint32_t batch) const {
+  if (context.layout_ == layout && context.batch_ == batch) {
+    return;
   }
 
-  // 计算图执行的辅助队列——基于BFS执行计算图！
-  std::deque<srunop> ops_que;
-  // 输入节点入队
-  ops_que.push_back(input_op);
+  // 所需内存超过arena的容量时重新开辟，否则复用
+  const size_t arena_bytes = layout->planned_bytes * batch;
+  if (context.arena_ == nullptr || context.arena_->size() < arena_bytes) {
+    context.arena_ = std::make_unique<MemoryArena>(arena_bytes);
+  }
+
+  // 计算图的输出Tensor单独开辟，维度不变时只增不减
+  // 多个输出节点使用同一个节点的输出时，只开辟一份
+  context.output_tensors_.resize(output_slots_.size());
+  for (uint32_t i = 0; i < output_slots_.size(); ++i) {
+    const uint32_t slot = output_slots_.at(i);
+    if (std::find(output_slots_.begin(), output_slots_.begin() + i, slot) !=
+        output_slots_.begin() + i) {
+      continue;
+    }
+    const SlotLayout &output_info = layout->slots.at(slot);
+    auto &output_tensors = context.output_tensors_.at(i);
+    if (!output_tensors.empty()) {
+      const sftensor &output = output_tensors.front();
+      if (output->channels() != output_info.channels ||
+          output->rows() != output_info.rows ||
+          output->cols() != output_info.cols) {
+        output_tensors.clear();
+      }
+    }
+    while (output_tensors.size() < batch) {
+      output_tensors.push_back(std::make_shared<ftensor>(
+          output_info.channels, output_info.rows, output_info.cols));
+    }
+
+    auto &tensors = context.slot_tensors_.at(slot);
+    tensors.assign(output_tensors.begin(), output_tensors.begin() + batch);
+    context.slots_.at(slot) = &tensors;
+  }
+
+  // 按槽位布局创建一个批次的中间Tensor，它们是arena中的视图
+  for (uint32_t slot = 0; slot < layout->slots.size(); ++slot) {
+    const SlotLayout &info = layout->slots.at(slot);
+    if (!info.used || IsOutputSlot(slot) ||
+        std::find(input_slots_.begin(), input_slots_.end(), slot) !=
+            input_slots_.end()) {
+      continue;
+    }
+    CHECK(info.planned) << ops_.at(slot)->name << " output is not planned";
+    auto &tensors = context.slot_tensors_.at(slot);
+    uint8_t *block_ptr = context.arena_->data() + info.offset * batch;
+    tensors.clear();
+    tensors.reserve(batch);
+    for (uint32_t b = 0; b < batch; ++b) {
+      float *raw_ptr =
+          reinterpret_cast<float *>(block_ptr + b * info.sample_bytes);
+      tensors.push_back(std::make_shared<ftensor>(raw_ptr, info.channels,
+                                                  info.rows, info.cols));
+    }
+    context.slots_.at(slot) = &tensors;
+  }
+  context.layout_ = layout;
+  context.batch_ = batch;
+}
+
+std::shared_ptr<const ActivationLayout>
+RuntimeGraph::FindLayout(
+    const std::vector<std::vector<uint32_t>> &input_shapes) const {
+  if (input_shapes == default_layout_->input_shapes) {
+    return default_layout_;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(layout_mutex_);
+    const auto iter = layouts_.find(input_shapes);
+    if (iter != layouts_.end()) {
+      iter->second.last_use = ++layout_tick_;
+      return iter->second.layout;
+    }
+  }
+
+  // 新的输入维度：推断各节点输出的维度并规划内存
+  auto layout = std::make_shared<ActivationLayout>();
+  layout->input_shapes = input_shapes;
+  CHECK(InferLayout(*layout))
+      << "Can not infer the activation shapes for the input shape "
+      << ShapesToString(input_shapes);
+  PlanLayout(*layout);
+  LOG(INFO) << "Activation memory of input shape "
+            << ShapesToString(input_shapes) << " after planning: "
+            << layout->planned_bytes / (1024. * 1024.) << " MB per sample";
+
+  // 其他线程可能同时推断了相同的输入维度，以先放入缓存的为准
+  std::lock_guard<std::mutex> lock(layout_mutex_);
+  if (layouts_.size() >= kMaxCachedLayouts &&
+      layouts_.find(input_shapes) == layouts_.end()) {
+    // 移除最久未使用的布局；执行上下文持有自己正在使用的布局，从缓存中移除不影响其推理
+    const auto lru_iter = std::min_element(
+        layouts_.begin(), layouts_.end(), [](const auto &lhs, const auto &rhs) {
+          return lhs.second.last_use < rhs.second.last_use;
+        });
+    layouts_.erase(lru_iter);
+  }
+  CachedLayout &cached =
+      layouts_.emplace(input_shapes, CachedLayout{std::move(layout)})
+          .first->second;
+  cached.last_use = ++layout_tick_;
+  return cached.layout;
+}
+
+bool RuntimeGraph::InferLayout(ActivationLayout &layout) const {
+  layout.slots.assign(ops_.size(), SlotLayout());
+  CHECK(layout.input_shapes.size() == input_slots_.size());
+  for (uint32_t i = 0; i < input_slots_.size(); ++i) {
+    const auto &input_shape = layout.input_shapes.at(i);
+    SlotLayout &input_info = layout.slots.at(input_slots_.at(i));
+    input_info.used = true;
+    input_info.channels = input_shape.at(0);
+    input_info.rows = input_shape.at(1);
+    input_info.cols = input_shape.at(2);
+  }
+
+  // 执行计划是拓扑序，推断每个步骤时其输入的维度均已确定
+  std::vector<std::vector<uint32_t>> input_shapes;
+  std::vector<uint32_t> output_shape;
+  for (const ExecStep &step : exec_plan_) {
+    input_shapes.clear();
+    for (const uint32_t slot : step.in_slots) {
+      const SlotLayout &in_info = layout.slots.at(slot);
+      CHECK(in_info.used);
+      input_shapes.push_back({in_info.channels, in_info.rows, in_info.cols});
+    }
+
+    output_shape.clear();
+    if (!step.kernel->InferShape(input_shapes, output_shape)) {
+      LOG(ERROR) << "Infer the output shape of " << step.op->name << " failed";
+      return false;
+    }
+    if (output_shape.size() != 3 || output_shape.at(0) == 0 ||
+        output_shape.at(1) == 0 || output_shape.at(2) == 0) {
+      LOG(ERROR) << "The inferred output shape of " << step.op->name
+                 << " is wrong";
+      return false;
+    }
+
+    SlotLayout &out_info = layout.slots.at(step.out_slot);
+    out_info.used = true;
+    out_info.channels = output_shape.at(0);
+    out_info.rows = output_shape.at(1);
+    out_info.cols = output_shape.at(2);
+  }
+  return true;
+}
+
+std::vector<sftensor>
+RuntimeGraph::Forward(ExecutionContext &context,
+                      const std::vector<sftensor> &inputs, bool debug) const {
+  CHECK(input_slots_.size() == 1 && output_slots_.size() == 1)
+      << "The graph has multiple inputs or outputs, forward with the name "
+         "to tensor map";
+  Execute(context, {&inputs}, debug);
+
+  // 输出节点的输入就是整个计算图的输出
+  return context.slot_tensors_.at(output_slots_.front());
+}
+
+std::map<std::string, std::vector<sftensor>> RuntimeGraph::Forward(
+    ExecutionContext &context,
+    const std::map<std::string, std::vector<sftensor>> &inputs,
+    bool debug) const {
+  CHECK(inputs.size() == input_names_.size())
+      << "The graph has " << input_names_.size() << " inputs, but "
+      << inputs.size() << " are given";
+  std::vector<const std::vector<sftensor> *> input_batches;
+  for (const std::string &input_name : input_names_) {
+    const auto iter = inputs.find(input_name);
+    CHECK(iter != inputs.end()) << "Missing the input: " << input_name;
+    input_batches.push_back(&iter->second);
+  }
+  Execute(context, input_batches, debug);
+
+  std::map<std::string, std::vector<sftensor>> outputs;
+  for (uint32_t i = 0; i < output_names_.size(); ++i) {
+    outputs.insert(
+        {output_names_.at(i), context.slot_tensors_.at(output_slots_.at(i))});
+  }
+  return outputs;
+}
+
+void RuntimeGraph::Execute(
+    ExecutionContext &context,
+    const std::vector<const std::vector<sftensor> *> &inputs,
+    bool debug) const {
+  // 检查计算图是否构建完毕
+  if (graph_state_ < GraphState::Complete) {
+    LOG(FATAL) << "Graph need be build!";
+  }
+  CHECK(graph_state_ == GraphState::Complete)
+      << "Graph status error, current state is " << int(graph_state_);
+  CHECK(context.graph_ == this)
+      << "The execution context is created by another graph";
+  CHECK(context.plan_version_ == plan_version_)
+      << "The execution plan has changed, recreate the execution context";
+
+  // 各输入的批次大小须相同，同一输入的批次内Tensor维度须相同
+  CHECK(inputs.size() == input_slots_.size());
+  const uint32_t batch = inputs.front()->size();
+  std::vector<std::vector<uint32_t>> input_shapes;
+  for (uint32_t i = 0; i < inputs.size(); ++i) {
+    const std::vector<sftensor> &input_batch = *inputs.at(i);
+    CHECK(!input_batch.empty())
+        << "The input tensor array of " << input_names_.at(i) << " is empty";
+    CHECK(input_batch.size() == batch)
+        << "The inputs have different batch sizes";
+    const sftensor &first_input = input_batch.front();
+    CHECK(first_input != nullptr && !first_input->empty())
+        << "The input tensor of " << input_names_.at(i) << " is empty";
+    input_shapes.push_back(first_input->shape());
+    for (const sftensor &input : input_batch) {
+      CHECK(input != nullptr && input->shape() == input_shapes.back())
+          << "The input tensors in a batch have different shapes";
+    }
+  }
+  PrepareContext(context, FindLayout(input_shapes), batch);
 
   std::unordered_map<std::string, double> run_dur_infos; // 统计运行时间
 
   if (debug) {
-    LOG(INFO) << "Batch Size:" << inputs.size();
-    for (int b = 0; b < inputs.size(); ++b) {
-      LOG(INFO) << "Input Channels: " << inputs.at(b)->channels()
-                << " Rows: " << inputs.at(b)->rows()
-                << " Cols: " << inputs.at(b)->cols();
+    LOG(INFO) << "Batch Size:" << batch;
+    for (uint32_t i = 0; i < inputs.size(); ++i) {
+      LOG(INFO) << "Input " << input_names_.at(i)
+                << " Channels: " << input_shapes.at(i).at(0)
+                << " Rows: " << input_shapes.at(i).at(1)
+                << " Cols: " << input_shapes.at(i).at(2);
     }
     LOG(INFO) << "Inference starting...";
     LOG(INFO) << "--------------------------------------------------"
               << "\n";
   }
 
-  while (!ops_que.empty()) {
-    // 取出队头节点
-    srunop cur_op = ops_que.front();
-    ops_que.pop_front();
+  // 计算图的输入直接作为输入节点的输出
+  for (uint32_t i = 0; i < inputs.size(); ++i) {
+    context.slots_.at(input_slots_.at(i)) = inputs.at(i);
+  }
 
-    // 当前节点为空或为输出节点，推理结束
-    if (!cur_op || cur_op == output_op) {
-      if (debug) {
-        LOG(INFO) << "Inference ended";
-      }
-      break;
-    }
-    // 当前节点为输入节点，其输出Tensor等于输入inputs
-    else if (cur_op == input_op) {
-      ProbeNextOp(cur_op, ops_que, inputs);
-    }
-    // 当前节点不是输入节点，首先检测是否就绪，若就绪则执行
-    else {
-
-      const auto &start = std::chrono::steady_clock::now();
-      // 执行当前节点
-      InferStatus status = cur_op->kernel->Forward();
-
-      CHECK(status == InferStatus::InferSuccess)
-          << cur_op->kernel->kernel_name()
-          << " kernel forward failed, error code: " << int(status);
-
-      // 统计相同类型算子累计执行时间
-      if (debug) {
-        const double dura =
-            std::chrono::duration_cast<std::chrono::duration<double>>(
-                std::chrono::steady_clock::now() - start)
-                .count();
-        if (run_dur_infos.find(cur_op->type) == run_dur_infos.end()) {
-          run_dur_infos.insert({cur_op->type, dura});
-        } else {
-          run_dur_infos.at(cur_op->type) += dura;
-        }
-      }
+  // 调试时逐节点记录性能信息
+  if (debug) {
+    context.profiler_.Begin(exec_plan_.size());
+  }
 
-      const auto copy_start = std::chrono::steady_clock::now();
-      // 将当前节点的输出Tensors传递给后继节点
-      ProbeNextOp(cur_op, ops_que, cur_op->out_oprand->data);
-
-      // 统计不同层间传递Tensor的累计时间
-      if (debug) {
-        const double dura =
-            std::chrono::duration_cast<std::chrono::duration<double>>(
-                std::chrono::steady_clock::now() - copy_start)
-                .count();
-        if (run_dur_infos.find("Copy") == run_dur_infos.end()) {
-          run_dur_infos.insert({"Copy", dura});
-        } else {
-          run_dur_infos.at("Copy") += dura;
-        }
-      }
+  if (max_concurrent_ops_ > 1 && exec_plan_.size() > 1) {
+    // 并发执行相互独立的节点
+    ForwardConcurrent(context, debug);
+  } else {
+    // 按执行计划依次执行各节点
+    for (uint32_t i = 0; i < exec_plan_.size(); ++i) {
+      RunStep(context, i, debug);
     }
   }
 
-  // 所有节点执行完毕，全部置为未就绪状态
-  for (const auto &op : this->ops_) {
-    op->meet_num = 0;
+  // 不再持有外部输入的引用
+  for (const uint32_t input_slot : input_slots_) {
+    context.slots_.at(input_slot) = nullptr;
+  }
+
+  // 统计相同类型算子累计执行时间
+  if (debug) {
+    context.profiler_.End();
+    for (const ProfileRecord &record : context.profiler_.records()) {
+      run_dur_infos[record.type] += record.duration_us() * 1e-6;
+    }
   }
 
   if (debug) {
+    LOG(INFO) << "Inference ended";
     LOG(INFO) << "Inference Information, Time Cost:";
     double dura_sum = 0.;
     for (const auto &[type, dura] : run_dur_infos) {
@@ -281,203 +536,669 @@ std::vector<sftensor> RuntimeGraph::Forward(const std::vector<sftensor> &inputs,
       dura_sum += dura;
     }
     LOG(INFO) << "All time cost: " << dura_sum << " s";
+    LOG(INFO) << "Top operators:\n" << context.profiler_.TopTable(kProfileTopNum);
   }
+}
 
-  // 检查输出节点的输入数目是否为1
-  CHECK(output_op->in_oprands.size() == 1)
-      << "TinyInfer only supports one input oprand to the output operator!";
+bool RuntimeGraph::IsOutputSlot(uint32_t slot) const {
+  return std::find(output_slots_.begin(), output_slots_.end(), slot) !=
+         output_slots_.end();
+}
 
-  // 输出节点的输入就是整个计算图的输出
-  const auto &out_oprand = output_op->in_oprands.begin()->second;
+void RuntimeGraph::RunStep(ExecutionContext &context, uint32_t step_idx,
+                           bool debug) const {
+  const ExecStep &step = exec_plan_[step_idx];
+
+  // 单输入节点直接使用前驱节点的输出，多输入节点按来源顺序拼接输入
+  const std::vector<sftensor> *step_inputs = nullptr;
+  if (step.in_slots.size() == 1) {
+    step_inputs = context.slots_[step.in_slots.front()];
+  } else {
+    auto &in_buf = context.in_bufs_[step_idx];
+    in_buf.clear();
+    for (const uint32_t slot : step.in_slots) {
+      const auto &in_data = *context.slots_[slot];
+      in_buf.insert(in_buf.end(), in_data.begin(), in_data.end());
+    }
+    step_inputs = &in_buf;
+  }
+
+  const auto &start = Profiler::Clock::now();
+  // 执行当前节点
+  auto &step_outputs = context.slot_tensors_[step.out_slot];
+  InferStatus status = step.kernel->Forward(*step_inputs, step_outputs);
 
-  return out_oprand->data;
+  CHECK(status == InferStatus::InferSuccess)
+      << step.kernel->kernel_name()
+      << " kernel forward failed, error code: " << int(status);
+
+  if (debug) {
+    const auto &end = Profiler::Clock::now();
+    context.profiler_.Record(step_idx, MakeProfileRecord(context, step_idx),
+                             start, end);
+  }
 }
 
-skernel RuntimeGraph::CreateKernel(const srunop &op) {
-  CHECK(op != nullptr) << "Operator is empty!";
-  const auto &kernel = KernelRegister::CreateKernel(op);
-  CHECK(kernel != nullptr) << "Kernel init failed " << op->type;
-  return kernel;
+ProfileRecord RuntimeGraph::MakeProfileRecord(const ExecutionContext &context,
+                                              uint32_t step_idx) const {
+  const ExecStep &step = exec_plan_.at(step_idx);
+  ProfileRecord record;
+  record.name = step.op->name;
+  record.type = step.op->type;
+  const auto &fused_ops = step.op->params.find("fused_ops");
+  if (fused_ops != step.op->params.end()) {
+    const auto fused_param = dynamic_cast<RuntimeParamStrArr *>(fused_ops->second);
+    if (fused_param != nullptr) {
+      record.fused_ops = fused_param->value;
+    }
+  }
+
+  // 各输入来源和输出中单个Tensor的维度
+  uint64_t sample_elems = 0;
+  for (const uint32_t slot : step.in_slots) {
+    const sftensor &input = context.slots_.at(slot)->front();
+    record.input_shapes.push_back(input->shape());
+    sample_elems += input->size();
+  }
+  const auto &outputs = context.slot_tensors_.at(step.out_slot);
+  record.batch = outputs.size();
+  record.output_shape = outputs.front()->shape();
+  sample_elems += outputs.front()->size();
+
+  // 访存量按读一遍输入和权重、写一遍输出估算
+  record.flops =
+      step.kernel->Flops(record.input_shapes, record.output_shape) * record.batch;
+  record.bytes = sample_elems * sizeof(float) * record.batch +
+                 step.kernel->weight_bytes();
+  return record;
 }
 
-void RuntimeGraph::InitOpInputs(const std::vector<pnnx::Operand *> &inputs,
-                                const srunop &op) {
-  // 遍历所有来源的输入操作数
-  for (const pnnx::Operand *input : inputs) {
-    if (!input) {
-      continue;
+void RuntimeGraph::ForwardConcurrent(ExecutionContext &context,
+                                     bool debug) const {
+  CHECK(op_pool_ != nullptr) << "The thread pool for operators is empty";
+  const uint32_t step_num = exec_plan_.size();
+
+  // 重置各步骤的依赖计数
+  for (uint32_t i = 0; i < step_num; ++i) {
+    context.pending_deps_[i].store(exec_plan_.at(i).dep_count,
+                                   std::memory_order_relaxed);
+  }
+  context.remaining_steps_.store(step_num);
+
+  // 派发没有前驱步骤的节点
+  ExecutionContext *context_ptr = &context;
+  for (uint32_t i = 0; i < step_num; ++i) {
+    if (exec_plan_.at(i).dep_count == 0) {
+      op_pool_->Submit([this, context_ptr, i, debug]() {
+        RunStepChain(*context_ptr, i, debug);
+      });
     }
-    const pnnx::Operator *producer =
-        input->producer; // 获取输入操作数的生产节点
-    srunoprand oprand = std::make_shared<RuntimeOprand>();
-    // 初始化输入操作数的名称、维度
-    // 注意：输入操作数名称是其生产节点名称
-    oprand->name = producer->name;
-    oprand->shape = input->shape;
-
-    // 初始化输入的值类型
-    switch (input->type) {
-    case 1: {
-      oprand->type = RuntimeDataType::TypeFloat32;
-      break;
+  }
+
+  // 等待所有步骤执行完毕
+  std::unique_lock<std::mutex> lock(context.done_mutex_);
+  context.done_cv_.wait(
+      lock, [&context]() { return context.remaining_steps_.load() == 0; });
+}
+
+void RuntimeGraph::RunStepChain(ExecutionContext &context, uint32_t step_idx,
+                                bool debug) const {
+  ExecutionContext *context_ptr = &context;
+  while (true) {
+    RunStep(context, step_idx, debug);
+
+    // 依赖计数减为0的后继步骤已就绪
+    int64_t chained_idx = -1;
+    for (const uint32_t next_idx : exec_plan_.at(step_idx).next_steps) {
+      if (context.pending_deps_[next_idx].fetch_sub(
+              1, std::memory_order_acq_rel) == 1) {
+        if (chained_idx < 0) {
+          chained_idx = next_idx;
+        } else {
+          op_pool_->Submit([this, context_ptr, next_idx, debug]() {
+            RunStepChain(*context_ptr, next_idx, debug);
+          });
+        }
+      }
     }
-    case 0: {
-      oprand->type = RuntimeDataType::TypeUnknown;
+
+    // 计数与通知都在锁内完成：等待方在本线程释放锁之前无法返回并析构context，
+    // 释放锁之后这里只再访问局部变量和exec_plan_
+    {
+      std::lock_guard<std::mutex> lock(context.done_mutex_);
+      if (context.remaining_steps_.fetch_sub(1, std::memory_order_acq_rel) ==
+          1) {
+        context.done_cv_.notify_all();
+      }
+    }
+
+    if (chained_idx < 0) {
       break;
     }
-    default: {
-      LOG(FATAL) << "Unsupported input operand type: " << input->type;
+    step_idx = chained_idx;
+  }
+}
+
+void RuntimeGraph::set_max_concurrent_ops(uint32_t max_concurrent_ops) {
+  CHECK(max_concurrent_ops > 0) << "The max concurrent ops must be positive";
+  const bool was_concurrent = max_concurrent_ops_ > 1;
+  max_concurrent_ops_ = max_concurrent_ops;
+  if (graph_state_ != GraphState::Complete) {
+    return;
+  }
+
+  if (max_concurrent_ops_ > 1) {
+    op_pool_ = std::make_unique<ThreadPool>(max_concurrent_ops_);
+  } else {
+    op_pool_.reset();
+  }
+
+  // 串行与并发执行的内存复用条件不同，切换执行方式需要重新规划内存
+  if (was_concurrent != (max_concurrent_ops_ > 1)) {
+    PlanActivationMemory();
+  }
+}
+
+uint32_t RuntimeGraph::max_concurrent_ops() const {
+  return max_concurrent_ops_;
+}
+
+void RuntimeGraph::set_fuse_ops(bool fuse_ops) {
+  CHECK(graph_state_ != GraphState::Complete)
+      << "Operator fusion must be set before building the graph";
+  fuse_ops_ = fuse_ops;
+}
+
+bool RuntimeGraph::fuse_ops() const { return fuse_ops_; }
+
+const std::vector<std::string> &RuntimeGraph::input_names() const {
+  return input_names_;
+}
+
+const std::vector<std::string> &RuntimeGraph::output_names() const {
+  return output_names_;
+}
+
+void RuntimeGraph::ResolveGraphIO() {
+  // 节点名称到下标的映射，仅在构建阶段使用
+  std::unordered_map<std::string, uint32_t> op_indices;
+  for (uint32_t i = 0; i < ops_.size(); ++i) {
+    op_indices.insert({ops_.at(i)->name, i});
+  }
+
+  input_slots_.clear();
+  for (const std::string &input_name : input_names_) {
+    CHECK(input_ops.find(input_name) != input_ops.end())
+        << "Can not find the input operator: " << input_name;
+    input_slots_.push_back(op_indices.at(input_name));
+  }
+
+  // 输出可以是输出节点的输入，也可以是中间节点的输出
+  output_slots_.clear();
+  for (const std::string &output_name : output_names_) {
+    uint32_t output_slot = 0;
+    const auto output_op = output_ops.find(output_name);
+    const auto op_index = op_indices.find(output_name);
+    if (output_op != output_ops.end()) {
+      // 检查输出节点的输入数目是否为1
+      CHECK(output_op->second->in_oprands.size() == 1)
+          << "TinyInfer only supports one input oprand to the output operator!";
+      output_slot =
+          op_indices.at(output_op->second->in_oprands_seq.front()->name);
+    } else if (op_index != op_indices.end()) {
+      output_slot = op_index->second;
+    } else {
+      // 作为末节点被融合时，其输出就是首节点的输出
+      const srunop head = OpFusion::FindFusedHead(ops_, output_name);
+      CHECK(head != nullptr)
+          << "Can not find the output operator or operand: " << output_name;
+      output_slot = op_indices.at(head->name);
+    }
+    CHECK(std::find(input_slots_.begin(), input_slots_.end(), output_slot) ==
+          input_slots_.end())
+        << "The output " << output_name << " directly uses a graph input";
+    output_slots_.push_back(output_slot);
+  }
+
+  // 从输出逆向标记其依赖的节点
+  required_ops_.assign(ops_.size(), false);
+  std::vector<uint32_t> visit_stack(output_slots_.begin(), output_slots_.end());
+  while (!visit_stack.empty()) {
+    const uint32_t idx = visit_stack.back();
+    visit_stack.pop_back();
+    if (required_ops_.at(idx)) {
+      continue;
+    }
+    required_ops_.at(idx) = true;
+
+    const srunop &op = ops_.at(idx);
+    if (op->type == "pnnx.Input") {
+      CHECK(std::find(input_slots_.begin(), input_slots_.end(), idx) !=
+            input_slots_.end())
+          << "The outputs depend on the input operator " << op->name
+          << ", which is not given";
     }
+    for (const auto &in_oprand : op->in_oprands_seq) {
+      visit_stack.push_back(op_indices.at(in_oprand->name));
     }
+  }
 
-    op->in_oprands_seq.push_back(oprand);
-    op->in_oprands.insert({oprand->name, oprand});
+  uint32_t required_count = 0;
+  for (uint32_t i = 0; i < ops_.size(); ++i) {
+    if (required_ops_.at(i) && ops_.at(i)->type != "pnnx.Input") {
+      required_count += 1;
+    }
   }
+  LOG(INFO) << "The outputs depend on " << required_count << " of "
+            << ops_.size() - input_ops.size() - output_ops.size()
+            << " operators";
 }
 
-void RuntimeGraph::InitOpOutputs(const std::vector<pnnx::Operand *> &outputs,
-                                 const srunop &op) {
-  for (const pnnx::Operand *output : outputs) {
-    if (!output) {
+void RuntimeGraph::CreateKernels(ThreadPool *pool) {
+  // 输出不依赖的节点不构造Kernel，也不会执行
+  std::vector<srunop> kernel_ops;
+  for (uint32_t i = 0; i < this->ops_.size(); ++i) {
+    const srunop &op = this->ops_.at(i);
+    if (op->type == "pnnx.Input" || op->type == "pnnx.Output" ||
+        !required_ops_.at(i)) {
       continue;
     }
-    // 获取输出操作数的消费（后继）节点
-    const auto &consumers = output->consumers;
-    // 保存当前节点的后继节点名称
-    for (const auto &consumer : consumers) {
-      op->out_ops.insert({consumer->name, nullptr});
+    kernel_ops.push_back(op);
+    if (share_weights_) {
+      for (const auto &[name, attr] : op->attrs) {
+        attr->share = true;
+      }
     }
   }
-}
 
-void RuntimeGraph::InitOpParams(
-    const std::map<std::string, pnnx::Parameter> &params, const srunop &op) {
-  // 遍历每一个参数
-  for (const auto &[name, pnnx_param] : params) {
-    // 构造不同类型的参数
-    const int type = pnnx_param.type;
-    switch (type) {
-    case int(RuntimeParamType::ParamUnknown): {
-      RuntimeParam *param = new RuntimeParam;
-      op->params.insert({name, param});
-      break;
+  // 各节点的Kernel构造和权重转换互不依赖，并行执行
+  ParallelFor(pool, kernel_ops.size(), [&kernel_ops](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const srunop &op = kernel_ops.at(i);
+      skernel kernel = RuntimeGraph::CreateKernel(op);
+      CHECK(kernel != nullptr) << "Kernel create failed!";
+      // 将计算节点op和算子kernel绑定起来
+      op->kernel = kernel;
+      kernel->set_runtime_op(op);
     }
+  });
+}
 
-    case int(RuntimeParamType::ParamBool): {
-      RuntimeParamBool *param = new RuntimeParamBool;
-      param->value = pnnx_param.b;
-      op->params.insert({name, param});
-      break;
+std::unique_ptr<ThreadPool> RuntimeGraph::CreateBuildPool() const {
+  uint32_t thread_num = build_threads_;
+  if (thread_num == 0) {
+    thread_num = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  if (thread_num == 1) {
+    return nullptr;
+  }
+  return std::make_unique<ThreadPool>(thread_num);
+}
+
+void RuntimeGraph::set_build_threads(uint32_t build_threads) {
+  build_threads_ = build_threads;
+}
+
+uint32_t RuntimeGraph::build_threads() const { return build_threads_; }
+
+void RuntimeGraph::set_share_weights(bool share_weights) {
+  CHECK(graph_state_ != GraphState::Complete)
+      << "The weight sharing must be set before building the graph";
+  share_weights_ = share_weights;
+}
+
+bool RuntimeGraph::share_weights() const { return share_weights_; }
+
+void RuntimeGraph::set_weight_segment(const std::string &name,
+                                      uint32_t wait_ms) {
+  CHECK(graph_state_ != GraphState::Complete)
+      << "The weight segment must be set before building the graph";
+  weight_segment_name_ = name;
+  weight_segment_wait_ms_ = wait_ms;
+}
+
+const std::string &RuntimeGraph::weight_segment() const {
+  return weight_segment_name_;
+}
+
+bool RuntimeGraph::weight_segment_attached() const {
+  return weight_segment_attached_;
+}
+
+bool RuntimeGraph::AttachWeightSegment() {
+  weight_segment_attached_ = false;
+  if (!SharedWeightSegment::MakeModelKey(param_path_, bin_path_,
+                                         weight_segment_key_)) {
+    LOG(WARNING) << "Can not identify the model, the weight segment is unused";
+    return true;
+  }
+
+  bool exists = false;
+  const auto segment = SharedWeightSegment::Attach(
+      weight_segment_name_, weight_segment_key_, weight_segment_wait_ms_,
+      exists);
+  if (segment == nullptr) {
+    return exists;
+  }
+
+  // 段中的权重已转换为Kernel的内存布局，作为打包好的权重直接使用
+  uint32_t attached_count = 0;
+  for (uint32_t i = 0; i < ops_.size(); ++i) {
+    if (!required_ops_.at(i)) {
+      continue;
     }
+    const srunop &op = ops_.at(i);
+    for (const auto &[name, attr] : op->attrs) {
+      const size_t byte_size =
+          attr->weight_data.empty() ? attr->mapped_size : attr->weight_data.size();
+      const float *data =
+          segment->Find(op->name + "." + name, byte_size / sizeof(float));
+      if (data == nullptr) {
+        LOG(WARNING) << "The weight " << op->name << "." << name
+                     << " is not in the weight segment " << weight_segment_name_;
+        continue;
+      }
+      attr->packed_data = const_cast<float *>(data);
+      attr->packed_size = byte_size / sizeof(float);
+      attr->clear();
+      attached_count += 1;
+    }
+  }
+  LOG(INFO) << "Attached " << attached_count << " weights from the segment "
+            << weight_segment_name_;
+  weight_segment_ = segment;
+  weight_segment_attached_ = true;
+  return true;
+}
 
-    case int(RuntimeParamType::ParamInt): {
-      RuntimeParamInt *param = new RuntimeParamInt;
-      param->value = pnnx_param.i;
-      op->params.insert({name, param});
-      break;
+void RuntimeGraph::PublishWeightSegment() {
+  // 权重取自Kernel，即已转换为Kernel内存布局的权重Tensor
+  std::vector<SharedWeightSegment::Entry> entries;
+  std::vector<std::pair<AttrKernel *, bool>> kernels; // Kernel及该项是否为权重
+  for (uint32_t i = 0; i < ops_.size(); ++i) {
+    const srunop &op = ops_.at(i);
+    const auto attr_kernel = dynamic_cast<AttrKernel *>(op->kernel.get());
+    if (!required_ops_.at(i) || attr_kernel == nullptr) {
+      continue;
+    }
+    if (op->attrs.count("weight") && !attr_kernel->weights().empty()) {
+      entries.push_back({op->name + ".weight", attr_kernel->weights()});
+      kernels.emplace_back(attr_kernel, true);
     }
+    if (op->attrs.count("bias") && !attr_kernel->bias().empty()) {
+      entries.push_back({op->name + ".bias", attr_kernel->bias()});
+      kernels.emplace_back(attr_kernel, false);
+    }
+  }
 
-    case int(RuntimeParamType::ParamFloat): {
-      RuntimeParamFloat *param = new RuntimeParamFloat;
-      param->value = pnnx_param.f;
-      op->params.insert({name, param});
-      break;
+  const auto segment = SharedWeightSegment::Create(
+      weight_segment_name_, weight_segment_key_, entries);
+  if (segment == nullptr) {
+    LOG(WARNING) << "Can not create the weight segment " << weight_segment_name_
+                 << ", the weights stay private";
+    return;
+  }
+
+  // 当前计算图同样改用段中的权重，释放私有的一份
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const SharedWeightSegment::Entry &entry = entries.at(i);
+    size_t elem_ct = 0;
+    for (const sftensor &tensor : entry.tensors) {
+      elem_ct += tensor->size();
+    }
+    float *data = const_cast<float *>(segment->Find(entry.name, elem_ct));
+    CHECK(data != nullptr) << "The weight " << entry.name << " is missing";
+
+    std::vector<sftensor> views;
+    for (const sftensor &tensor : entry.tensors) {
+      views.push_back(std::make_shared<ftensor>(
+          data, tensor->channels(), tensor->rows(), tensor->cols()));
+      data += tensor->size();
     }
+    if (kernels.at(i).second) {
+      kernels.at(i).first->set_weights(views);
+    } else {
+      kernels.at(i).first->set_bias(views);
+    }
+  }
+  LOG(INFO) << "Created the weight segment " << weight_segment_name_ << " with "
+            << entries.size() << " weights";
+  weight_segment_ = segment;
+}
 
-    case int(RuntimeParamType::ParamStr): {
-      RuntimeParamStr *param = new RuntimeParamStr;
-      param->value = pnnx_param.s;
-      op->params.insert({name, param});
-      break;
+const StartupTimings &RuntimeGraph::startup_timings() const {
+  return startup_timings_;
+}
+
+void RuntimeGraph::BuildExecPlan() {
+  // 节点名称到下标的映射，仅在构建阶段使用
+  std::unordered_map<std::string, uint32_t> op_indices;
+  // 节点尚未就绪的前驱数目
+  std::vector<uint32_t> in_degrees(ops_.size());
+  for (uint32_t i = 0; i < ops_.size(); ++i) {
+    op_indices.insert({ops_.at(i)->name, i});
+    in_degrees.at(i) = ops_.at(i)->in_oprands.size();
+  }
+
+  // 从输入节点出发，按拓扑序（Kahn算法）排列输出依赖的计算节点
+  exec_plan_.clear();
+  std::deque<uint32_t> ready_que(input_slots_.begin(), input_slots_.end());
+  while (!ready_que.empty()) {
+    const uint32_t idx = ready_que.front();
+    ready_que.pop_front();
+
+    const srunop &op = ops_.at(idx);
+    if (op->type != "pnnx.Input" && op->type != "pnnx.Output" &&
+        required_ops_.at(idx)) {
+      CHECK(op->kernel != nullptr) << op->name << " kernel is empty";
+      CHECK(op->out_oprand != nullptr) << op->name << " output is empty";
+
+      ExecStep step;
+      step.op = op.get();
+      step.kernel = op->kernel.get();
+      step.out_slot = idx;
+      for (const auto &in_oprand : op->in_oprands_seq) {
+        step.in_slots.push_back(op_indices.at(in_oprand->name));
+      }
+      CHECK(!step.in_slots.empty()) << op->name << " has no input";
+      exec_plan_.push_back(std::move(step));
     }
 
-    case int(RuntimeParamType::ParamIntArray): {
-      RuntimeParamIntArr *param = new RuntimeParamIntArr;
-      param->value = pnnx_param.ai;
-      op->params.insert({name, param});
-      break;
+    // 后继节点的所有前驱都已排列，则该后继节点就绪
+    for (const auto &[_, next_op] : op->out_ops) {
+      const uint32_t next_idx = op_indices.at(next_op->name);
+      CHECK(in_degrees.at(next_idx) > 0);
+      in_degrees.at(next_idx) -= 1;
+      if (in_degrees.at(next_idx) == 0) {
+        ready_que.push_back(next_idx);
+      }
     }
+  }
 
-    case int(RuntimeParamType::ParamFloatArray): {
-      RuntimeParamFloatArr *param = new RuntimeParamFloatArr;
-      param->value = pnnx_param.af;
-      op->params.insert({name, param});
-      break;
+  for (uint32_t i = 0; i < output_slots_.size(); ++i) {
+    CHECK(in_degrees.at(output_slots_.at(i)) == 0)
+        << "The output " << output_names_.at(i)
+        << " is unreachable from the given input operators";
+  }
+
+  // 批次维度为-1（?）表示动态批次
+  const srunop &input_op = ops_.at(input_slots_.front());
+  param_batch_ = std::max(input_op->out_oprand->shape.at(0), 0);
+
+  // 记录步骤间的依赖关系，供并发执行使用
+  std::vector<int64_t> slot_steps(ops_.size(), -1); // 槽位由哪个步骤写入
+  for (uint32_t i = 0; i < exec_plan_.size(); ++i) {
+    slot_steps.at(exec_plan_.at(i).out_slot) = i;
+  }
+  for (uint32_t i = 0; i < exec_plan_.size(); ++i) {
+    ExecStep &step = exec_plan_.at(i);
+    std::unordered_set<uint32_t> prev_steps;
+    for (const uint32_t slot : step.in_slots) {
+      if (slot_steps.at(slot) >= 0) {
+        prev_steps.insert(slot_steps.at(slot));
+      }
+    }
+    step.dep_count = prev_steps.size();
+    for (const uint32_t prev_step : prev_steps) {
+      exec_plan_.at(prev_step).next_steps.push_back(i);
     }
+  }
+}
 
-    case int(RuntimeParamType::ParamStrArray): {
-      RuntimeParamStrArr *param = new RuntimeParamStrArr;
-      param->value = pnnx_param.as;
-      op->params.insert({name, param});
-      break;
+void RuntimeGraph::InitDefaultLayout() {
+  // 记录结构文件中声明的计算图输入和各步骤输出中单个样本的Tensor布局
+  auto layout = std::make_shared<ActivationLayout>();
+  layout->slots.assign(ops_.size(), SlotLayout());
+  std::vector<uint32_t> used_slots(input_slots_.begin(), input_slots_.end());
+  for (const ExecStep &step : exec_plan_) {
+    used_slots.push_back(step.out_slot);
+  }
+  for (const uint32_t slot : used_slots) {
+    const auto &out_oprand = ops_.at(slot)->out_oprand;
+    CHECK(out_oprand != nullptr && !out_oprand->data.empty())
+        << ops_.at(slot)->name << " output is empty";
+    const auto &out_data = out_oprand->data;
+    const sftensor &sample = out_data.front();
+    for (const auto &tensor : out_data) {
+      CHECK(tensor != nullptr && tensor->shape() == sample->shape())
+          << "The output tensors of " << ops_.at(slot)->name
+          << " have different shapes";
     }
 
-    default: {
-      LOG(FATAL) << "Unsupported parameter type";
+    SlotLayout &info = layout->slots.at(slot);
+    info.used = true;
+    info.channels = sample->channels();
+    info.rows = sample->rows();
+    info.cols = sample->cols();
+  }
+  for (const uint32_t input_slot : input_slots_) {
+    const SlotLayout &input_info = layout->slots.at(input_slot);
+    layout->input_shapes.push_back(
+        {input_info.channels, input_info.rows, input_info.cols});
+  }
+  default_layout_ = std::move(layout);
+}
+
+void RuntimeGraph::PlanActivationMemory() {
+  CHECK(default_layout_ != nullptr) << "The execution plan is empty";
+  auto layout = std::make_shared<ActivationLayout>(*default_layout_);
+  PlanLayout(*layout);
+  default_layout_ = std::move(layout);
+
+  // 执行上下文和缓存的激活布局按新的规划结果重新创建
+  plan_version_ += 1;
+  default_context_.reset();
+  {
+    std::lock_guard<std::mutex> lock(layout_mutex_);
+    layouts_.clear();
+  }
+
+  // 按结构文件中声明的批次报告，动态批次时报告单个样本
+  const uint32_t batch = std::max(param_batch_, 1u);
+  const double mb = 1024. * 1024.;
+  LOG(INFO) << "Activation memory of batch " << batch << " before planning: "
+            << default_layout_->naive_bytes * batch / mb
+            << " MB, after planning: "
+            << default_layout_->planned_bytes * batch / mb
+            << " MB (lower bound: "
+            << default_layout_->live_peak_bytes * batch / mb << " MB)";
+}
+
+void RuntimeGraph::PlanLayout(ActivationLayout &layout) const {
+  // 每个槽位（节点输出）首次写入和最后一次读取的执行步骤
+  constexpr uint32_t kNoStep = UINT32_MAX;
+  const uint32_t slot_num = layout.slots.size();
+  std::vector<uint32_t> first_steps(slot_num, kNoStep);
+  std::vector<uint32_t> last_steps(slot_num, kNoStep);
+  std::vector<std::vector<uint32_t>> use_steps(slot_num);
+  for (uint32_t step_idx = 0; step_idx < exec_plan_.size(); ++step_idx) {
+    const ExecStep &step = exec_plan_.at(step_idx);
+    first_steps.at(step.out_slot) = step_idx;
+    // 输出没有消费者时，生命周期仅为当前步骤
+    if (last_steps.at(step.out_slot) == kNoStep) {
+      last_steps.at(step.out_slot) = step_idx;
     }
+    for (const uint32_t in_slot : step.in_slots) {
+      last_steps.at(in_slot) = step_idx;
+      use_steps.at(in_slot).push_back(step_idx);
     }
   }
-}
 
-void RuntimeGraph::InitOpAttrs(
-    const std::map<std::string, pnnx::Attribute> &attrs, const srunop &op) {
-  // 遍历每一个权重
-  for (const auto &[name, pnnx_attr] : attrs) {
-    switch (pnnx_attr.type) {
-    case 1: {
-      srunattr attr = std::make_shared<RuntimeAttr>();
-      attr->type = RuntimeDataType::TypeFloat32;
-      attr->shape = pnnx_attr.shape;
-      attr->weight_data = pnnx_attr.data;
-      op->attrs.insert({name, attr});
-      break;
+  // 为每个中间节点的输出添加一块内存，按单个样本的大小规划
+  MemoryPlanner planner;
+  if (max_concurrent_ops_ > 1) {
+    std::vector<std::vector<uint32_t>> next_steps;
+    for (const ExecStep &step : exec_plan_) {
+      next_steps.push_back(step.next_steps);
     }
-    default: {
-      LOG(FATAL) << "Unsupported attribute type";
+    planner.SetDependencies(next_steps);
+  }
+
+  std::vector<std::pair<uint32_t, uint32_t>> slot_blocks; // (槽位，内存块编号)
+  for (uint32_t slot = 0; slot < slot_num; ++slot) {
+    SlotLayout &info = layout.slots.at(slot);
+    info.planned = false;
+    if (!info.used) {
+      continue;
     }
+    info.sample_bytes = MemoryPlanner::AlignSize(
+        size_t(info.channels) * info.rows * info.cols * sizeof(float));
+    if (first_steps.at(slot) == kNoStep || IsOutputSlot(slot)) {
+      continue;
     }
+    const size_t block_bytes = info.sample_bytes;
+    const uint32_t block_id =
+        max_concurrent_ops_ > 1
+            ? planner.AddBlock(block_bytes, first_steps.at(slot),
+                               use_steps.at(slot))
+            : planner.AddBlock(block_bytes, first_steps.at(slot),
+                               last_steps.at(slot));
+    slot_blocks.emplace_back(slot, block_id);
+  }
+
+  planner.Plan();
+  layout.naive_bytes = planner.naive_bytes();
+  layout.planned_bytes = planner.planned_bytes();
+  layout.live_peak_bytes = planner.live_peak_bytes();
+  for (const auto &[slot, block_id] : slot_blocks) {
+    SlotLayout &info = layout.slots.at(slot);
+    info.planned = true;
+    info.offset = planner.offset(block_id);
   }
 }
 
-bool RuntimeGraph::CheckOpReady(const srunop &op) {
-  CHECK(op != nullptr);
-  CHECK(op->meet_num <= op->in_oprands.size());
+size_t RuntimeGraph::naive_activation_bytes(uint32_t batch) const {
+  CHECK(graph_state_ == GraphState::Complete) << "Graph need be build!";
+  return default_layout_->naive_bytes * batch;
+}
 
-  // 注意：当前节点的被访问次数等于输入数目，说明其所有前驱节点都已被执行，节点就绪，可被执行
-  if (op->meet_num == op->in_oprands.size()) {
-    return true;
-  } else {
-    return false;
-  }
+size_t RuntimeGraph::planned_activation_bytes(uint32_t batch) const {
+  CHECK(graph_state_ == GraphState::Complete) << "Graph need be build!";
+  return default_layout_->planned_bytes * batch;
 }
 
-void RuntimeGraph::ProbeNextOp(const srunop &cur_op,
-                               std::deque<srunop> &ops_que,
-                               const std::vector<sftensor> &outputs) {
-  // 遍历当前节点的后继节点
-  const auto &next_ops = cur_op->out_ops;
-  for (const auto &[_, next_op] : next_ops) {
-    // 取出后继节点的输入操作数
-    const auto &next_in_oprands = next_op->in_oprands;
-    // 检查后继节点的输入操作数是否来自当前节点
-    if (next_in_oprands.find(cur_op->name) != next_in_oprands.end()) {
-      // 将当前节点的输出Tensor拷贝给后继节点（拷贝指针，两个指针指向同一Tensor对象）
-      // ! 所以节点的输入空间实际上复用了前驱节点的输出空间
-      std::vector<sftensor> &next_in_data =
-          next_in_oprands.at(cur_op->name)->data;
-      for (int b = 0; b < next_in_data.size(); ++b) {
-        next_in_data.at(b) = outputs.at(b);
-      }
+const Profiler &RuntimeGraph::profiler() const {
+  CHECK(default_context_ != nullptr)
+      << "The default execution context has not run yet";
+  return default_context_->profiler();
+}
+
+size_t RuntimeGraph::cached_layout_count() const {
+  std::lock_guard<std::mutex> lock(layout_mutex_);
+  return layouts_.size();
+}
 
-      // 后继节点的被访问次数加1
-      next_op->meet_num += 1;
+bool RuntimeGraph::has_cached_layout(
+    const std::vector<std::vector<uint32_t>> &input_shapes) const {
+  std::lock_guard<std::mutex> lock(layout_mutex_);
+  return layouts_.count(input_shapes) > 0;
+}
 
-      // 检测后继节点是否已经就绪，若就绪，则加入队列
-      if (CheckOpReady(next_op)) {
-        ops_que.push_back(next_op);
-      }
-    }
-  }
+skernel RuntimeGraph::CreateKernel(const srunop &op) {
+  CHECK(op != nullptr) << "Operator is empty!";
+  const auto &kernel = KernelRegister::CreateKernel(op);
+  CHECK(kernel != nullptr) << "Kernel init failed " << op->type;
+  return kernel;
 }
 
 } // namespace TinyInfer
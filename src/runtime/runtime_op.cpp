@@ -1,4 +1,5 @@
 #include "runtime/runtime_op.hpp"
+#include <algorithm>
 #include <array>
 
 namespace TinyInfer {
@@ -30,8 +31,8 @@ void RuntimeOpUtils::InitOpsInput(const std::vector<srunop> &ops) {
         // 检查输入操作数的维度
         const auto &in_shape = in_oprand->shape;
         CHECK(!in_shape.empty());
-        const int32_t batch = in_shape.at(0);
-        CHECK(batch >= 0) << "Dynamic batch size is not supported!";
+        // 批次维度为-1（?）表示动态批次，实际批次由推理时的输入决定
+        const int32_t batch = std::max(in_shape.at(0), 0);
         CHECK(in_shape.size() == 2 || in_shape.size() == 3 ||
               in_shape.size() == 4)
             << "Unsupported input oprand shape size: " << in_shape.size();
@@ -58,7 +59,7 @@ void RuntimeOpUtils::InitOpsOutput(
   CHECK(!pnnx_ops.empty() && !ops.empty());
   CHECK(pnnx_ops.size() == ops.size());
 
-  // 由pnnx计算图节点的输出操作数初始化TinyInfer计算图节点的输出空间
+  // 由pnnx计算图节点的输出操作数初始化TinyInfer计算图节点的输出操作数
   for (uint32_t i = 0; i < pnnx_ops.size(); ++i) {
     // 获取pnnx计算图节点的输出操作数
     const auto &pout_oprands = pnnx_ops.at(i)->outputs;
@@ -73,51 +74,68 @@ void RuntimeOpUtils::InitOpsOutput(
     const auto pout_oprand = pout_oprands.front();
     CHECK(pout_oprand != nullptr) << "Output oprand is null";
 
+    auto &out_oprand = ops.at(i)->out_oprand;
+    // 输出操作数为空，说明是第一次构建计算图，初始化输出操作数的名称、维度、值类型
+    if (!out_oprand) {
+      out_oprand = std::make_shared<RuntimeOprand>();
+      out_oprand->name = pout_oprand->name + "_output";
+      out_oprand->shape = pout_oprand->shape;
+      out_oprand->type = RuntimeDataType::TypeFloat32;
+    } else {
+      CHECK(out_oprand->shape == pout_oprand->shape);
+    }
+  }
+
+  InitOpsOutput(ops);
+}
+
+void RuntimeOpUtils::InitOpsOutput(const std::vector<srunop> &ops) {
+  CHECK(!ops.empty());
+
+  for (const auto &op : ops) {
+    const auto &out_oprand = op->out_oprand;
+    if (!out_oprand) {
+      continue;
+    }
+
     // 检查输出操作数的维度
-    const std::vector<int32_t> &out_shape = pout_oprand->shape;
-    const int32_t batch = out_shape.at(0);
-    CHECK(batch >= 0) << "Dynamic batch size is not supported!";
+    const std::vector<int32_t> &out_shape = out_oprand->shape;
     CHECK(out_shape.size() == 2 || out_shape.size() == 3 ||
           out_shape.size() == 4)
         << "Unsupported output oprand shape size: " << out_shape.size();
+    for (uint32_t i = 1; i < out_shape.size(); ++i) {
+      CHECK(out_shape.at(i) > 0)
+          << "Only the batch dimension of output oprand can be dynamic";
+    }
+    CHECK(out_oprand->type == RuntimeDataType::TypeFloat32);
+    // 批次维度为-1（?）表示动态批次，只创建一个Tensor记录单个样本的维度，
+    // 实际批次由推理时的输入决定
+    const int32_t batch = out_shape.at(0) > 0 ? out_shape.at(0) : 1;
 
-    // 取出需要初始化的输出操作数
-    const auto &op = ops.at(i);
-    const auto &out_oprand = op->out_oprand;
-
-    // 输出操作数为空，说明是第一次构建计算图
-    if (!out_oprand) {
-      // 初始化输出操作数的名称、维度、值类型
-      srunoprand tmp_out_oprand = std::make_shared<RuntimeOprand>();
-      tmp_out_oprand->name = pout_oprand->name + "_output";
-      tmp_out_oprand->shape = out_shape;
-      tmp_out_oprand->type = RuntimeDataType::TypeFloat32;
-      tmp_out_oprand->data.reserve(batch);
-
+    // 输出空间为空，说明是第一次构建计算图
+    if (out_oprand->data.empty()) {
       // 初始化输出空间——开辟保存每一个输出Tensor的内存空间
       // 注意：初始化输入空间时，不用为输入Tensor开辟空间，因为输入Tensor一定是从前驱节点接收来的！
+      out_oprand->data.reserve(batch);
       for (int b = 0; b < batch; ++b) {
         if (out_shape.size() == 2) {
-          tmp_out_oprand->data.push_back(
+          out_oprand->data.push_back(
               std::make_shared<ftensor>(1, out_shape.at(1), 1));
         } else if (out_shape.size() == 3) {
-          tmp_out_oprand->data.push_back(
+          out_oprand->data.push_back(
               std::make_shared<ftensor>(1, out_shape.at(1), out_shape.at(2)));
         } else { // current shape size is 4
-          tmp_out_oprand->data.push_back(std::make_shared<ftensor>(
+          out_oprand->data.push_back(std::make_shared<ftensor>(
               out_shape.at(1), out_shape.at(2), out_shape.at(3)));
         }
       }
-      op->out_oprand = std::move(tmp_out_oprand);
     }
 
-    // 输出操作数非空，说明计算图已经构建完毕，则检查
+    // 输出空间非空，说明计算图已经构建完毕，则检查
     else {
-      // 检查输出操作数的维度、值类型
-      CHECK(out_oprand->shape == out_shape);
-      CHECK(out_oprand->type == RuntimeDataType::TypeFloat32);
-
       // 检查每一个输出Tensor是否变形，若变形则需要恢复
+      CHECK(out_oprand->data.size() == batch)
+          << "Output tensor count not equal to batch!";
       for (uint32_t b = 0; b < batch; ++b) {
         const auto &tensor_shape = out_oprand->data.at(b)->shape();
 
@@ -0,0 +1,340 @@
+#include "runtime/shared_weight_segment.hpp"
+#include "runtime/content_hash.hpp"
+#include "runtime/mapped_file.hpp"
+#include <chrono>
+#include <cstring>
+#include <glog/logging.h>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TinyInfer {
+
+constexpr char SharedWeightSegment::kMagic[8];
+
+namespace {
+size_t AlignSize(size_t size) {
+  const size_t alignment = SharedWeightSegment::kAlignment;
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+#ifndef _WIN32
+// 名称以'/'开头且不含其他'/'时为POSIX共享内存，否则为文件路径
+bool IsShmName(const std::string &name) {
+  return name.size() > 1 && name[0] == '/' &&
+         name.find('/', 1) == std::string::npos;
+}
+
+int OpenSegment(const std::string &name, int flags) {
+  if (IsShmName(name)) {
+    return shm_open(name.c_str(), flags, 0644);
+  }
+  return open(name.c_str(), flags, 0644);
+}
+
+// 名称是否仍然指向fd打开的段，段可能已被其他进程删除并重新创建
+bool IsSameSegment(int fd, const std::string &name) {
+  const int name_fd = OpenSegment(name, O_RDONLY);
+  if (name_fd < 0) {
+    return false;
+  }
+  struct stat fd_stat {};
+  struct stat name_stat {};
+  const bool same = fstat(fd, &fd_stat) == 0 &&
+                    fstat(name_fd, &name_stat) == 0 &&
+                    fd_stat.st_dev == name_stat.st_dev &&
+                    fd_stat.st_ino == name_stat.st_ino;
+  close(name_fd);
+  return same;
+}
+#endif
+} // namespace
+
+bool SharedWeightSegment::MakeModelKey(const std::string &param_path,
+                                       const std::string &bin_path,
+                                       ModelKey &key) {
+#ifndef _WIN32
+  const std::shared_ptr<MappedFile> param_file = MappedFile::Open(param_path);
+  if (param_file == nullptr) {
+    return false;
+  }
+  struct stat bin_stat {};
+  if (stat(bin_path.c_str(), &bin_stat) != 0) {
+    LOG(ERROR) << "Can not access the bin file: " << bin_path;
+    return false;
+  }
+
+  // 结构文件内容的哈希值，与权重文件的大小、修改时间、文件编号一起再求一次哈希
+  uint64_t values[5] = {0, 0, uint64_t(bin_stat.st_size),
+                        uint64_t(bin_stat.st_mtim.tv_sec) * 1000000000ULL +
+                            uint64_t(bin_stat.st_mtim.tv_nsec),
+                        uint64_t(bin_stat.st_ino)};
+  ContentHash(reinterpret_cast<const char *>(param_file->data()),
+              param_file->size(), values[0], values[1]);
+  ContentHash(reinterpret_cast<const char *>(values), sizeof(values),
+              key.hash[0], key.hash[1]);
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::shared_ptr<SharedWeightSegment>
+SharedWeightSegment::Create(const std::string &name, const ModelKey &key,
+                            const std::vector<Entry> &entries) {
+#ifndef _WIN32
+  // 目录中依次存放各权重的名称长度、名称、偏移量和元素数
+  std::string directory;
+  const auto append = [&directory](const void *data, size_t size) {
+    directory.append(static_cast<const char *>(data), size);
+  };
+  size_t directory_size = 0;
+  for (const Entry &entry : entries) {
+    directory_size += sizeof(uint32_t) + entry.name.size() + sizeof(uint64_t) * 2;
+  }
+
+  const uint64_t data_offset = AlignSize(sizeof(Header) + directory_size);
+  uint64_t data_end = data_offset;
+  std::vector<uint64_t> offsets;
+  for (const Entry &entry : entries) {
+    uint64_t elem_ct = 0;
+    for (const sftensor &tensor : entry.tensors) {
+      elem_ct += tensor->size();
+    }
+    offsets.push_back(data_end);
+    const uint32_t name_size = entry.name.size();
+    append(&name_size, sizeof(name_size));
+    append(entry.name.data(), entry.name.size());
+    append(&offsets.back(), sizeof(uint64_t));
+    append(&elem_ct, sizeof(uint64_t));
+    data_end = AlignSize(data_end + elem_ct * sizeof(float));
+  }
+  const size_t total_size = data_end;
+
+  // 独占创建：已存在时说明其他进程已经（或正在）创建
+  const int fd = OpenSegment(name, O_CREAT | O_EXCL | O_RDWR);
+  if (fd < 0) {
+    if (errno != EEXIST) {
+      LOG(ERROR) << "Can not create the shared weight segment: " << name;
+    }
+    return nullptr;
+  }
+  if (ftruncate(fd, total_size) != 0) {
+    LOG(ERROR) << "Can not resize the shared weight segment: " << name;
+    close(fd);
+    Remove(name);
+    return nullptr;
+  }
+  void *addr =
+      mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "Can not map the shared weight segment: " << name;
+    Remove(name);
+    return nullptr;
+  }
+
+  std::shared_ptr<SharedWeightSegment> segment(new SharedWeightSegment());
+  segment->name_ = name;
+  segment->data_ = static_cast<uint8_t *>(addr);
+  segment->size_ = total_size;
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.ready = 0;
+  header.key[0] = key.hash[0];
+  header.key[1] = key.hash[1];
+  header.entry_count = entries.size();
+  header.directory_offset = sizeof(Header);
+  header.directory_size = directory.size();
+  header.data_offset = data_offset;
+  header.data_size = total_size - data_offset;
+  std::memcpy(segment->data_, &header, sizeof(Header));
+  std::memcpy(segment->data_ + sizeof(Header), directory.data(),
+              directory.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    uint8_t *entry_ptr = segment->data_ + offsets.at(i);
+    for (const sftensor &tensor : entries.at(i).tensors) {
+      const size_t bytes = tensor->size() * sizeof(float);
+      std::memcpy(entry_ptr, tensor->raw_ptr(), bytes);
+      entry_ptr += bytes;
+    }
+  }
+
+  // 权重写入完毕后才置位，其他进程看到置位时一定能看到完整的权重
+  Header *mapped_header = reinterpret_cast<Header *>(segment->data_);
+  __atomic_store_n(&mapped_header->ready, 1u, __ATOMIC_RELEASE);
+  mprotect(segment->data_, segment->size_, PROT_READ);
+
+  if (!segment->ParseDirectory()) {
+    return nullptr;
+  }
+  return segment;
+#else
+  LOG(WARNING) << "Shared weight segments are not supported on this platform";
+  return nullptr;
+#endif
+}
+
+std::shared_ptr<SharedWeightSegment>
+SharedWeightSegment::Attach(const std::string &name, const ModelKey &key,
+                            uint32_t wait_ms, bool &exists) {
+  exists = false;
+#ifndef _WIN32
+  const int fd = OpenSegment(name, O_RDONLY);
+  if (fd < 0) {
+    exists = errno != ENOENT;
+    if (exists) {
+      LOG(ERROR) << "Can not open the shared weight segment: " << name;
+    }
+    return nullptr;
+  }
+  exists = true;
+
+  // 段可能正由其他进程写入，等待其置位
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_ms);
+  std::shared_ptr<SharedWeightSegment> segment;
+  while (true) {
+    struct stat segment_stat {};
+    if (fstat(fd, &segment_stat) == 0 &&
+        size_t(segment_stat.st_size) >= sizeof(Header)) {
+      void *addr = mmap(nullptr, segment_stat.st_size, PROT_READ, MAP_SHARED,
+                        fd, 0);
+      if (addr != MAP_FAILED) {
+        const Header *header = static_cast<const Header *>(addr);
+        if (__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE) == 1) {
+          segment.reset(new SharedWeightSegment());
+          segment->name_ = name;
+          segment->data_ = static_cast<uint8_t *>(addr);
+          segment->size_ = segment_stat.st_size;
+          break;
+        }
+        munmap(addr, segment_stat.st_size);
+      }
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      // 超时仍未置位，视为创建的进程在写入完毕之前退出，删除该段，由当前进程重新创建；
+      // 只删除仍由该名称指向的段，避免误删其他进程刚重新创建的段
+      if (IsSameSegment(fd, name) && Remove(name)) {
+        LOG(WARNING) << "Removed the shared weight segment which is not ready in "
+                     << wait_ms << " ms: " << name;
+        exists = false;
+      } else {
+        LOG(WARNING) << "The shared weight segment is not ready: " << name;
+      }
+      close(fd);
+      return nullptr;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  close(fd);
+
+  Header header{};
+  std::memcpy(&header, segment->data_, sizeof(Header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    LOG(WARNING) << "Not a shared weight segment of this version: " << name;
+    return nullptr;
+  }
+  if (header.key[0] != key.hash[0] || header.key[1] != key.hash[1]) {
+    LOG(WARNING) << "The shared weight segment " << name
+                 << " belongs to another model, remove it to recreate";
+    return nullptr;
+  }
+  if (!segment->ParseDirectory()) {
+    return nullptr;
+  }
+  return segment;
+#else
+  LOG(WARNING) << "Shared weight segments are not supported on this platform";
+  return nullptr;
+#endif
+}
+
+bool SharedWeightSegment::Remove(const std::string &name) {
+#ifndef _WIN32
+  if (IsShmName(name)) {
+    return shm_unlink(name.c_str()) == 0;
+  }
+  return unlink(name.c_str()) == 0;
+#else
+  return false;
+#endif
+}
+
+SharedWeightSegment::~SharedWeightSegment() {
+#ifndef _WIN32
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+#endif
+}
+
+bool SharedWeightSegment::ParseDirectory() {
+  Header header{};
+  std::memcpy(&header, data_, sizeof(Header));
+  if (header.directory_offset > size_ ||
+      header.directory_size > size_ - header.directory_offset ||
+      header.data_offset > size_ || header.data_size > size_ - header.data_offset) {
+    LOG(ERROR) << "The shared weight segment is broken: " << name_;
+    return false;
+  }
+
+  const uint8_t *ptr = data_ + header.directory_offset;
+  const uint8_t *end = ptr + header.directory_size;
+  const auto read = [&ptr, end](void *value, size_t size) {
+    if (size_t(end - ptr) < size) {
+      return false;
+    }
+    std::memcpy(value, ptr, size);
+    ptr += size;
+    return true;
+  };
+
+  locations_.clear();
+  for (uint64_t i = 0; i < header.entry_count; ++i) {
+    uint32_t name_size = 0;
+    Location location;
+    if (!read(&name_size, sizeof(name_size)) ||
+        size_t(end - ptr) < name_size) {
+      LOG(ERROR) << "The shared weight segment directory is broken: " << name_;
+      return false;
+    }
+    std::string entry_name(reinterpret_cast<const char *>(ptr), name_size);
+    ptr += name_size;
+    if (!read(&location.offset, sizeof(uint64_t)) ||
+        !read(&location.elem_ct, sizeof(uint64_t)) ||
+        location.offset < header.data_offset ||
+        location.offset % kAlignment != 0 || location.offset > size_ ||
+        location.elem_ct > (size_ - location.offset) / sizeof(float)) {
+      LOG(ERROR) << "The shared weight " << entry_name
+                 << " is out of the segment: " << name_;
+      return false;
+    }
+    locations_.insert({std::move(entry_name), location});
+  }
+  return true;
+}
+
+const float *SharedWeightSegment::Find(const std::string &entry_name,
+                                       size_t elem_ct) const {
+  const auto iter = locations_.find(entry_name);
+  if (iter == locations_.end() || iter->second.elem_ct != elem_ct) {
+    return nullptr;
+  }
+  return reinterpret_cast<const float *>(data_ + iter->second.offset);
+}
+
+const std::string &SharedWeightSegment::name() const { return name_; }
+
+size_t SharedWeightSegment::size() const { return size_; }
+
+} // namespace TinyInfer
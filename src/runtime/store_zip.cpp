@@ -16,10 +16,17 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "runtime/thread_pool.hpp"
+
 namespace pnnx {
 
 // https://stackoverflow.com/questions/1537964/visual-c-equivalent-of-gccs-attribute-packed
@@ -71,37 +78,41 @@ PACK(struct end_of_central_directory_record {
        uint16_t comment_length;
      });
 
-static uint32_t CRC32_TABLE[256];
-
-static void CRC32_TABLE_INIT()
+static uint32_t CRC32_buffer(const unsigned char* data, size_t len)
 {
-  for (int i = 0; i < 256; i++)
+  uint32_t x = crc32(0L, Z_NULL, 0);
+
+  // zlib takes at most 4G bytes at a time
+  while (len > 0)
   {
-    uint32_t c = i;
-    for (int j = 0; j < 8; j++)
-    {
-      if (c & 1)
-        c = (c >> 1) ^ 0xedb88320;
-      else
-        c >>= 1;
-    }
-    CRC32_TABLE[i] = c;
+    const uInt n = len > 0x40000000 ? 0x40000000 : (uInt)len;
+    x = crc32(x, data, n);
+    data += n;
+    len -= n;
   }
-}
 
-static uint32_t CRC32(uint32_t x, unsigned char ch)
-{
-  return (x >> 8) ^ CRC32_TABLE[(x ^ ch) & 0xff];
+  return x;
 }
 
-static uint32_t CRC32_buffer(const unsigned char* data, int len)
+// decompress raw deflate data, return false if the data is broken or the size does not match
+static bool inflate_buffer(const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_size)
 {
-  uint32_t x = 0xffffffff;
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+    return false;
+
+  zs.next_in = (Bytef*)src;
+  zs.avail_in = (uInt)src_size;
+  zs.next_out = (Bytef*)dst;
+  zs.avail_out = (uInt)dst_size;
 
-  for (int i = 0; i < len; i++)
-    x = CRC32(x, data[i]);
+  int ret = inflate(&zs, Z_FINISH);
+  const bool ok = ret == Z_STREAM_END && zs.total_out == dst_size;
 
-  return x ^ 0xffffffff;
+  inflateEnd(&zs);
+
+  return ok;
 }
 
 StoreZipReader::StoreZipReader()
@@ -114,7 +125,17 @@ StoreZipReader::~StoreZipReader()
   close();
 }
 
-int StoreZipReader::open(const std::string& path)
+int StoreZipReader::open(const std::string& path, bool map_file, int num_threads)
+{
+  return open(path, map_file, 0, num_threads);
+}
+
+int StoreZipReader::open(const std::string& path, bool map_file, TinyInfer::ThreadPool* pool)
+{
+  return open(path, map_file, pool, 1);
+}
+
+int StoreZipReader::open(const std::string& path, bool map_file, TinyInfer::ThreadPool* pool, int num_threads)
 {
   close();
 
@@ -144,29 +165,80 @@ int StoreZipReader::open(const std::string& path)
         return -1;
       }
 
-      if (lfh.compression != 0 || lfh.compressed_size != lfh.uncompressed_size)
-      {
-        fprintf(stderr, "not stored zip file %d %d\n", lfh.compressed_size, lfh.uncompressed_size);
-        return -1;
-      }
-
       // file name
       std::string name;
       name.resize(lfh.file_name_length);
       fread((char*)name.data(), name.size(), 1, fp);
 
-      // skip extra field
-      fseek(fp, lfh.extra_field_length, SEEK_CUR);
+      // extra field, zip64 entries keep the real sizes in it, as numpy npz files do
+      std::vector<unsigned char> extra(lfh.extra_field_length);
+      fread((char*)extra.data(), extra.size(), 1, fp);
+
+      uint64_t compressed_size = lfh.compressed_size;
+      uint64_t uncompressed_size = lfh.uncompressed_size;
+      if (lfh.compressed_size == 0xffffffff || lfh.uncompressed_size == 0xffffffff)
+      {
+        bool has_zip64 = false;
+        size_t pos = 0;
+        while (pos + 4 <= extra.size())
+        {
+          uint16_t id;
+          uint16_t size;
+          memcpy(&id, &extra[pos], 2);
+          memcpy(&size, &extra[pos + 2], 2);
+          pos += 4;
+          if (id == 0x0001 && pos + size <= extra.size())
+          {
+            // uncompressed size comes first, each field is present only if the header field is 0xffffffff
+            size_t field = pos;
+            if (lfh.uncompressed_size == 0xffffffff && field + 8 <= pos + size)
+            {
+              memcpy(&uncompressed_size, &extra[field], 8);
+              field += 8;
+            }
+            if (lfh.compressed_size == 0xffffffff && field + 8 <= pos + size)
+            {
+              memcpy(&compressed_size, &extra[field], 8);
+              field += 8;
+            }
+            has_zip64 = true;
+            break;
+          }
+          pos += size;
+        }
+
+        if (!has_zip64)
+        {
+          fprintf(stderr, "zip64 extra field of %s not found\n", name.c_str());
+          return -1;
+        }
+      }
+
+      if (lfh.compression != 0 && lfh.compression != 8)
+      {
+        fprintf(stderr, "unsupported compression method %d\n", lfh.compression);
+        return -1;
+      }
+
+      if (lfh.compression == 0 && compressed_size != uncompressed_size)
+      {
+        fprintf(stderr, "not stored zip file %lu %lu\n", (unsigned long)compressed_size, (unsigned long)uncompressed_size);
+        return -1;
+      }
 
       StoreZipMeta fm;
       fm.offset = ftell(fp);
-      fm.size = lfh.compressed_size;
+      fm.size = compressed_size;
+      fm.uncompressed_size = uncompressed_size;
+      fm.compression = lfh.compression;
+      fm.crc32 = lfh.crc32;
+      fm.decoded_offset = (size_t)-1;
 
       filemetas[name] = fm;
 
       //             fprintf(stderr, "%s = %d  %d\n", name.c_str(), fm.offset, fm.size);
 
-      fseek(fp, lfh.compressed_size, SEEK_CUR);
+      fseek(fp, fm.size, SEEK_CUR);
     }
     else if (signature == 0x02014b50)
     {
@@ -182,6 +254,18 @@ int StoreZipReader::open(const std::string& path)
       // skip file comment
       fseek(fp, cdfh.file_comment_length, SEEK_CUR);
     }
+    else if (signature == 0x06064b50)
+    {
+      // zip64 end of central directory record, skip it
+      uint64_t record_size;
+      fread((char*)&record_size, sizeof(record_size), 1, fp);
+      fseek(fp, record_size, SEEK_CUR);
+    }
+    else if (signature == 0x07064b50)
+    {
+      // zip64 end of central directory locator, skip it
+      fseek(fp, 16, SEEK_CUR);
+    }
     else if (signature == 0x06054b50)
     {
       end_of_central_directory_record eocdr;
@@ -197,39 +281,200 @@ int StoreZipReader::open(const std::string& path)
     }
   }
 
+  if (get_compressed_file_count() > 0)
+    return decode_files(path, map_file, pool, num_threads);
+
+  if (map_file && !filemetas.empty())
+  {
+    mapped_file = TinyInfer::MappedFile::Open(path);
+    if (!mapped_file)
+    {
+      fprintf(stderr, "map failed\n");
+      return -1;
+    }
+
+    for (const auto& fm : filemetas)
+    {
+      if (fm.second.offset + fm.second.size > mapped_file->size())
+      {
+        fprintf(stderr, "file %s out of range\n", fm.first.c_str());
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+int StoreZipReader::decode_files(const std::string& path, bool map_file, TinyInfer::ThreadPool* pool, int num_threads)
+{
+  std::shared_ptr<TinyInfer::MappedFile> source = TinyInfer::MappedFile::Open(path);
+  if (!source)
+  {
+    fprintf(stderr, "map failed\n");
+    return -1;
+  }
+
+  // lay out the decoded entries, each aligned to DATA_ALIGNMENT bytes
+  std::vector<std::pair<std::string, StoreZipMeta*> > entries;
+  size_t decoded_size = 0;
+  for (auto& fm : filemetas)
+  {
+    if (fm.second.offset + fm.second.size > source->size())
+    {
+      fprintf(stderr, "file %s out of range\n", fm.first.c_str());
+      return -1;
+    }
+
+    if (fm.second.compression == 0 && !map_file)
+      continue;
+
+    fm.second.decoded_offset = decoded_size;
+    decoded_size += (fm.second.uncompressed_size + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    entries.push_back(std::make_pair(fm.first, &fm.second));
+  }
+
+  std::shared_ptr<TinyInfer::MappedFile> decoded = TinyInfer::MappedFile::Allocate(path, decoded_size);
+  if (!decoded)
+  {
+    fprintf(stderr, "allocate failed\n");
+    return -1;
+  }
+
+  // the entries are independent of each other, decompress several of them at once,
+  // with no more threads than deflated entries
+  std::unique_ptr<TinyInfer::ThreadPool> own_pool;
+  if (!pool)
+  {
+    if (num_threads <= 0)
+      num_threads = std::max((int)std::thread::hardware_concurrency(), 1);
+    num_threads = (int)std::min((size_t)num_threads, get_compressed_file_count());
+    if (num_threads > 1)
+    {
+      own_pool.reset(new TinyInfer::ThreadPool(num_threads));
+      pool = own_pool.get();
+    }
+  }
+
+  std::vector<char> decoded_ok(entries.size(), 0);
+  TinyInfer::ParallelFor(pool, entries.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+    {
+      const StoreZipMeta& fm = *entries[i].second;
+      const unsigned char* src = source->data() + fm.offset;
+      unsigned char* dst = decoded->data() + fm.decoded_offset;
+
+      if (fm.compression == 0)
+      {
+        memcpy(dst, src, fm.size);
+        decoded_ok[i] = 1;
+        continue;
+      }
+
+      decoded_ok[i] = inflate_buffer(src, fm.size, dst, fm.uncompressed_size)
+                      && CRC32_buffer(dst, fm.uncompressed_size) == fm.crc32;
+    }
+  });
+
+  for (size_t i = 0; i < entries.size(); i++)
+  {
+    if (!decoded_ok[i])
+    {
+      fprintf(stderr, "file %s is broken\n", entries[i].first.c_str());
+      return -1;
+    }
+  }
+
+  decoded_file = decoded;
+  if (map_file)
+    mapped_file = decoded;
+
   return 0;
 }
 
-size_t StoreZipReader::get_file_size(const std::string& name)
+size_t StoreZipReader::get_file_size(const std::string& name) const
 {
-  if (filemetas.find(name) == filemetas.end())
+  const auto it = filemetas.find(name);
+  if (it == filemetas.end())
   {
     fprintf(stderr, "no such file %s\n", name.c_str());
     return 0;
   }
 
-  return filemetas[name].size;
+  return it->second.uncompressed_size;
 }
 
 int StoreZipReader::read_file(const std::string& name, char* data)
 {
-  if (filemetas.find(name) == filemetas.end())
+  const auto it = filemetas.find(name);
+  if (it == filemetas.end())
   {
     fprintf(stderr, "no such file %s\n", name.c_str());
     return -1;
   }
 
-  size_t offset = filemetas[name].offset;
-  size_t size = filemetas[name].size;
+  const StoreZipMeta& fm = it->second;
+  if (fm.decoded_offset != (size_t)-1)
+  {
+    memcpy(data, decoded_file->data() + fm.decoded_offset, fm.uncompressed_size);
+    return 0;
+  }
 
-  fseek(fp, offset, SEEK_SET);
-  fread(data, size, 1, fp);
+  fseek(fp, fm.offset, SEEK_SET);
+  fread(data, fm.size, 1, fp);
 
   return 0;
 }
 
+const char* StoreZipReader::get_file_data(const std::string& name) const
+{
+  if (!mapped_file)
+    return 0;
+
+  const auto it = filemetas.find(name);
+  if (it == filemetas.end())
+    return 0;
+
+  if (it->second.decoded_offset != (size_t)-1)
+    return (const char*)mapped_file->data() + it->second.decoded_offset;
+
+  return (const char*)mapped_file->data() + it->second.offset;
+}
+
+std::shared_ptr<TinyInfer::MappedFile> StoreZipReader::get_mapped_file() const
+{
+  return mapped_file;
+}
+
+size_t StoreZipReader::get_compressed_file_count() const
+{
+  size_t count = 0;
+  for (const auto& fm : filemetas)
+  {
+    if (fm.second.compression != 0)
+      count++;
+  }
+
+  return count;
+}
+
+std::vector<std::string> StoreZipReader::get_names() const
+{
+  std::vector<std::string> names;
+  for (const auto& fm : filemetas)
+  {
+    names.push_back(fm.first);
+  }
+
+  return names;
+}
+
 int StoreZipReader::close()
 {
+  mapped_file.reset();
+  decoded_file.reset();
+  filemetas.clear();
+
   if (!fp)
     return 0;
 
@@ -242,8 +487,7 @@ int StoreZipReader::close()
 StoreZipWriter::StoreZipWriter()
 {
   fp = 0;
-
-  CRC32_TABLE_INIT();
+  compression_level = 0;
 }
 
 StoreZipWriter::~StoreZipWriter()
@@ -251,10 +495,12 @@ StoreZipWriter::~StoreZipWriter()
   close();
 }
 
-int StoreZipWriter::open(const std::string& path)
+int StoreZipWriter::open(const std::string& path, int compression_level)
 {
   close();
 
+  this->compression_level = compression_level;
+
   fp = fopen(path.c_str(), "wb");
   if (!fp)
   {
@@ -274,29 +520,63 @@ int StoreZipWriter::write_file(const std::string& name, const char* data, size_t
 
   uint32_t crc32 = CRC32_buffer((const unsigned char*)data, size);
 
+  // deflate the entry, keep it stored if it does not shrink
+  std::vector<char> compressed;
+  if (compression_level > 0 && size > 0)
+  {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, compression_level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK)
+    {
+      compressed.resize(deflateBound(&zs, size));
+      zs.next_in = (Bytef*)data;
+      zs.avail_in = (uInt)size;
+      zs.next_out = (Bytef*)compressed.data();
+      zs.avail_out = (uInt)compressed.size();
+
+      int ret = deflate(&zs, Z_FINISH);
+      compressed.resize(ret == Z_STREAM_END && zs.total_out < size ? zs.total_out : 0);
+
+      deflateEnd(&zs);
+    }
+  }
+
+  const bool deflated = !compressed.empty();
+  const char* entry_data = deflated ? compressed.data() : data;
+  const size_t entry_size = deflated ? compressed.size() : size;
+
+  // pad the extra field to align the stored entry data, deflated entries are decompressed into aligned memory
+  size_t data_offset = offset + sizeof(signature) + sizeof(local_file_header) + name.size();
+  size_t padding = deflated ? 0 : (DATA_ALIGNMENT - data_offset % DATA_ALIGNMENT) % DATA_ALIGNMENT;
+
   local_file_header lfh;
-  lfh.version = 0;
+  lfh.version = deflated ? 20 : 0;
   lfh.flag = 0;
-  lfh.compression = 0;
+  lfh.compression = deflated ? 8 : 0;
   lfh.last_modify_time = 0;
   lfh.last_modify_date = 0;
   lfh.crc32 = crc32;
-  lfh.compressed_size = size;
+  lfh.compressed_size = entry_size;
   lfh.uncompressed_size = size;
   lfh.file_name_length = name.size();
-  lfh.extra_field_length = 0;
+  lfh.extra_field_length = padding;
 
   fwrite((char*)&lfh, sizeof(lfh), 1, fp);
 
   fwrite((char*)name.c_str(), name.size(), 1, fp);
 
-  fwrite(data, size, 1, fp);
+  const char zeros[DATA_ALIGNMENT] = {0};
+  fwrite(zeros, padding, 1, fp);
+
+  fwrite(entry_data, entry_size, 1, fp);
 
   StoreZipMeta szm;
   szm.name = name;
   szm.lfh_offset = offset;
   szm.crc32 = crc32;
   szm.size = size;
+  szm.compressed_size = entry_size;
+  szm.compression = lfh.compression;
 
   filemetas.push_back(szm);
 
@@ -317,13 +597,13 @@ int StoreZipWriter::close()
 
     central_directory_file_header cdfh;
     cdfh.version_made = 0;
-    cdfh.version = 0;
+    cdfh.version = szm.compression ? 20 : 0;
     cdfh.flag = 0;
-    cdfh.compression = 0;
+    cdfh.compression = szm.compression;
     cdfh.last_modify_time = 0;
     cdfh.last_modify_date = 0;
     cdfh.crc32 = szm.crc32;
-    cdfh.compressed_size = szm.size;
+    cdfh.compressed_size = szm.compressed_size;
     cdfh.uncompressed_size = szm.size;
     cdfh.file_name_length = szm.name.size();
     cdfh.extra_field_length = 0;
@@ -0,0 +1,141 @@
+#include "runtime/thread_pool.hpp"
+#include <algorithm>
+#include <glog/logging.h>
+#include <utility>
+
+namespace TinyInfer {
+
+namespace {
+// 当前线程所属的线程池及其在线程池中的编号
+thread_local const ThreadPool *tls_pool = nullptr;
+thread_local uint32_t tls_index = 0;
+} // namespace
+
+ThreadPool::ThreadPool(uint32_t thread_num) {
+  CHECK(thread_num > 0) << "The thread number of thread pool is zero";
+  for (uint32_t i = 0; i < thread_num; ++i) {
+    queues_.push_back(std::make_unique<WorkQueue>());
+  }
+  for (uint32_t i = 0; i < thread_num; ++i) {
+    workers_.emplace_back([this, i]() { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  task_cv_.notify_all();
+  for (auto &worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+void ThreadPool::Submit(Task task) {
+  CHECK(task != nullptr) << "The submitted task is empty";
+
+  // 工作线程提交的任务放入自己的队列，外部线程提交的任务轮流放入各队列
+  uint32_t index = 0;
+  if (tls_pool == this) {
+    index = tls_index;
+  } else {
+    index = next_queue_.fetch_add(1, std::memory_order_relaxed) %
+            queues_.size();
+  }
+
+  unfinished_.fetch_add(1);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_.fetch_add(1);
+  }
+  {
+    WorkQueue &queue = *queues_.at(index);
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  task_cv_.notify_one();
+}
+
+void ThreadPool::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this]() { return unfinished_.load() == 0; });
+}
+
+uint32_t ThreadPool::thread_num() const { return workers_.size(); }
+
+bool ThreadPool::PopTask(uint32_t index, Task &task) {
+  // 从自己队列的尾部取出最近提交的任务
+  {
+    WorkQueue &queue = *queues_.at(index);
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+
+  // 从其他队列的头部窃取最早提交的任务
+  const uint32_t queue_num = queues_.size();
+  for (uint32_t i = 1; i < queue_num; ++i) {
+    WorkQueue &queue = *queues_.at((index + i) % queue_num);
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::WorkerLoop(uint32_t index) {
+  tls_pool = this;
+  tls_index = index;
+
+  while (true) {
+    Task task;
+    if (PopTask(index, task)) {
+      task();
+      if (unfinished_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_cv_.notify_all();
+      }
+      continue;
+    }
+
+    // 没有可执行的任务，等待新任务提交
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_cv_.wait(lock, [this]() { return stop_ || queued_.load() > 0; });
+    if (stop_ && queued_.load() == 0) {
+      break;
+    }
+  }
+}
+
+void ParallelFor(ThreadPool *pool, size_t count,
+                 const std::function<void(size_t, size_t)> &func) {
+  if (count == 0) {
+    return;
+  }
+  if (pool == nullptr || pool->thread_num() == 1 || count == 1) {
+    func(0, count);
+    return;
+  }
+
+  // 分段数多于线程数，耗时不均时空闲线程可以窃取剩余的段
+  const size_t chunk_num = std::min(count, size_t(pool->thread_num()) * 4);
+  const size_t chunk_size = (count + chunk_num - 1) / chunk_num;
+  for (size_t begin = 0; begin < count; begin += chunk_size) {
+    const size_t end = std::min(begin + chunk_size, count);
+    pool->Submit([&func, begin, end]() { func(begin, end); });
+  }
+  pool->Wait();
+}
+
+} // namespace TinyInfer
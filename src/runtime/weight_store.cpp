@@ -0,0 +1,90 @@
+#include "runtime/weight_store.hpp"
+#include "runtime/content_hash.hpp"
+#include <cstring>
+
+namespace TinyInfer {
+
+WeightStore &WeightStore::Instance() {
+  static WeightStore *store = new WeightStore;
+  return *store;
+}
+
+std::string WeightStore::MakeKey(const char *data, size_t byte_size,
+                                 const std::vector<uint32_t> &layout) {
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  ContentHash(data, byte_size, h1, h2);
+
+  // 键为哈希值、字节数和维度的二进制拼接
+  const uint64_t size = byte_size;
+  std::string key(sizeof(uint64_t) * 3 + layout.size() * sizeof(uint32_t),
+                  '\0');
+  std::memcpy(key.data(), &h1, sizeof(uint64_t));
+  std::memcpy(key.data() + sizeof(uint64_t), &h2, sizeof(uint64_t));
+  std::memcpy(key.data() + sizeof(uint64_t) * 2, &size, sizeof(uint64_t));
+  if (!layout.empty()) {
+    std::memcpy(key.data() + sizeof(uint64_t) * 3, layout.data(),
+                layout.size() * sizeof(uint32_t));
+  }
+  return key;
+}
+
+std::shared_ptr<const WeightStore::Blob>
+WeightStore::GetOrCreate(const std::string &key,
+                         const std::function<Blob()> &create) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto iter = blobs_.find(key);
+    if (iter != blobs_.end()) {
+      if (auto blob = iter->second.lock()) {
+        return blob;
+      }
+    }
+  }
+
+  // 转换权重的布局较慢，在锁外执行
+  auto created = std::make_shared<const Blob>(create());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::weak_ptr<const Blob> &slot = blobs_[key];
+  if (auto blob = slot.lock()) {
+    return blob;
+  }
+  slot = created;
+  RemoveExpired();
+  return created;
+}
+
+void WeightStore::RemoveExpired() {
+  for (auto iter = blobs_.begin(); iter != blobs_.end();) {
+    if (iter->second.expired()) {
+      iter = blobs_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+size_t WeightStore::blob_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (const auto &[key, blob] : blobs_) {
+    if (!blob.expired()) {
+      count += 1;
+    }
+  }
+  return count;
+}
+
+size_t WeightStore::blob_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t bytes = 0;
+  for (const auto &[key, weak_blob] : blobs_) {
+    if (auto blob = weak_blob.lock()) {
+      bytes += blob->size() * sizeof(float);
+    }
+  }
+  return bytes;
+}
+
+} // namespace TinyInfer
@@ -1,4 +1,6 @@
 #include "data/load_data.hpp"
+#include <cstdio>
+#include <fstream>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 #include <string>
@@ -145,4 +147,56 @@ TEST(test_load, load_empty_data) {
   const arma::fmat &data =
       CSVDataLoader::LoadData(test_file_dir + "notexists.csv", ',');
   ASSERT_EQ(data.empty(), true);
-}
\ No newline at end of file
+}
+
+TEST(test_load, load_csv_format) {
+  // 空白、正号、科学计数法、行尾分隔符和\r\n换行，空行之后的内容被忽略
+  const std::string file_path = "./load_csv_format.csv";
+  {
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    file << " 1.5,\t+2,-3e-2,\r\n"
+            "4,abc\r\n"
+            "\n"
+            "7,8,9,10,11\n";
+  }
+  const arma::fmat &data = CSVDataLoader::LoadData(file_path);
+  ASSERT_EQ(data.n_rows, 2);
+  ASSERT_EQ(data.n_cols, 4);
+  ASSERT_EQ(data.at(0, 0), 1.5f);
+  ASSERT_EQ(data.at(0, 1), 2.f);
+  ASSERT_EQ(data.at(0, 2), -3e-2f);
+  ASSERT_EQ(data.at(0, 3), 0.f);
+  ASSERT_EQ(data.at(1, 0), 4.f);
+  ASSERT_EQ(data.at(1, 1), 0.f);
+  ASSERT_EQ(data.at(1, 2), 0.f);
+  std::remove(file_path.c_str());
+}
+
+TEST(test_load, load_csv_rows) {
+  // 行数较多时并行解析各行，结果与写入的值相同
+  const std::string file_path = "./load_csv_rows.csv";
+  const uint32_t rows = 2000;
+  const uint32_t cols = 37;
+  arma::fmat expected(rows, cols);
+  {
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    char buffer[32];
+    for (uint32_t i = 0; i < rows; ++i) {
+      for (uint32_t j = 0; j < cols; ++j) {
+        std::snprintf(buffer, sizeof(buffer), "%.6f",
+                      float(i) * 0.5f - float(j) * 0.125f);
+        expected.at(i, j) = std::stof(buffer);
+        file << buffer << (j + 1 < cols ? "," : "\n");
+      }
+    }
+  }
+  const arma::fmat &data = CSVDataLoader::LoadData(file_path);
+  ASSERT_EQ(data.n_rows, rows);
+  ASSERT_EQ(data.n_cols, cols);
+  for (uint32_t i = 0; i < rows; ++i) {
+    for (uint32_t j = 0; j < cols; ++j) {
+      ASSERT_EQ(data.at(i, j), expected.at(i, j));
+    }
+  }
+  std::remove(file_path.c_str());
+}
@@ -0,0 +1,135 @@
+#include "data/npy_file.hpp"
+#include <cstdio>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+using namespace TinyInfer;
+
+const std::string npy_file_dir = "../../tmp/npy/";
+
+TEST(test_npy, save_load) {
+  // 行数、列数均大于1的通道需要转置，读取时复制
+  const std::string file_path = "./test_npy_save_load.npy";
+  sftensor tensor = std::make_shared<ftensor>(3, 4, 5);
+  tensor->Rand();
+  ASSERT_TRUE(NpyFile::Save(file_path, tensor));
+  const sftensor loaded = NpyFile::Load(file_path);
+  ASSERT_NE(loaded, nullptr);
+  ASSERT_EQ(loaded->raw_shape(), tensor->raw_shape());
+  ASSERT_TRUE(arma::approx_equal(loaded->data(), tensor->data(), "absdiff",
+                                 0.f));
+
+  // 一维的Tensor内存布局相同，直接使用映射的内存，释放文件后仍然可用
+  sftensor vector = std::make_shared<ftensor>(1, 1, 17);
+  vector->Rand();
+  ASSERT_TRUE(NpyFile::Save(file_path, vector));
+  const sftensor loaded_vector = NpyFile::Load(file_path);
+  std::remove(file_path.c_str());
+  ASSERT_NE(loaded_vector, nullptr);
+  ASSERT_EQ(loaded_vector->raw_shape(), std::vector<uint32_t>{17});
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(loaded_vector->raw_ptr()) % 64, 0);
+  for (uint32_t i = 0; i < 17; ++i) {
+    ASSERT_EQ(loaded_vector->index(i), vector->index(i));
+  }
+}
+
+TEST(test_npy, save_load_batch) {
+  const std::string file_path = "./test_npy_save_load_batch.npy";
+  std::vector<sftensor> batch;
+  for (uint32_t i = 0; i < 4; ++i) {
+    sftensor tensor = std::make_shared<ftensor>(2, 3, 1);
+    tensor->Rand();
+    batch.push_back(tensor);
+  }
+  ASSERT_TRUE(NpyFile::SaveBatch(file_path, batch));
+  const std::vector<sftensor> loaded = NpyFile::LoadBatch(file_path);
+  ASSERT_EQ(loaded.size(), batch.size());
+  for (uint32_t i = 0; i < batch.size(); ++i) {
+    ASSERT_EQ(loaded.at(i)->shape(), batch.at(i)->shape());
+    ASSERT_TRUE(arma::approx_equal(loaded.at(i)->data(),
+                                   batch.at(i)->data(), "absdiff", 0.f));
+  }
+
+  // 批次中的Tensor维度不同
+  batch.push_back(std::make_shared<ftensor>(2, 1, 3));
+  ASSERT_FALSE(NpyFile::SaveBatch(file_path, batch));
+  std::remove(file_path.c_str());
+}
+
+TEST(test_npy, save_load_npz) {
+  const std::string file_path = "./test_npy_save_load.npz";
+  std::map<std::string, std::vector<sftensor>> arrays;
+  for (const std::string name : {"input", "output"}) {
+    for (uint32_t i = 0; i < 2; ++i) {
+      sftensor tensor = std::make_shared<ftensor>(3, 8, 8);
+      tensor->Fill(float(i) + (name == "input" ? 0.5f : -0.5f));
+      arrays[name].push_back(tensor);
+    }
+  }
+  for (const int compression_level : {0, 6}) {
+    ASSERT_TRUE(NpyFile::SaveNpz(file_path, arrays, compression_level));
+    const auto loaded = NpyFile::LoadNpz(file_path);
+    ASSERT_EQ(loaded.size(), arrays.size());
+    for (const auto &[name, tensors] : arrays) {
+      ASSERT_NE(loaded.find(name), loaded.end());
+      ASSERT_EQ(loaded.at(name).size(), tensors.size());
+      for (uint32_t i = 0; i < tensors.size(); ++i) {
+        ASSERT_TRUE(arma::approx_equal(loaded.at(name).at(i)->data(),
+                                       tensors.at(i)->data(), "absdiff",
+                                       0.f));
+      }
+    }
+  }
+  std::remove(file_path.c_str());
+}
+
+TEST(test_npy, load_numpy_files) {
+  // NumPy写入的zip64条目，不压缩和压缩两种
+  for (const std::string name : {"reference.npz", "reference_compressed.npz"}) {
+    const auto arrays = NpyFile::LoadNpz(npy_file_dir + name);
+    ASSERT_EQ(arrays.size(), 2);
+
+    // 行主序的float32数组，形状为(2, 3, 4, 5)，值为arange * 0.5
+    const std::vector<sftensor> &input = arrays.at("input");
+    ASSERT_EQ(input.size(), 2);
+    for (uint32_t b = 0; b < 2; ++b) {
+      ASSERT_EQ(input.at(b)->shape(), std::vector<uint32_t>({3, 4, 5}));
+      for (uint32_t c = 0; c < 3; ++c) {
+        for (uint32_t r = 0; r < 4; ++r) {
+          for (uint32_t col = 0; col < 5; ++col) {
+            ASSERT_EQ(input.at(b)->at(c, r, col),
+                      float(((b * 3 + c) * 4 + r) * 5 + col) * 0.5f);
+          }
+        }
+      }
+    }
+
+    // 列主序的float64数组，形状为(1, 3, 4)
+    const std::vector<sftensor> &matrix = arrays.at("matrix");
+    ASSERT_EQ(matrix.size(), 1);
+    ASSERT_EQ(matrix.front()->raw_shape(), std::vector<uint32_t>({3, 4}));
+    for (uint32_t r = 0; r < 3; ++r) {
+      for (uint32_t col = 0; col < 4; ++col) {
+        ASSERT_EQ(matrix.front()->at(0, r, col), float(r * 4 + col));
+      }
+    }
+  }
+
+  // 列主序的float32矩阵与Tensor的内存布局相同
+  const sftensor matrix = NpyFile::Load(npy_file_dir + "matrix_f.npy");
+  ASSERT_NE(matrix, nullptr);
+  for (uint32_t r = 0; r < 3; ++r) {
+    for (uint32_t col = 0; col < 4; ++col) {
+      ASSERT_EQ(matrix->at(0, r, col), float(r * 4 + col));
+    }
+  }
+
+  // int64数组转换为float
+  const sftensor labels = NpyFile::Load(npy_file_dir + "labels.npy");
+  ASSERT_NE(labels, nullptr);
+  ASSERT_EQ(labels->raw_shape(), std::vector<uint32_t>{4});
+  ASSERT_EQ(labels->values(), std::vector<float>({3.f, -1.f, 7.f, 0.f}));
+
+  ASSERT_EQ(NpyFile::Load(npy_file_dir + "notexists.npy"), nullptr);
+  ASSERT_TRUE(NpyFile::LoadBatch(npy_file_dir + "notexists.npy").empty());
+}
@@ -20,6 +20,21 @@ TEST(test_tensor, tensor_init2) {
   ASSERT_EQ(f1.size(), 224 * 224 * 3);
 }
 
+TEST(test_tensor, tensor_init3) {
+  // 在外部内存上创建张量，写入张量即写入外部内存
+  std::vector<float> buffer(3 * 4 * 5, 0.f);
+  ftensor f1(buffer.data(), 3, 4, 5);
+  ASSERT_EQ(f1.channels(), 3);
+  ASSERT_EQ(f1.rows(), 4);
+  ASSERT_EQ(f1.cols(), 5);
+  ASSERT_EQ(f1.raw_ptr(), buffer.data());
+
+  f1.Fill(2.f);
+  for (const float value : buffer) {
+    ASSERT_EQ(value, 2.f);
+  }
+}
+
 TEST(test_tensor, copy_construct1) {
   ftensor f1(3, 224, 224);
   f1.Rand();
@@ -1,5 +1,9 @@
 #include "kernel/abstract/attr_kernel.hpp"
+#include "runtime/store_zip.hpp"
+#include <cstdio>
+#include <cstring>
 #include <gtest/gtest.h>
+#include <numeric>
 
 using namespace TinyInfer;
 
@@ -127,3 +131,119 @@ TEST(test_attr_kernel, init_bias) {
     ASSERT_EQ(bias.at(i)->cols(), 1);
   }
 }
+
+TEST(test_attr_kernel, load_mapped_weights) {
+  // 权重文件中按行主序存放2个(3,2,4)的权重和2个偏置
+  const std::string path = "./mapped_weights.bin";
+  std::vector<float> weight_values(2 * 3 * 2 * 4);
+  std::iota(weight_values.begin(), weight_values.end(), 0.f);
+  const std::vector<float> bias_values{1.f, 2.f};
+  {
+    pnnx::StoreZipWriter writer;
+    ASSERT_EQ(writer.open(path), 0);
+    writer.write_file("attr.weight", (const char *)weight_values.data(),
+                      weight_values.size() * sizeof(float));
+    writer.write_file("attr.bias", (const char *)bias_values.data(),
+                      bias_values.size() * sizeof(float));
+    writer.close();
+  }
+
+  pnnx::StoreZipReader reader;
+  ASSERT_EQ(reader.open(path, true), 0);
+  const char *weight_data = reader.get_file_data("attr.weight");
+  const char *bias_data = reader.get_file_data("attr.bias");
+  ASSERT_NE(weight_data, nullptr);
+  ASSERT_NE(bias_data, nullptr);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(weight_data) % 64, 0);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(bias_data) % 64, 0);
+
+  RuntimeAttr weight_attr;
+  weight_attr.type = RuntimeDataType::TypeFloat32;
+  weight_attr.mapped_data = weight_data;
+  weight_attr.mapped_size = weight_values.size() * sizeof(float);
+  RuntimeAttr bias_attr;
+  bias_attr.type = RuntimeDataType::TypeFloat32;
+  bias_attr.mapped_data = bias_data;
+  bias_attr.mapped_size = bias_values.size() * sizeof(float);
+
+  AttrKernel attr_kernel("attr");
+  attr_kernel.InitWeights(2, 3, 2, 4);
+  attr_kernel.InitBias(2, 1, 1, 1);
+  attr_kernel.LoadWeights(weight_attr);
+  attr_kernel.LoadBias(bias_attr);
+
+  // 权重Tensor直接使用映射的内存
+  ASSERT_EQ((const char *)attr_kernel.weights().front()->raw_ptr(),
+            weight_data);
+  ASSERT_EQ((const char *)attr_kernel.bias().front()->raw_ptr(), bias_data);
+  ASSERT_EQ(weight_attr.mapped_data, nullptr);
+  ASSERT_NE(weight_attr.packed_data, nullptr);
+
+  // 与复制加载的结果相同
+  AttrKernel expected_kernel("expected");
+  expected_kernel.InitWeights(2, 3, 2, 4);
+  expected_kernel.InitBias(2, 1, 1, 1);
+  expected_kernel.set_weights(weight_values);
+  expected_kernel.set_bias(bias_values);
+  for (uint32_t i = 0; i < 2; ++i) {
+    const auto &weight = attr_kernel.weights().at(i);
+    const auto &expected_weight = expected_kernel.weights().at(i);
+    ASSERT_EQ(weight->shape(), expected_weight->shape());
+    for (uint32_t j = 0; j < weight->size(); ++j) {
+      ASSERT_EQ(weight->index(j), expected_weight->index(j));
+    }
+    ASSERT_EQ(attr_kernel.bias().at(i)->index(0), bias_values.at(i));
+  }
+
+  reader.close();
+  std::remove(path.c_str());
+}
+
+TEST(test_attr_kernel, load_shared_weights) {
+  // 2个(3,2,4)的权重，按行主序存放
+  std::vector<float> weight_values(2 * 3 * 2 * 4);
+  std::iota(weight_values.begin(), weight_values.end(), 0.f);
+  const auto make_attr = [&weight_values]() {
+    RuntimeAttr attr;
+    attr.type = RuntimeDataType::TypeFloat32;
+    attr.weight_data.resize(weight_values.size() * sizeof(float));
+    std::memcpy(attr.weight_data.data(), weight_values.data(),
+                attr.weight_data.size());
+    attr.share = true;
+    return attr;
+  };
+
+  // 内容相同的权重只保存一份
+  RuntimeAttr attr1 = make_attr();
+  RuntimeAttr attr2 = make_attr();
+  AttrKernel attr_kernel1("attr1");
+  AttrKernel attr_kernel2("attr2");
+  attr_kernel1.InitWeights(2, 3, 2, 4);
+  attr_kernel2.InitWeights(2, 3, 2, 4);
+  attr_kernel1.LoadWeights(attr1);
+  attr_kernel2.LoadWeights(attr2);
+  ASSERT_EQ(attr_kernel1.weights().front()->raw_ptr(),
+            attr_kernel2.weights().front()->raw_ptr());
+  ASSERT_TRUE(attr1.weight_data.empty());
+
+  // 与复制加载的结果相同
+  AttrKernel expected_kernel("expected");
+  expected_kernel.InitWeights(2, 3, 2, 4);
+  expected_kernel.set_weights(weight_values);
+  for (uint32_t i = 0; i < 2; ++i) {
+    const auto &weight = attr_kernel1.weights().at(i);
+    const auto &expected_weight = expected_kernel.weights().at(i);
+    ASSERT_EQ(weight->shape(), expected_weight->shape());
+    for (uint32_t j = 0; j < weight->size(); ++j) {
+      ASSERT_EQ(weight->index(j), expected_weight->index(j));
+    }
+  }
+
+  // 内容相同但维度不同的权重内存布局不同，不共享
+  RuntimeAttr attr3 = make_attr();
+  AttrKernel attr_kernel3("attr3");
+  attr_kernel3.InitWeights(2, 3, 4, 2);
+  attr_kernel3.LoadWeights(attr3);
+  ASSERT_NE(attr_kernel1.weights().front()->raw_ptr(),
+            attr_kernel3.weights().front()->raw_ptr());
+}
@@ -80,6 +80,32 @@ InferStatus ConvolutionFunc(const std::vector<sftensor> &inputs,
   return InferStatus::InferSuccess;
 }
 
+// 在kernel元素之间补零，得到与膨胀卷积等价的kernel
+std::vector<sftensor> DilateKernels(const std::vector<sftensor> &kernels,
+                                    uint32_t dilation_h,
+                                    uint32_t dilation_w = 0) {
+  if (dilation_w == 0) {
+    dilation_w = dilation_h;
+  }
+  std::vector<sftensor> dilated;
+  for (const auto &kernel : kernels) {
+    sftensor dilated_kernel = std::make_shared<ftensor>(
+        kernel->channels(), dilation_h * (kernel->rows() - 1) + 1,
+        dilation_w * (kernel->cols() - 1) + 1);
+    dilated_kernel->Fill(0.f);
+    for (uint32_t c = 0; c < kernel->channels(); ++c) {
+      for (uint32_t i = 0; i < kernel->rows(); ++i) {
+        for (uint32_t j = 0; j < kernel->cols(); ++j) {
+          dilated_kernel->at(c, i * dilation_h, j * dilation_w) =
+              kernel->at(c, i, j);
+        }
+      }
+    }
+    dilated.push_back(dilated_kernel);
+  }
+  return dilated;
+}
+
 TEST(test_kernel, conv3x3x32_stride1x1_padding0) {
   const uint32_t batch = 8;
   std::vector<sftensor> inputs(batch);
@@ -112,7 +138,8 @@ TEST(test_kernel, conv3x3x32_stride1x1_padding0) {
     const uint32_t out_size = outputs1.at(b)->size();
     for (uint32_t i = 0; i < out_size; ++i) {
       ASSERT_LE(std::abs(outputs1.at(b)->index(i) - outputs2.at(b)->index(i)),
-                1e-4);
+                Convolution::kWinogradTolerance *
+                    std::sqrt(float(in_channels * kernel_h * kernel_w)));
     }
   }
 }
@@ -149,7 +176,8 @@ TEST(test_kernel, conv3x3x32_stride1x1_padding2) {
     const uint32_t out_size = outputs1.at(b)->size();
     for (uint32_t i = 0; i < out_size; ++i) {
       ASSERT_LE(std::abs(outputs1.at(b)->index(i) - outputs2.at(b)->index(i)),
-                1e-4);
+                Convolution::kWinogradTolerance *
+                    std::sqrt(float(in_channels * kernel_h * kernel_w)));
     }
   }
 }
@@ -384,4 +412,283 @@ TEST(test_kernel, conv13x13x31_stride19x19_padding2) {
                 1e-3);
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(test_kernel, conv3x3_group4_stride2x1) {
+  const uint32_t batch = 2;
+  const uint32_t in_channels = 8;
+  const uint32_t groups = 4;
+  const uint32_t ginput_c = in_channels / groups;
+  std::vector<sftensor> inputs(batch);
+  for (uint32_t b = 0; b < batch; ++b) {
+    inputs.at(b) = std::make_shared<ftensor>(in_channels, 11, 9);
+    inputs.at(b)->Rand();
+  }
+  const uint32_t kernel_h = 3;
+  const uint32_t kernel_w = 3;
+  const uint32_t stride_h = 2;
+  const uint32_t stride_w = 1;
+  const uint32_t kernel_ct = 12;
+  const uint32_t gkernel_ct = kernel_ct / groups;
+  std::vector<sftensor> weights(kernel_ct);
+  std::vector<float> weight_values;
+  for (uint32_t k = 0; k < kernel_ct; ++k) {
+    weights.at(k) = std::make_shared<ftensor>(ginput_c, kernel_h, kernel_w);
+    weights.at(k)->Rand();
+    const std::vector<float> values = weights.at(k)->values(true);
+    weight_values.insert(weight_values.end(), values.begin(), values.end());
+  }
+
+  // 逐组计算作为参考
+  std::vector<sftensor> outputs1(batch);
+  for (uint32_t b = 0; b < batch; ++b) {
+    for (uint32_t g = 0; g < groups; ++g) {
+      std::vector<sftensor> ginputs{std::make_shared<ftensor>(ginput_c, 11, 9)};
+      for (uint32_t ic = 0; ic < ginput_c; ++ic) {
+        ginputs.front()->slice(ic) = inputs.at(b)->slice(g * ginput_c + ic);
+      }
+      std::vector<sftensor> goutputs(1);
+      ConvolutionFunc(ginputs, goutputs, stride_h, stride_w,
+                      {weights.begin() + g * gkernel_ct,
+                       weights.begin() + (g + 1) * gkernel_ct});
+      if (outputs1.at(b) == nullptr) {
+        outputs1.at(b) = std::make_shared<ftensor>(
+            kernel_ct, goutputs.front()->rows(), goutputs.front()->cols());
+      }
+      for (uint32_t k = 0; k < gkernel_ct; ++k) {
+        outputs1.at(b)->slice(g * gkernel_ct + k) = goutputs.front()->slice(k);
+      }
+    }
+  }
+
+  // 分别设置为各自开辟内存的kernels（复制后计算）和连续存放的kernels（直接使用权重内存）
+  Convolution conv1(kernel_ct, in_channels, kernel_h, kernel_w, 0, 0, stride_h,
+                    stride_w, groups, false);
+  conv1.set_weights(weights);
+  Convolution conv2(kernel_ct, in_channels, kernel_h, kernel_w, 0, 0, stride_h,
+                    stride_w, groups, false);
+  conv2.set_weights(weight_values);
+  for (Convolution *conv : {&conv1, &conv2}) {
+    std::vector<sftensor> outputs2(batch);
+    ASSERT_EQ(conv->Forward(inputs, outputs2), InferStatus::InferSuccess);
+    for (uint32_t b = 0; b < batch; ++b) {
+      ASSERT_EQ(outputs1.at(b)->shape(), outputs2.at(b)->shape());
+      const uint32_t out_size = outputs1.at(b)->size();
+      for (uint32_t i = 0; i < out_size; ++i) {
+        ASSERT_LE(
+            std::abs(outputs1.at(b)->index(i) - outputs2.at(b)->index(i)),
+            1e-4);
+      }
+    }
+  }
+}
+
+TEST(test_kernel, conv3x3_winograd) {
+  // 3x3、步长为1、不分组且输入通道数足够时自动使用Winograd
+  ASSERT_TRUE(Convolution(16, 16, 3, 3, 1, 1).use_winograd());
+  ASSERT_FALSE(Convolution(16, 8, 3, 3, 1, 1).use_winograd());
+  ASSERT_FALSE(Convolution(16, 16, 3, 3, 1, 1, 2, 2).use_winograd());
+  ASSERT_FALSE(Convolution(16, 32, 3, 3, 1, 1, 1, 1, 2).use_winograd());
+  ASSERT_FALSE(Convolution(16, 16, 5, 5, 1, 1).use_winograd());
+
+  // 输出的行数、列数不是4的倍数时，边缘的分块只写入一部分
+  const std::vector<std::vector<uint32_t>> shapes = {
+      // 输入通道数，kernel数目，行数，列数，扩充
+      {3, 8, 10, 7, 1},  {8, 16, 9, 13, 1},  {32, 8, 8, 8, 0},
+      {64, 32, 20, 20, 1}, {128, 64, 7, 7, 1}, {256, 16, 6, 11, 0}};
+  for (const auto &shape : shapes) {
+    const uint32_t in_channels = shape.at(0);
+    const uint32_t kernel_ct = shape.at(1);
+    const uint32_t padding = shape.at(4);
+    std::vector<sftensor> inputs(2);
+    for (auto &input : inputs) {
+      input = std::make_shared<ftensor>(in_channels, shape.at(2), shape.at(3));
+      input->Rand();
+    }
+    std::vector<sftensor> weights(kernel_ct);
+    for (auto &weight : weights) {
+      weight = std::make_shared<ftensor>(in_channels, 3, 3);
+      weight->Rand();
+    }
+    std::vector<float> bias(kernel_ct);
+    for (uint32_t k = 0; k < kernel_ct; ++k) {
+      bias.at(k) = float(k) * 0.1f - 0.4f;
+    }
+
+    Convolution winograd(kernel_ct, in_channels, 3, 3, padding, padding, 1, 1,
+                         1, true, ActivationType::ActivationRelu);
+    winograd.set_weights(weights);
+    winograd.set_bias(bias);
+    winograd.set_use_winograd(true);
+    Convolution im2col(kernel_ct, in_channels, 3, 3, padding, padding, 1, 1, 1,
+                       true, ActivationType::ActivationRelu);
+    im2col.set_weights(weights);
+    im2col.set_bias(bias);
+    im2col.set_use_winograd(false);
+
+    std::vector<sftensor> outputs1(2);
+    std::vector<sftensor> outputs2(2);
+    ASSERT_EQ(winograd.Forward(inputs, outputs1), InferStatus::InferSuccess);
+    ASSERT_EQ(im2col.Forward(inputs, outputs2), InferStatus::InferSuccess);
+    // 误差随kernel中元素数目的平方根增长
+    const float tolerance =
+        Convolution::kWinogradTolerance * std::sqrt(float(in_channels * 9));
+    for (uint32_t b = 0; b < 2; ++b) {
+      ASSERT_EQ(outputs1.at(b)->shape(), outputs2.at(b)->shape());
+      for (uint32_t i = 0; i < outputs1.at(b)->size(); ++i) {
+        const float diff =
+            std::abs(outputs1.at(b)->index(i) - outputs2.at(b)->index(i));
+        ASSERT_LE(diff, tolerance);
+      }
+    }
+  }
+}
+
+TEST(test_kernel, conv1x1_pointwise) {
+  const uint32_t batch = 2;
+  const uint32_t in_channels = 16;
+  std::vector<sftensor> inputs(batch);
+  for (uint32_t b = 0; b < batch; ++b) {
+    inputs.at(b) = std::make_shared<ftensor>(in_channels, 13, 10);
+    inputs.at(b)->Rand();
+  }
+  const uint32_t kernel_ct = 24;
+  std::vector<sftensor> weights(kernel_ct);
+  for (uint32_t k = 0; k < kernel_ct; ++k) {
+    weights.at(k) = std::make_shared<ftensor>(in_channels, 1, 1);
+    weights.at(k)->Rand();
+  }
+
+  // 步长为1时直接使用输入的内存，步长大于1时按步长抽取
+  for (const uint32_t stride : {1u, 2u, 3u}) {
+    std::vector<sftensor> outputs1(batch);
+    std::vector<sftensor> outputs2(batch);
+    ConvolutionFunc(inputs, outputs1, stride, stride, weights);
+    Convolution conv(kernel_ct, in_channels, 1, 1, 0, 0, stride, stride, 1,
+                     false);
+    conv.set_weights(weights);
+    ASSERT_EQ(conv.Forward(inputs, outputs2), InferStatus::InferSuccess);
+    for (uint32_t b = 0; b < batch; ++b) {
+      ASSERT_EQ(outputs1.at(b)->shape(), outputs2.at(b)->shape());
+      const uint32_t out_size = outputs1.at(b)->size();
+      for (uint32_t i = 0; i < out_size; ++i) {
+        ASSERT_LE(
+            std::abs(outputs1.at(b)->index(i) - outputs2.at(b)->index(i)),
+            1e-4);
+      }
+    }
+  }
+}
+
+TEST(test_kernel, conv_depthwise) {
+  // kernel大小，步长，扩充，每个输入通道的kernel数目，行数，列数，膨胀
+  const std::vector<std::vector<uint32_t>> configs = {
+      {3, 1, 1, 1, 11, 9, 1}, {3, 2, 1, 1, 11, 9, 1}, {5, 1, 2, 1, 12, 7, 1},
+      {5, 2, 2, 2, 12, 7, 1}, {3, 1, 0, 2, 6, 5, 1},  {5, 2, 1, 1, 9, 10, 1},
+      {3, 2, 1, 1, 2, 3, 1},  {5, 1, 2, 1, 4, 3, 1},  {3, 1, 2, 1, 11, 9, 2},
+      {3, 2, 4, 1, 13, 10, 4}, {5, 1, 3, 2, 12, 12, 3}, {5, 2, 2, 1, 11, 9, 2}};
+  const uint32_t channels = 6;
+  for (const auto &config : configs) {
+    const uint32_t kernel_size = config.at(0);
+    const uint32_t stride = config.at(1);
+    const uint32_t padding = config.at(2);
+    const uint32_t multiplier = config.at(3);
+    const uint32_t dilation = config.at(6);
+    const uint32_t kernel_ct = channels * multiplier;
+
+    std::vector<sftensor> inputs{
+        std::make_shared<ftensor>(channels, config.at(4), config.at(5))};
+    inputs.front()->Rand();
+    std::vector<sftensor> weights(kernel_ct);
+    for (auto &weight : weights) {
+      weight = std::make_shared<ftensor>(1, kernel_size, kernel_size);
+      weight->Rand();
+    }
+    // 膨胀卷积等价于kernel元素之间补零后的普通卷积
+    const std::vector<sftensor> dilated_weights =
+        DilateKernels(weights, dilation);
+
+    // 逐通道扩充后计算作为参考
+    const sftensor padded =
+        Pad(inputs.front(), {padding, padding, padding, padding}, 0.f);
+    sftensor expected;
+    for (uint32_t c = 0; c < channels; ++c) {
+      std::vector<sftensor> cinputs{
+          std::make_shared<ftensor>(1, padded->rows(), padded->cols())};
+      cinputs.front()->slice(0) = padded->slice(c);
+      std::vector<sftensor> coutputs(1);
+      ConvolutionFunc(cinputs, coutputs, stride, stride,
+                      {dilated_weights.begin() + c * multiplier,
+                       dilated_weights.begin() + (c + 1) * multiplier});
+      if (expected == nullptr) {
+        expected = std::make_shared<ftensor>(
+            kernel_ct, coutputs.front()->rows(), coutputs.front()->cols());
+      }
+      for (uint32_t m = 0; m < multiplier; ++m) {
+        expected->slice(c * multiplier + m) = coutputs.front()->slice(m);
+      }
+    }
+
+    Convolution conv(kernel_ct, channels, kernel_size, kernel_size, padding,
+                     padding, stride, stride, channels, false,
+                     ActivationType::ActivationNone, false, dilation, dilation);
+    conv.set_weights(weights);
+    std::vector<sftensor> outputs(1);
+    ASSERT_EQ(conv.Forward(inputs, outputs), InferStatus::InferSuccess);
+    ASSERT_EQ(outputs.front()->shape(), expected->shape());
+    for (uint32_t i = 0; i < expected->size(); ++i) {
+      ASSERT_LE(std::abs(outputs.front()->index(i) - expected->index(i)), 1e-4);
+    }
+  }
+}
+
+TEST(test_kernel, conv_dilation) {
+  // kernel大小，步长，扩充，行膨胀，列膨胀
+  const std::vector<std::vector<uint32_t>> configs = {
+      {3, 1, 2, 2, 2}, {3, 2, 2, 2, 2}, {3, 1, 0, 3, 1}, {5, 1, 4, 2, 2},
+      {3, 1, 6, 6, 6}};
+  const uint32_t in_channels = 24;
+  const uint32_t kernel_ct = 16;
+  for (const auto &config : configs) {
+    const uint32_t kernel_size = config.at(0);
+    const uint32_t stride = config.at(1);
+    const uint32_t padding = config.at(2);
+    std::vector<sftensor> inputs{
+        std::make_shared<ftensor>(in_channels, 17, 15)};
+    inputs.front()->Rand();
+    std::vector<sftensor> weights(kernel_ct);
+    for (auto &weight : weights) {
+      weight = std::make_shared<ftensor>(in_channels, kernel_size, kernel_size);
+      weight->Rand();
+    }
+
+    std::vector<sftensor> padded{
+        Pad(inputs.front(), {padding, padding, padding, padding}, 0.f)};
+    std::vector<sftensor> outputs1(1);
+    ConvolutionFunc(padded, outputs1, stride, stride,
+                    DilateKernels(weights, config.at(3), config.at(4)));
+
+    // 膨胀卷积不使用Winograd
+    Convolution conv(kernel_ct, in_channels, kernel_size, kernel_size, padding,
+                     padding, stride, stride, 1, false,
+                     ActivationType::ActivationNone, false, config.at(3),
+                     config.at(4));
+    ASSERT_FALSE(conv.use_winograd());
+    conv.set_weights(weights);
+
+    std::vector<std::vector<uint32_t>> input_shapes{
+        inputs.front()->shape()};
+    std::vector<uint32_t> output_shape;
+    ASSERT_TRUE(conv.InferShape(input_shapes, output_shape));
+    ASSERT_EQ(output_shape, outputs1.front()->shape());
+
+    std::vector<sftensor> outputs2(1);
+    ASSERT_EQ(conv.Forward(inputs, outputs2), InferStatus::InferSuccess);
+    ASSERT_EQ(outputs2.front()->shape(), outputs1.front()->shape());
+    for (uint32_t i = 0; i < outputs1.front()->size(); ++i) {
+      ASSERT_LE(
+          std::abs(outputs1.front()->index(i) - outputs2.front()->index(i)),
+          1e-4);
+    }
+  }
+}
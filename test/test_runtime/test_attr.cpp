@@ -1,4 +1,5 @@
 #include "runtime/runtime_attr.hpp"
+#include <cstring>
 #include <gtest/gtest.h>
 
 using namespace TinyInfer;
@@ -43,3 +44,17 @@ TEST(test_runtime, attr_shape) {
   ASSERT_EQ(runtime_attr.shape.at(1), 32);
   ASSERT_EQ(runtime_attr.shape.at(2), 32);
 }
+
+TEST(test_runtime, attr_mapped_data) {
+  // 映射的权重值未必按float对齐
+  const std::vector<float> values{1.f, 2.f, 3.f};
+  std::vector<char> buffer(values.size() * sizeof(float) + 1);
+  std::memcpy(buffer.data() + 1, values.data(), values.size() * sizeof(float));
+
+  RuntimeAttr runtime_attr;
+  runtime_attr.type = RuntimeDataType::TypeFloat32;
+  runtime_attr.mapped_data = buffer.data() + 1;
+  runtime_attr.mapped_size = values.size() * sizeof(float);
+  ASSERT_EQ(runtime_attr.get<float>(), values);
+  ASSERT_EQ(runtime_attr.mapped_data, nullptr);
+}
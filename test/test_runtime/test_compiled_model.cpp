@@ -0,0 +1,126 @@
+#include "runtime/compiled_model.hpp"
+#include "runtime/runtime_graph.hpp"
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace TinyInfer;
+
+namespace {
+void CheckTensorsEqual(const std::vector<sftensor> &outputs,
+                       const std::vector<sftensor> &expected) {
+  ASSERT_EQ(outputs.size(), expected.size());
+  for (uint32_t b = 0; b < outputs.size(); ++b) {
+    ASSERT_EQ(outputs.at(b)->shape(), expected.at(b)->shape());
+    for (uint32_t i = 0; i < outputs.at(b)->size(); ++i) {
+      ASSERT_EQ(outputs.at(b)->index(i), expected.at(b)->index(i));
+    }
+  }
+}
+} // namespace
+
+TEST(test_compiled_model, save_and_load) {
+  const std::string model_path = "./group_conv.tinyinfer";
+  RuntimeGraph graph("../../tmp/group_conv/group_conv.pnnx.param",
+                     "../../tmp/group_conv/group_conv.pnnx.bin");
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+  ASSERT_TRUE(CompiledModel::Save(graph, model_path));
+
+  std::unique_ptr<RuntimeGraph> loaded = CompiledModel::Load(model_path);
+  ASSERT_NE(loaded, nullptr);
+  ASSERT_EQ(loaded->input_names(), graph.input_names());
+  ASSERT_EQ(loaded->output_names(), graph.output_names());
+  ASSERT_EQ(loaded->planned_activation_bytes(2),
+            graph.planned_activation_bytes(2));
+
+  // 结构文件中声明的维度和其他维度下的结果均与原计算图相同
+  for (const uint32_t rows : {16, 20}) {
+    std::vector<sftensor> inputs;
+    for (uint32_t b = 0; b < 2; ++b) {
+      sftensor input = std::make_shared<ftensor>(4, rows, 16);
+      input->Rand();
+      inputs.push_back(input);
+    }
+    const auto &expected = graph.Forward(inputs, false);
+    const auto &outputs = loaded->Forward(inputs, false);
+    CheckTensorsEqual(outputs, expected);
+  }
+
+  // 加载后仍可并发执行
+  loaded->set_max_concurrent_ops(2);
+  std::vector<sftensor> inputs;
+  sftensor input = std::make_shared<ftensor>(4, 16, 16);
+  input->Rand();
+  inputs.push_back(input);
+  CheckTensorsEqual(loaded->Forward(inputs, false),
+                    graph.Forward(inputs, false));
+  loaded.reset();
+  std::remove(model_path.c_str());
+}
+
+TEST(test_compiled_model, save_and_load_multiple_io) {
+  const std::string model_path = "./multi_io.tinyinfer";
+  const std::vector<std::string> input_names{"pnnx_input_0", "pnnx_input_1"};
+  const std::vector<std::string> output_names{"pnnx_output_1", "relu"};
+  RuntimeGraph graph("../../tmp/multi_io/multi_io.pnnx.param",
+                     "../../tmp/multi_io/multi_io.pnnx.bin");
+  graph.set_max_concurrent_ops(2);
+  graph.Build(input_names, output_names);
+  ASSERT_TRUE(CompiledModel::Save(graph, model_path));
+
+  std::unique_ptr<RuntimeGraph> loaded = CompiledModel::Load(model_path);
+  ASSERT_NE(loaded, nullptr);
+  ASSERT_EQ(loaded->input_names(), input_names);
+  ASSERT_EQ(loaded->output_names(), output_names);
+  ASSERT_EQ(loaded->max_concurrent_ops(), 2);
+
+  std::map<std::string, std::vector<sftensor>> inputs;
+  for (const auto &input_name : input_names) {
+    for (uint32_t b = 0; b < 3; ++b) {
+      sftensor input = std::make_shared<ftensor>(4, 8, 8);
+      input->Rand();
+      inputs[input_name].push_back(input);
+    }
+  }
+  const auto &expected = graph.Forward(inputs, false);
+  const auto &outputs = loaded->Forward(inputs, false);
+  for (const auto &output_name : output_names) {
+    CheckTensorsEqual(outputs.at(output_name), expected.at(output_name));
+  }
+  loaded.reset();
+  std::remove(model_path.c_str());
+}
+
+TEST(test_compiled_model, load_broken_file) {
+  const std::string model_path = "./resnet_add3.tinyinfer";
+  ASSERT_EQ(CompiledModel::Load("./not_exist.tinyinfer"), nullptr);
+
+  RuntimeGraph graph("../../tmp/add/resnet_add3.pnnx.param",
+                     "../../tmp/add/resnet_add3.pnnx.bin");
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+  ASSERT_TRUE(CompiledModel::Save(graph, model_path));
+
+  std::string content;
+  {
+    std::ifstream file(model_path, std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+  }
+  ASSERT_GT(content.size(), sizeof(CompiledModel::kMagic));
+
+  // 截断的文件
+  {
+    std::ofstream file(model_path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), content.size() / 2);
+  }
+  ASSERT_EQ(CompiledModel::Load(model_path), nullptr);
+
+  // 文件标识错误
+  {
+    std::string broken = content;
+    broken.at(0) = 'X';
+    std::ofstream file(model_path, std::ios::binary | std::ios::trunc);
+    file.write(broken.data(), broken.size());
+  }
+  ASSERT_EQ(CompiledModel::Load(model_path), nullptr);
+  std::remove(model_path.c_str());
+}
@@ -0,0 +1,47 @@
+#include "runtime/memory_planner.hpp"
+#include "runtime/runtime_graph.hpp"
+#include <gtest/gtest.h>
+
+using namespace TinyInfer;
+
+TEST(test_memory_planner, reuse_disjoint_blocks) {
+  // 生命周期不重叠的内存块共享同一段内存
+  MemoryPlanner planner;
+  const uint32_t block1 = planner.AddBlock(1024, 0, 1);
+  const uint32_t block2 = planner.AddBlock(1024, 2, 3);
+  planner.Plan();
+
+  ASSERT_EQ(planner.naive_bytes(), 2048);
+  ASSERT_EQ(planner.planned_bytes(), 1024);
+  ASSERT_EQ(planner.offset(block1), planner.offset(block2));
+}
+
+TEST(test_memory_planner, separate_overlapped_blocks) {
+  // 生命周期重叠的内存块互不覆盖
+  MemoryPlanner planner;
+  const uint32_t block1 = planner.AddBlock(1000, 0, 2);
+  const uint32_t block2 = planner.AddBlock(500, 1, 3);
+  const uint32_t block3 = planner.AddBlock(300, 3, 4);
+  planner.Plan();
+
+  const size_t size1 = MemoryPlanner::AlignSize(1000);
+  const size_t size2 = MemoryPlanner::AlignSize(500);
+  ASSERT_EQ(size1 % MemoryPlanner::kAlignment, 0);
+  ASSERT_EQ(planner.live_peak_bytes(), size1 + size2);
+  ASSERT_EQ(planner.planned_bytes(), size1 + size2);
+
+  const size_t offset1 = planner.offset(block1);
+  const size_t offset2 = planner.offset(block2);
+  ASSERT_TRUE(offset1 + size1 <= offset2 || offset2 + size2 <= offset1);
+  // block3与block1不重叠，可以复用block1的内存
+  ASSERT_EQ(planner.offset(block3), offset1);
+}
+
+TEST(test_memory_planner, graph_activation_memory) {
+  RuntimeGraph graph("../../tmp/add/resnet_add3.pnnx.param",
+                     "../../tmp/add/resnet_add3.pnnx.bin");
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  ASSERT_GT(graph.naive_activation_bytes(), 0);
+  ASSERT_LE(graph.planned_activation_bytes(), graph.naive_activation_bytes());
+}
@@ -0,0 +1,112 @@
+#include "runtime/model_holder.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+using namespace TinyInfer;
+
+namespace {
+std::unique_ptr<RuntimeGraph> BuildGraph() {
+  auto graph = std::make_unique<RuntimeGraph>(
+      "../../tmp/add/resnet_add3.pnnx.param",
+      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph->Build("pnnx_input_0", "pnnx_output_0");
+  return graph;
+}
+
+std::vector<sftensor> MakeInputs() {
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < 2; ++b) {
+    sftensor input = std::make_shared<ftensor>(1, 4, 4);
+    input->Rand();
+    inputs.push_back(input);
+  }
+  return inputs;
+}
+} // namespace
+
+TEST(test_model_holder, reload) {
+  ModelHolder holder(BuildGraph());
+  ASSERT_EQ(holder.version(), 1);
+
+  const std::vector<sftensor> inputs = MakeInputs();
+  const std::vector<sftensor> outputs = holder.Forward(inputs);
+
+  // 切换前占用的旧版本在切换后仍可使用
+  ModelHolder::Lease lease = holder.Acquire();
+  ASSERT_EQ(lease.version(), 1);
+  const RuntimeGraph *old_graph = &lease.graph();
+
+  std::future<bool> reloaded =
+      holder.Reload(BuildGraph, {{"pnnx_input_0", inputs}});
+  ASSERT_TRUE(reloaded.get());
+  ASSERT_EQ(holder.version(), 2);
+
+  ModelHolder::Lease new_lease = holder.Acquire();
+  ASSERT_EQ(new_lease.version(), 2);
+  ASSERT_NE(&new_lease.graph(), old_graph);
+
+  const auto &old_outputs = lease.graph().Forward(lease.context(), inputs);
+  const std::vector<sftensor> new_outputs = holder.Forward(inputs);
+  ASSERT_EQ(outputs.size(), new_outputs.size());
+  for (uint32_t b = 0; b < outputs.size(); ++b) {
+    ASSERT_TRUE(arma::approx_equal(outputs.at(b)->data(),
+                                   old_outputs.at(b)->data(), "absdiff", 1e-5));
+    ASSERT_TRUE(arma::approx_equal(outputs.at(b)->data(),
+                                   new_outputs.at(b)->data(), "absdiff", 1e-5));
+  }
+}
+
+TEST(test_model_holder, reload_failed) {
+  ModelHolder holder(BuildGraph());
+
+  // 构建失败时保留当前版本
+  ASSERT_FALSE(holder.Reload([]() { return nullptr; }).get());
+  ASSERT_FALSE(holder
+                   .Reload([]() -> std::unique_ptr<RuntimeGraph> {
+                     throw std::runtime_error("no such model");
+                   })
+                   .get());
+  ASSERT_EQ(holder.version(), 1);
+
+  // 多次切换按调用顺序执行
+  std::future<bool> reloaded1 = holder.Reload(BuildGraph);
+  std::future<bool> reloaded2 = holder.Reload(BuildGraph);
+  ASSERT_TRUE(reloaded1.get());
+  ASSERT_TRUE(reloaded2.get());
+  ASSERT_EQ(holder.version(), 3);
+  ASSERT_EQ(holder.Forward(MakeInputs()).size(), 2);
+}
+
+TEST(test_model_holder, forward_during_reload) {
+  // 切换期间持续推理，结果始终正确
+  ModelHolder holder(BuildGraph());
+  const std::vector<sftensor> inputs = MakeInputs();
+  const std::vector<sftensor> expected = holder.Forward(inputs);
+
+  std::atomic<bool> stop{false};
+  std::atomic<uint32_t> mismatch{0};
+  std::vector<std::thread> workers;
+  for (uint32_t i = 0; i < 2; ++i) {
+    workers.emplace_back([&]() {
+      while (!stop.load()) {
+        const std::vector<sftensor> outputs = holder.Forward(inputs);
+        for (uint32_t b = 0; b < outputs.size(); ++b) {
+          if (!arma::approx_equal(outputs.at(b)->data(),
+                                  expected.at(b)->data(), "absdiff", 1e-5)) {
+            mismatch.fetch_add(1);
+          }
+        }
+      }
+    });
+  }
+  ASSERT_TRUE(holder.Reload(BuildGraph).get());
+  ASSERT_TRUE(holder.Reload(BuildGraph).get());
+  stop.store(true);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  ASSERT_EQ(mismatch.load(), 0);
+  ASSERT_EQ(holder.version(), 3);
+}
@@ -0,0 +1,68 @@
+#include "runtime/runtime_graph.hpp"
+#include <gtest/gtest.h>
+
+using namespace TinyInfer;
+
+namespace {
+std::vector<sftensor> CloneOutputs(const std::vector<sftensor> &outputs) {
+  std::vector<sftensor> cloned;
+  for (const auto &output : outputs) {
+    cloned.push_back(output->Clone());
+  }
+  return cloned;
+}
+} // namespace
+
+TEST(test_op_fusion, fused_graph_same_result) {
+  // 模型中包含Conv→ReLU、Conv→add→ReLU、Conv→add、Conv→Hardswish，
+  // 以及残差来自卷积输入、不能融合的Conv→add
+  RuntimeGraph fused_graph("../../tmp/fusion/conv_fusion.pnnx.param",
+                           "../../tmp/fusion/conv_fusion.pnnx.bin");
+  ASSERT_TRUE(fused_graph.fuse_ops());
+  fused_graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  RuntimeGraph graph("../../tmp/fusion/conv_fusion.pnnx.param",
+                     "../../tmp/fusion/conv_fusion.pnnx.bin");
+  graph.set_fuse_ops(false);
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  // 被融合的节点不再输出中间结果
+  ASSERT_LT(fused_graph.naive_activation_bytes(),
+            graph.naive_activation_bytes());
+
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < 3; ++b) {
+    sftensor input = std::make_shared<ftensor>(4, 8, 8);
+    input->Rand();
+    inputs.push_back(input);
+  }
+  const auto &expected = CloneOutputs(graph.Forward(inputs, false));
+  const auto &outputs = fused_graph.Forward(inputs, false);
+  ASSERT_EQ(outputs.size(), expected.size());
+  for (uint32_t b = 0; b < outputs.size(); ++b) {
+    ASSERT_TRUE(arma::approx_equal(outputs.at(b)->data(),
+                                   expected.at(b)->data(), "absdiff", 1e-5));
+  }
+}
+
+TEST(test_op_fusion, fused_graph_concurrent_and_reshaped) {
+  // 融合后的计算图同样支持并发执行和其他输入维度
+  RuntimeGraph fused_graph("../../tmp/fusion/conv_fusion.pnnx.param",
+                           "../../tmp/fusion/conv_fusion.pnnx.bin");
+  fused_graph.set_max_concurrent_ops(3);
+  fused_graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  RuntimeGraph graph("../../tmp/fusion/conv_fusion.pnnx.param",
+                     "../../tmp/fusion/conv_fusion.pnnx.bin");
+  graph.set_fuse_ops(false);
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  std::vector<sftensor> inputs{std::make_shared<ftensor>(4, 13, 6)};
+  inputs.front()->Rand();
+  const auto &expected = CloneOutputs(graph.Forward(inputs, false));
+  const auto &outputs = fused_graph.Forward(inputs, false);
+  ASSERT_EQ(outputs.size(), 1);
+  ASSERT_EQ(outputs.front()->shape(), std::vector<uint32_t>({8, 13, 6}));
+  ASSERT_TRUE(arma::approx_equal(outputs.front()->data(),
+                                 expected.front()->data(), "absdiff", 1e-5));
+}
@@ -0,0 +1,376 @@
+#include "runtime/param_parser.hpp"
+#include "runtime/store_zip.hpp"
+#include "runtime/thread_pool.hpp"
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace TinyInfer;
+
+namespace {
+// 检查解析得到的参数与pnnx解析的参数相同
+void CheckParam(const RuntimeParam *param, const pnnx::Parameter &pnnx_param) {
+  ASSERT_NE(param, nullptr);
+  ASSERT_EQ(int(param->type), pnnx_param.type);
+  switch (param->type) {
+  case RuntimeParamType::ParamBool: {
+    ASSERT_EQ(dynamic_cast<const RuntimeParamBool *>(param)->value,
+              pnnx_param.b);
+    break;
+  }
+  case RuntimeParamType::ParamInt: {
+    ASSERT_EQ(dynamic_cast<const RuntimeParamInt *>(param)->value,
+              pnnx_param.i);
+    break;
+  }
+  case RuntimeParamType::ParamFloat: {
+    ASSERT_EQ(dynamic_cast<const RuntimeParamFloat *>(param)->value,
+              pnnx_param.f);
+    break;
+  }
+  case RuntimeParamType::ParamStr: {
+    ASSERT_EQ(dynamic_cast<const RuntimeParamStr *>(param)->value,
+              pnnx_param.s);
+    break;
+  }
+  case RuntimeParamType::ParamIntArray: {
+    ASSERT_EQ(dynamic_cast<const RuntimeParamIntArr *>(param)->value,
+              pnnx_param.ai);
+    break;
+  }
+  case RuntimeParamType::ParamFloatArray: {
+    ASSERT_EQ(dynamic_cast<const RuntimeParamFloatArr *>(param)->value,
+              pnnx_param.af);
+    break;
+  }
+  case RuntimeParamType::ParamStrArray: {
+    ASSERT_EQ(dynamic_cast<const RuntimeParamStrArr *>(param)->value,
+              pnnx_param.as);
+    break;
+  }
+  default: {
+    break;
+  }
+  }
+}
+
+void WriteText(const std::string &path, const std::string &text) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << text;
+}
+} // namespace
+
+TEST(test_param_parser, same_as_pnnx) {
+  const std::vector<std::string> models{
+      "../../tmp/add/resnet_add3", "../../tmp/fusion/conv_fusion",
+      "../../tmp/group_conv/group_conv", "../../tmp/multi_io/multi_io",
+      "../../tmp/softmax/softmax_dim1_-2"};
+  for (const std::string &model : models) {
+    const std::string param_path = model + ".pnnx.param";
+    const std::string bin_path = model + ".pnnx.bin";
+    std::vector<srunop> ops;
+    std::shared_ptr<MappedFile> weight_file;
+    ASSERT_TRUE(ParamParser::Parse(param_path, bin_path, ops, weight_file));
+
+    pnnx::Graph graph;
+    ASSERT_EQ(graph.load(param_path, bin_path), 0);
+    ASSERT_EQ(ops.size(), graph.ops.size());
+
+    for (uint32_t i = 0; i < ops.size(); ++i) {
+      const srunop &op = ops.at(i);
+      const pnnx::Operator *pnnx_op = graph.ops.at(i);
+      ASSERT_EQ(op->name, pnnx_op->name);
+      ASSERT_EQ(op->type, pnnx_op->type);
+
+      // 输入操作数以生产节点命名
+      ASSERT_EQ(op->in_oprands_seq.size(), pnnx_op->inputs.size());
+      for (uint32_t j = 0; j < pnnx_op->inputs.size(); ++j) {
+        const pnnx::Operand *input = pnnx_op->inputs.at(j);
+        ASSERT_EQ(op->in_oprands_seq.at(j)->name, input->producer->name);
+        ASSERT_EQ(op->in_oprands_seq.at(j)->shape, input->shape);
+      }
+
+      // 输出操作数和后继节点
+      if (pnnx_op->outputs.empty()) {
+        ASSERT_EQ(op->out_oprand, nullptr);
+      } else {
+        const pnnx::Operand *output = pnnx_op->outputs.front();
+        ASSERT_NE(op->out_oprand, nullptr);
+        ASSERT_EQ(op->out_oprand->name, output->name + "_output");
+        ASSERT_EQ(op->out_oprand->shape, output->shape);
+        ASSERT_TRUE(op->out_oprand->data.empty());
+        ASSERT_EQ(op->out_ops.size(), output->consumers.size());
+        for (const pnnx::Operator *consumer : output->consumers) {
+          ASSERT_NE(op->out_ops.find(consumer->name), op->out_ops.end());
+        }
+      }
+
+      ASSERT_EQ(op->params.size(), pnnx_op->params.size());
+      for (const auto &[name, pnnx_param] : pnnx_op->params) {
+        ASSERT_NE(op->params.find(name), op->params.end());
+        CheckParam(op->params.at(name), pnnx_param);
+      }
+
+      // 权重属性指向映射的权重文件
+      ASSERT_EQ(op->attrs.size(), pnnx_op->attrs.size());
+      for (const auto &[name, pnnx_attr] : pnnx_op->attrs) {
+        ASSERT_NE(op->attrs.find(name), op->attrs.end());
+        const srunattr &attr = op->attrs.at(name);
+        ASSERT_EQ(attr->shape, pnnx_attr.shape);
+        ASSERT_TRUE(attr->weight_data.empty());
+        ASSERT_EQ(attr->mapped_size, pnnx_attr.data.size());
+        ASSERT_EQ(std::memcmp(attr->mapped_data, pnnx_attr.data.data(),
+                              attr->mapped_size),
+                  0);
+      }
+    }
+
+    if (std::any_of(ops.begin(), ops.end(),
+                    [](const srunop &op) { return !op->attrs.empty(); })) {
+      ASSERT_NE(weight_file, nullptr);
+    }
+  }
+}
+
+TEST(test_param_parser, parallel_parse) {
+  // 在线程池中并行解析的结果与依次解析相同
+  ThreadPool pool(4);
+  const std::vector<std::string> models{
+      "../../tmp/add/resnet_add3", "../../tmp/fusion/conv_fusion",
+      "../../tmp/group_conv/group_conv", "../../tmp/multi_io/multi_io"};
+  for (const std::string &model : models) {
+    const std::string param_path = model + ".pnnx.param";
+    const std::string bin_path = model + ".pnnx.bin";
+    std::vector<srunop> ops1;
+    std::vector<srunop> ops2;
+    std::shared_ptr<MappedFile> weight_file1;
+    std::shared_ptr<MappedFile> weight_file2;
+    ASSERT_TRUE(ParamParser::Parse(param_path, bin_path, ops1, weight_file1));
+    ASSERT_TRUE(
+        ParamParser::Parse(param_path, bin_path, ops2, weight_file2, &pool));
+    ASSERT_EQ(ops1.size(), ops2.size());
+
+    for (uint32_t i = 0; i < ops1.size(); ++i) {
+      const srunop &op1 = ops1.at(i);
+      const srunop &op2 = ops2.at(i);
+      ASSERT_EQ(op1->name, op2->name);
+      ASSERT_EQ(op1->type, op2->type);
+      ASSERT_EQ(op1->in_oprands_seq.size(), op2->in_oprands_seq.size());
+      for (uint32_t j = 0; j < op1->in_oprands_seq.size(); ++j) {
+        ASSERT_EQ(op1->in_oprands_seq.at(j)->name,
+                  op2->in_oprands_seq.at(j)->name);
+        ASSERT_EQ(op1->in_oprands_seq.at(j)->shape,
+                  op2->in_oprands_seq.at(j)->shape);
+      }
+      ASSERT_EQ(op1->out_oprand == nullptr, op2->out_oprand == nullptr);
+      if (op1->out_oprand != nullptr) {
+        ASSERT_EQ(op1->out_oprand->shape, op2->out_oprand->shape);
+      }
+      ASSERT_EQ(op1->out_ops.size(), op2->out_ops.size());
+      ASSERT_EQ(op1->params.size(), op2->params.size());
+      for (const auto &[name, param] : op1->params) {
+        ASSERT_NE(op2->params.find(name), op2->params.end());
+        ASSERT_EQ(param->type, op2->params.at(name)->type);
+      }
+      ASSERT_EQ(op1->attrs.size(), op2->attrs.size());
+      for (const auto &[name, attr] : op1->attrs) {
+        ASSERT_NE(op2->attrs.find(name), op2->attrs.end());
+        ASSERT_EQ(attr->shape, op2->attrs.at(name)->shape);
+        ASSERT_EQ(attr->mapped_size, op2->attrs.at(name)->mapped_size);
+      }
+    }
+  }
+
+  // 并行解析时同样按行报告错误
+  const std::string param_path = "./parallel_parse.pnnx.param";
+  WriteText(param_path, "7767517\n"
+                        "3 2\n"
+                        "pnnx.Input  input  0 1 0\n"
+                        "Test        test   1 1 0 1 i=1x2\n"
+                        "pnnx.Output output 1 0 1\n");
+  std::vector<srunop> ops;
+  std::shared_ptr<MappedFile> weight_file;
+  ASSERT_FALSE(ParamParser::Parse(param_path,
+                                  "../../tmp/add/resnet_add3.pnnx.bin", ops,
+                                  weight_file, &pool));
+  ASSERT_TRUE(ops.empty());
+  std::remove(param_path.c_str());
+}
+
+TEST(test_param_parser, parse_values) {
+  const std::string param_path = "./parse_values.pnnx.param";
+  const std::string bin_path = "../../tmp/add/resnet_add3.pnnx.bin";
+  WriteText(param_path,
+            "7767517\n"
+            "3 2\n"
+            "pnnx.Input  input  0 1 0 #0=(?,3,8,8)f32\n"
+            "Test        test   1 1 0 1 b=True i=-3 f=1e-05 s=zeros n=None "
+            "ai=(1,-2) af=(0.5,2.0) as=[a,b] $input=0 #0=(?,3,8,8)f32 "
+            "#1=(?,3,8,8)f32\n"
+            "pnnx.Output output 1 0 1 #1=(?,3,8,8)f32\n");
+
+  std::vector<srunop> ops;
+  std::shared_ptr<MappedFile> weight_file;
+  ASSERT_TRUE(ParamParser::Parse(param_path, bin_path, ops, weight_file));
+  ASSERT_EQ(ops.size(), 3);
+
+  const srunop &op = ops.at(1);
+  ASSERT_EQ(op->in_oprands_seq.size(), 1);
+  ASSERT_EQ(op->in_oprands_seq.front()->name, "input");
+  ASSERT_EQ(op->in_oprands_seq.front()->shape,
+            std::vector<int32_t>({-1, 3, 8, 8}));
+  ASSERT_EQ(op->out_oprand->name, "1_output");
+  ASSERT_NE(ops.at(0)->out_ops.find("test"), ops.at(0)->out_ops.end());
+  ASSERT_NE(op->out_ops.find("output"), op->out_ops.end());
+
+  ASSERT_EQ(op->params.size(), 8);
+  ASSERT_EQ(dynamic_cast<RuntimeParamBool *>(op->params.at("b"))->value, true);
+  ASSERT_EQ(dynamic_cast<RuntimeParamInt *>(op->params.at("i"))->value, -3);
+  ASSERT_FLOAT_EQ(dynamic_cast<RuntimeParamFloat *>(op->params.at("f"))->value,
+                  1e-5f);
+  ASSERT_EQ(dynamic_cast<RuntimeParamStr *>(op->params.at("s"))->value,
+            "zeros");
+  ASSERT_EQ(op->params.at("n")->type, RuntimeParamType::ParamUnknown);
+  ASSERT_EQ(dynamic_cast<RuntimeParamIntArr *>(op->params.at("ai"))->value,
+            std::vector<int>({1, -2}));
+  ASSERT_EQ(dynamic_cast<RuntimeParamFloatArr *>(op->params.at("af"))->value,
+            std::vector<float>({0.5f, 2.f}));
+  ASSERT_EQ(dynamic_cast<RuntimeParamStrArr *>(op->params.at("as"))->value,
+            std::vector<std::string>({"a", "b"}));
+
+  // 引用未定义的操作数
+  WriteText(param_path, "7767517\n"
+                        "2 1\n"
+                        "pnnx.Input  input  0 1 0\n"
+                        "pnnx.Output output 1 0 1\n");
+  ASSERT_FALSE(ParamParser::Parse(param_path, bin_path, ops, weight_file));
+  ASSERT_TRUE(ops.empty());
+
+  // 节点数目多于实际的行数
+  WriteText(param_path, "7767517\n"
+                        "3 1\n"
+                        "pnnx.Input  input  0 1 0\n");
+  ASSERT_FALSE(ParamParser::Parse(param_path, bin_path, ops, weight_file));
+  std::remove(param_path.c_str());
+}
+
+TEST(test_param_parser, store_zip_deflate) {
+  // 可压缩的条目被压缩，不可压缩的条目仍不压缩存放
+  const std::string zip_path = "./store_zip_deflate.bin";
+  std::vector<float> zeros(4096, 0.f);
+  std::vector<uint32_t> values(1000);
+  uint32_t seed = 1;
+  for (uint32_t &value : values) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    value = seed;
+  }
+  {
+    pnnx::StoreZipWriter writer;
+    ASSERT_EQ(writer.open(zip_path, 6), 0);
+    writer.write_file("zeros", reinterpret_cast<const char *>(zeros.data()),
+                      zeros.size() * sizeof(float));
+    writer.write_file("values", reinterpret_cast<const char *>(values.data()),
+                      values.size() * sizeof(uint32_t));
+    writer.close();
+  }
+
+  ThreadPool pool(2);
+  for (const bool map_file : {false, true}) {
+    pnnx::StoreZipReader reader;
+    ASSERT_EQ(reader.open(zip_path, map_file, &pool), 0);
+    ASSERT_EQ(reader.get_compressed_file_count(), 1);
+    ASSERT_EQ(reader.get_file_size("zeros"), zeros.size() * sizeof(float));
+    ASSERT_EQ(reader.get_file_size("values"), values.size() * sizeof(uint32_t));
+
+    std::vector<float> data(zeros.size(), 1.f);
+    ASSERT_EQ(reader.read_file("zeros", reinterpret_cast<char *>(data.data())),
+              0);
+    ASSERT_EQ(data, zeros);
+    std::vector<uint32_t> data2(values.size());
+    ASSERT_EQ(
+        reader.read_file("values", reinterpret_cast<char *>(data2.data())), 0);
+    ASSERT_EQ(data2, values);
+
+    // 映射时解压后的条目同样按64字节对齐，可直接使用
+    if (map_file) {
+      ASSERT_NE(reader.get_mapped_file(), nullptr);
+      for (const std::string name : {"zeros", "values"}) {
+        const char *entry_data = reader.get_file_data(name);
+        ASSERT_NE(entry_data, nullptr);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(entry_data) % 64, 0);
+      }
+      ASSERT_EQ(std::memcmp(reader.get_file_data("values"), values.data(),
+                            values.size() * sizeof(uint32_t)),
+                0);
+    } else {
+      ASSERT_EQ(reader.get_mapped_file(), nullptr);
+    }
+  }
+
+  // 压缩的数据损坏时打开失败
+  {
+    std::fstream file(zip_path,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(30 + std::string("zeros").size() + 4);
+    file.put(char(0x5a));
+  }
+  pnnx::StoreZipReader reader;
+  ASSERT_NE(reader.open(zip_path, true), 0);
+  std::remove(zip_path.c_str());
+}
+
+TEST(test_param_parser, compressed_weights) {
+  // 权重压缩存放的模型与不压缩的模型解析结果相同
+  ThreadPool pool(4);
+  const std::vector<std::string> models{"../../tmp/add/resnet_add3",
+                                        "../../tmp/fusion/conv_fusion"};
+  const std::string param_path = "./compressed_weights.pnnx.param";
+  const std::string bin_path = "./compressed_weights.pnnx.bin";
+  for (const std::string &model : models) {
+    pnnx::Graph graph;
+    ASSERT_EQ(graph.load(model + ".pnnx.param", model + ".pnnx.bin"), 0);
+    ASSERT_EQ(graph.save(param_path, bin_path, 6), 0);
+
+    std::vector<srunop> ops1;
+    std::vector<srunop> ops2;
+    std::shared_ptr<MappedFile> weight_file1;
+    std::shared_ptr<MappedFile> weight_file2;
+    ASSERT_TRUE(ParamParser::Parse(model + ".pnnx.param", model + ".pnnx.bin",
+                                   ops1, weight_file1));
+    ASSERT_TRUE(
+        ParamParser::Parse(param_path, bin_path, ops2, weight_file2, &pool));
+    ASSERT_EQ(ops1.size(), ops2.size());
+    ASSERT_NE(weight_file2, nullptr);
+    for (uint32_t i = 0; i < ops1.size(); ++i) {
+      ASSERT_EQ(ops1.at(i)->attrs.size(), ops2.at(i)->attrs.size());
+      for (const auto &[name, attr] : ops1.at(i)->attrs) {
+        const srunattr &attr2 = ops2.at(i)->attrs.at(name);
+        ASSERT_EQ(attr->shape, attr2->shape);
+        ASSERT_EQ(attr->mapped_size, attr2->mapped_size);
+        ASSERT_EQ(std::memcmp(attr->mapped_data, attr2->mapped_data,
+                              attr->mapped_size),
+                  0);
+      }
+    }
+
+    // pnnx::Graph读取时同样解压，映射与否结果相同
+    for (const bool map_weights : {false, true}) {
+      pnnx::Graph graph2;
+      ASSERT_EQ(graph2.load(param_path, bin_path, map_weights, 2), 0);
+      ASSERT_EQ(graph2.ops.size(), graph.ops.size());
+      for (uint32_t i = 0; i < graph.ops.size(); ++i) {
+        for (const auto &[name, attr] : graph.ops.at(i)->attrs) {
+          const pnnx::Attribute &attr2 = graph2.ops.at(i)->attrs.at(name);
+          const char *data2 =
+              map_weights ? attr2.mapped_data : attr2.data.data();
+          ASSERT_NE(data2, nullptr);
+          ASSERT_EQ(std::memcmp(attr.data.data(), data2, attr.data.size()), 0);
+        }
+      }
+    }
+  }
+  std::remove(param_path.c_str());
+  std::remove(bin_path.c_str());
+}
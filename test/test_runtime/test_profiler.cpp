@@ -0,0 +1,81 @@
+#include "runtime/profiler.hpp"
+#include "runtime/runtime_graph.hpp"
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace TinyInfer;
+
+TEST(test_profiler, record_nodes) {
+  RuntimeGraph graph("../../tmp/group_conv/group_conv.pnnx.param",
+                     "../../tmp/group_conv/group_conv.pnnx.bin");
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < 2; ++b) {
+    sftensor input = std::make_shared<ftensor>(4, 16, 16);
+    input->Rand();
+    inputs.push_back(input);
+  }
+  graph.Forward(inputs, true);
+
+  // conv3和hardswish融合为一个节点
+  const auto &records = graph.profiler().records();
+  ASSERT_EQ(records.size(), 4);
+  ASSERT_EQ(records.at(0).name, "conv1");
+  ASSERT_EQ(records.at(3).name, "conv3");
+  ASSERT_EQ(records.at(3).fused_ops, std::vector<std::string>{"hardswish"});
+
+  for (const auto &record : records) {
+    ASSERT_LE(record.start_us, record.end_us);
+    ASSERT_LE(record.end_us, graph.profiler().total_us());
+    ASSERT_EQ(record.batch, 2);
+    ASSERT_EQ(record.thread_id, 0);
+    ASSERT_GT(record.bytes, 0);
+  }
+
+  // conv1：输入(4,16,16)，32个(2,3,3)的卷积核，输出(32,16,16)
+  const ProfileRecord &conv1 = records.at(0);
+  ASSERT_EQ(conv1.input_shapes.size(), 1);
+  ASSERT_EQ(conv1.input_shapes.front(), std::vector<uint32_t>({4, 16, 16}));
+  ASSERT_EQ(conv1.output_shape, std::vector<uint32_t>({32, 16, 16}));
+  ASSERT_EQ(conv1.flops, 2ull * 32 * 16 * 16 * (2 * 2 * 3 * 3 + 1));
+  ASSERT_EQ(conv1.bytes, 2ull * (4 + 32) * 16 * 16 * sizeof(float) +
+                             (32 * 2 * 3 * 3 + 32) * sizeof(float));
+}
+
+TEST(test_profiler, export_trace_and_table) {
+  RuntimeGraph graph("../../tmp/add/resnet_add3.pnnx.param",
+                     "../../tmp/add/resnet_add3.pnnx.bin");
+  graph.set_max_concurrent_ops(2);
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  const auto &context = graph.CreateContext();
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < 4; ++b) {
+    sftensor input = std::make_shared<ftensor>(1, 4, 4);
+    input->Rand();
+    inputs.push_back(input);
+  }
+  graph.Forward(*context, inputs, true);
+
+  const Profiler &profiler = context->profiler();
+  ASSERT_EQ(profiler.records().size(), 6);
+
+  const std::string trace_path = "./profile_trace.json";
+  ASSERT_TRUE(profiler.ExportChromeTrace(trace_path));
+  std::ifstream trace_file(trace_path);
+  std::stringstream trace;
+  trace << trace_file.rdbuf();
+  const std::string &trace_str = trace.str();
+  ASSERT_NE(trace_str.find("\"traceEvents\""), std::string::npos);
+  for (const auto &record : profiler.records()) {
+    ASSERT_NE(trace_str.find("\"name\":\"" + record.name + "\""),
+              std::string::npos);
+  }
+  std::remove(trace_path.c_str());
+
+  // 表头、3个节点和总计
+  const std::string &table = profiler.TopTable(3);
+  ASSERT_EQ(std::count(table.begin(), table.end(), '\n'), 5);
+}
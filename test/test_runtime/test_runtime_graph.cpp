@@ -1,5 +1,7 @@
 #include "runtime/runtime_graph.hpp"
+#include "runtime/weight_store.hpp"
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace TinyInfer;
 
@@ -301,4 +303,520 @@ TEST(test_runtime, set_bin_path) {
   ASSERT_EQ(graph.bin_path(), "yy.bin");
   graph.set_bin_path("yy.bin");
   ASSERT_EQ(graph.bin_path(), "yy.bin");
-}
\ No newline at end of file
+}
+
+TEST(test_runtime, forward_exec_plan_repeat) {
+  RuntimeGraph graph("../../tmp/add/resnet_add.pnnx.param",
+                     "../../tmp/add/resnet_add.pnnx.bin");
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  const uint32_t batch = 4;
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < batch; ++b) {
+    sftensor input = std::make_shared<ftensor>(1, 4, 4);
+    input->Fill(1.f);
+    inputs.push_back(input);
+  }
+
+  // 执行计划在多次Forward之间复用，结果应保持一致
+  const std::vector<float> first = graph.Forward(inputs, false).at(0)->values();
+  for (uint32_t i = 0; i < 3; ++i) {
+    const auto &outputs = graph.Forward(inputs, false);
+    ASSERT_EQ(outputs.size(), batch);
+    for (uint32_t b = 0; b < batch; ++b) {
+      ASSERT_EQ(outputs.at(b)->values(), first);
+    }
+  }
+}
+
+TEST(test_runtime, forward_concurrent_ops) {
+  // resnet_add3中conv1和conv2相互独立，可以并发执行
+  RuntimeGraph graph1("../../tmp/add/resnet_add3.pnnx.param",
+                      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph1.Build("pnnx_input_0", "pnnx_output_0");
+
+  RuntimeGraph graph2("../../tmp/add/resnet_add3.pnnx.param",
+                      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph2.set_max_concurrent_ops(4);
+  graph2.Build("pnnx_input_0", "pnnx_output_0");
+  ASSERT_EQ(graph2.max_concurrent_ops(), 4);
+
+  const uint32_t batch = 4;
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < batch; ++b) {
+    sftensor input = std::make_shared<ftensor>(1, 4, 4);
+    input->Rand();
+    inputs.push_back(input);
+  }
+
+  for (uint32_t i = 0; i < 5; ++i) {
+    const auto &outputs1 = graph1.Forward(inputs, false);
+    const auto &outputs2 = graph2.Forward(inputs, false);
+    ASSERT_EQ(outputs1.size(), outputs2.size());
+    for (uint32_t b = 0; b < batch; ++b) {
+      ASSERT_TRUE(arma::approx_equal(outputs1.at(b)->data(),
+                                     outputs2.at(b)->data(), "absdiff", 1e-5));
+    }
+  }
+
+  // 构建完毕后切换回依次执行
+  graph2.set_max_concurrent_ops(1);
+  const auto &outputs1 = graph1.Forward(inputs, false);
+  const auto &outputs2 = graph2.Forward(inputs, false);
+  for (uint32_t b = 0; b < batch; ++b) {
+    ASSERT_TRUE(arma::approx_equal(outputs1.at(b)->data(),
+                                   outputs2.at(b)->data(), "absdiff", 1e-5));
+  }
+}
+
+TEST(test_runtime, forward_concurrent_short_lived_contexts) {
+  // 每次推理都使用新建的执行上下文，推理结束后立即析构，
+  // 工作线程在通知完成之后不能再访问已经析构的上下文
+  RuntimeGraph graph("../../tmp/add/resnet_add3.pnnx.param",
+                     "../../tmp/add/resnet_add3.pnnx.bin");
+  graph.set_max_concurrent_ops(4);
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  const uint32_t batch = 2;
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < batch; ++b) {
+    sftensor input = std::make_shared<ftensor>(1, 4, 4);
+    input->Rand();
+    inputs.push_back(input);
+  }
+  std::vector<std::vector<float>> expected;
+  for (const auto &output : graph.Forward(inputs, false)) {
+    expected.push_back(output->values());
+  }
+
+  for (uint32_t i = 0; i < 500; ++i) {
+    const auto &context = graph.CreateContext();
+    const auto &outputs = graph.Forward(*context, inputs);
+    ASSERT_EQ(outputs.size(), batch);
+    for (uint32_t b = 0; b < batch; ++b) {
+      ASSERT_EQ(outputs.at(b)->values(), expected.at(b));
+    }
+  }
+}
+
+TEST(test_runtime, build_threads) {
+  // 多线程解析、构造Kernel的结果与单线程相同
+  RuntimeGraph graph1("../../tmp/add/resnet_add3.pnnx.param",
+                      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph1.set_build_threads(1);
+  graph1.Build("pnnx_input_0", "pnnx_output_0");
+  ASSERT_EQ(graph1.startup_timings().threads, 1);
+
+  RuntimeGraph graph2("../../tmp/add/resnet_add3.pnnx.param",
+                      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph2.set_build_threads(4);
+  ASSERT_EQ(graph2.build_threads(), 4);
+  graph2.Build("pnnx_input_0", "pnnx_output_0");
+
+  const StartupTimings &timings = graph2.startup_timings();
+  ASSERT_EQ(timings.threads, 4);
+  ASSERT_GT(timings.init_ms, 0.);
+  ASSERT_GT(timings.kernel_ms, 0.);
+  ASSERT_GE(timings.link_ms, 0.);
+  ASSERT_GE(timings.plan_ms, 0.);
+
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < 4; ++b) {
+    sftensor input = std::make_shared<ftensor>(1, 4, 4);
+    input->Rand();
+    inputs.push_back(input);
+  }
+  const auto &outputs1 = graph1.Forward(inputs, false);
+  const auto &outputs2 = graph2.Forward(inputs, false);
+  ASSERT_EQ(outputs1.size(), outputs2.size());
+  for (uint32_t b = 0; b < outputs1.size(); ++b) {
+    ASSERT_TRUE(arma::approx_equal(outputs1.at(b)->data(),
+                                   outputs2.at(b)->data(), "absdiff", 1e-5));
+  }
+}
+
+TEST(test_runtime, share_weights) {
+  // 由相同权重构建的计算图共享一份权重
+  WeightStore &store = WeightStore::Instance();
+  const size_t blob_count = store.blob_count();
+  RuntimeGraph graph("../../tmp/add/resnet_add3.pnnx.param",
+                     "../../tmp/add/resnet_add3.pnnx.bin");
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+  ASSERT_EQ(store.blob_count(), blob_count);
+
+  auto graph1 = std::make_unique<RuntimeGraph>(
+      "../../tmp/add/resnet_add3.pnnx.param",
+      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph1->set_share_weights(true);
+  graph1->Build("pnnx_input_0", "pnnx_output_0");
+  ASSERT_TRUE(graph1->share_weights());
+  const size_t shared_count = store.blob_count();
+  const size_t shared_bytes = store.blob_bytes();
+  ASSERT_GT(shared_count, blob_count);
+
+  auto graph2 = std::make_unique<RuntimeGraph>(
+      "../../tmp/add/resnet_add3.pnnx.param",
+      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph2->set_share_weights(true);
+  graph2->Build("pnnx_input_0", "pnnx_output_0");
+  ASSERT_EQ(store.blob_count(), shared_count);
+  ASSERT_EQ(store.blob_bytes(), shared_bytes);
+
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < 2; ++b) {
+    sftensor input = std::make_shared<ftensor>(1, 4, 4);
+    input->Rand();
+    inputs.push_back(input);
+  }
+  const auto &outputs = graph.Forward(inputs, false);
+  const auto &outputs1 = graph1->Forward(inputs, false);
+  const auto &outputs2 = graph2->Forward(inputs, false);
+  for (uint32_t b = 0; b < outputs.size(); ++b) {
+    ASSERT_TRUE(arma::approx_equal(outputs.at(b)->data(),
+                                   outputs1.at(b)->data(), "absdiff", 1e-5));
+    ASSERT_TRUE(arma::approx_equal(outputs.at(b)->data(),
+                                   outputs2.at(b)->data(), "absdiff", 1e-5));
+  }
+
+  // 所有计算图释放后，共享的权重随之释放
+  graph1.reset();
+  ASSERT_EQ(store.blob_count(), shared_count);
+  graph2.reset();
+  ASSERT_EQ(store.blob_count(), blob_count);
+}
+
+TEST(test_runtime, forward_execution_contexts) {
+  // 多个线程共享同一个计算图，各自使用自己的执行上下文推理
+  RuntimeGraph graph("../../tmp/add/resnet_add3.pnnx.param",
+                     "../../tmp/add/resnet_add3.pnnx.bin");
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  const uint32_t batch = 4;
+  const uint32_t thread_num = 4;
+  std::vector<std::vector<sftensor>> thread_inputs(thread_num);
+  std::vector<std::vector<std::vector<float>>> expected(thread_num);
+  for (uint32_t t = 0; t < thread_num; ++t) {
+    for (uint32_t b = 0; b < batch; ++b) {
+      sftensor input = std::make_shared<ftensor>(1, 4, 4);
+      input->Rand();
+      thread_inputs.at(t).push_back(input);
+    }
+    for (const auto &output : graph.Forward(thread_inputs.at(t), false)) {
+      expected.at(t).push_back(output->values());
+    }
+  }
+
+  std::vector<uint32_t> mismatches(thread_num, 0);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t]() {
+      const auto &context = graph.CreateContext();
+      ASSERT_EQ(context->graph(), &graph);
+      for (uint32_t i = 0; i < 20; ++i) {
+        const auto &outputs = graph.Forward(*context, thread_inputs.at(t));
+        for (uint32_t b = 0; b < batch; ++b) {
+          if (outputs.at(b)->values() != expected.at(t).at(b)) {
+            mismatches.at(t) += 1;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (uint32_t t = 0; t < thread_num; ++t) {
+    ASSERT_EQ(mismatches.at(t), 0);
+  }
+}
+
+TEST(test_runtime, forward_dynamic_batch) {
+  // 同一个计算图接受任意批次的输入，结果与固定批次的计算图一致
+  RuntimeGraph graph1("../../tmp/add/resnet_add3.pnnx.param",
+                      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph1.Build("pnnx_input_0", "pnnx_output_0");
+
+  RuntimeGraph graph2("../../tmp/add/resnet_add3_dynamic.pnnx.param",
+                      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph2.Build("pnnx_input_0", "pnnx_output_0");
+
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < 4; ++b) {
+    sftensor input = std::make_shared<ftensor>(1, 4, 4);
+    input->Rand();
+    inputs.push_back(input);
+  }
+  // 输出Tensor在下一次Forward时会被覆盖，先拷贝一份
+  std::vector<sftensor> expected;
+  for (const auto &output : graph1.Forward(inputs, false)) {
+    expected.push_back(output->Clone());
+  }
+
+  const auto &context = graph2.CreateContext();
+  for (const uint32_t batch : {1u, 4u, 9u, 2u}) {
+    std::vector<sftensor> batch_inputs;
+    for (uint32_t b = 0; b < batch; ++b) {
+      batch_inputs.push_back(inputs.at(b % inputs.size()));
+    }
+
+    // 静态批次的计算图同样可以接受其他批次
+    for (const auto &outputs : {graph2.Forward(*context, batch_inputs),
+                                graph1.Forward(batch_inputs, false)}) {
+      ASSERT_EQ(outputs.size(), batch);
+      for (uint32_t b = 0; b < batch; ++b) {
+        ASSERT_TRUE(arma::approx_equal(outputs.at(b)->data(),
+                                       expected.at(b % inputs.size())->data(),
+                                       "absdiff", 1e-5));
+      }
+    }
+    ASSERT_EQ(context->batch(), batch);
+  }
+  ASSERT_EQ(graph2.planned_activation_bytes(4),
+            graph2.planned_activation_bytes() * 4);
+}
+
+TEST(test_runtime, forward_variable_input_shape) {
+  // 输入维度与结构文件中声明的不同时，按推断出的维度计算，结果与按该维度导出的计算图一致
+  RuntimeGraph graph1("../../tmp/group_conv/group_conv.pnnx.param",
+                      "../../tmp/group_conv/group_conv.pnnx.bin");
+  graph1.Build("pnnx_input_0", "pnnx_output_0");
+
+  RuntimeGraph graph2("../../tmp/group_conv/group_conv_20x24.pnnx.param",
+                      "../../tmp/group_conv/group_conv.pnnx.bin");
+  graph2.Build("pnnx_input_0", "pnnx_output_0");
+
+  std::vector<sftensor> inputs1{std::make_shared<ftensor>(4, 16, 16)};
+  std::vector<sftensor> inputs2{std::make_shared<ftensor>(4, 20, 24),
+                                std::make_shared<ftensor>(4, 20, 24)};
+  inputs1.front()->Rand();
+  for (const auto &input : inputs2) {
+    input->Rand();
+  }
+
+  std::vector<sftensor> expected1;
+  for (const auto &output : graph1.Forward(inputs1, false)) {
+    expected1.push_back(output->Clone());
+  }
+  std::vector<sftensor> expected2;
+  for (const auto &output : graph2.Forward(inputs2, false)) {
+    expected2.push_back(output->Clone());
+  }
+  ASSERT_EQ(expected2.front()->shape(), std::vector<uint32_t>({64, 20, 24}));
+
+  // 在同一个上下文中交替使用不同的输入维度
+  const auto &context = graph1.CreateContext();
+  for (uint32_t i = 0; i < 3; ++i) {
+    const auto &outputs1 = graph1.Forward(*context, inputs1);
+    ASSERT_EQ(outputs1.size(), 1);
+    ASSERT_TRUE(arma::approx_equal(outputs1.front()->data(),
+                                   expected1.front()->data(), "absdiff",
+                                   1e-4));
+
+    const auto &outputs2 = graph1.Forward(*context, inputs2);
+    ASSERT_EQ(outputs2.size(), 2);
+    for (uint32_t b = 0; b < 2; ++b) {
+      ASSERT_TRUE(arma::approx_equal(outputs2.at(b)->data(),
+                                     expected2.at(b)->data(), "absdiff",
+                                     1e-4));
+    }
+  }
+  // 推断和规划的结果按输入维度缓存
+  ASSERT_EQ(graph1.cached_layout_count(), 1);
+}
+
+TEST(test_runtime, forward_variable_input_shape_expression) {
+  RuntimeGraph graph1("../../tmp/add/resnet_add3.pnnx.param",
+                      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph1.Build("pnnx_input_0", "pnnx_output_0");
+
+  RuntimeGraph graph2("../../tmp/add/resnet_add3_7x5.pnnx.param",
+                      "../../tmp/add/resnet_add3.pnnx.bin");
+  graph2.Build("pnnx_input_0", "pnnx_output_0");
+
+  std::vector<sftensor> inputs;
+  for (uint32_t b = 0; b < 4; ++b) {
+    sftensor input = std::make_shared<ftensor>(1, 7, 5);
+    input->Rand();
+    inputs.push_back(input);
+  }
+
+  std::vector<sftensor> expected;
+  for (const auto &output : graph2.Forward(inputs, false)) {
+    expected.push_back(output->Clone());
+  }
+  const auto &outputs = graph1.Forward(inputs, false);
+  ASSERT_EQ(outputs.size(), 4);
+  for (uint32_t b = 0; b < 4; ++b) {
+    ASSERT_EQ(outputs.at(b)->shape(), std::vector<uint32_t>({1, 7, 5}));
+    ASSERT_TRUE(arma::approx_equal(outputs.at(b)->data(),
+                                   expected.at(b)->data(), "absdiff", 1e-5));
+  }
+}
+
+TEST(test_runtime, layout_cache_lru) {
+  // 缓存的布局超出上限（16个）时移除最久未使用的，而不是维度最小的
+  RuntimeGraph graph("../../tmp/add/resnet_add3.pnnx.param",
+                     "../../tmp/add/resnet_add3.pnnx.bin");
+  graph.Build("pnnx_input_0", "pnnx_output_0");
+
+  const auto forward = [&graph](uint32_t rows) {
+    std::vector<sftensor> inputs{std::make_shared<ftensor>(1, rows, 5)};
+    inputs.front()->Rand();
+    graph.Forward(inputs, false);
+  };
+  const auto cached = [&graph](uint32_t rows) {
+    return graph.has_cached_layout({{1, rows, 5}});
+  };
+
+  for (uint32_t rows = 5; rows < 21; ++rows) {
+    forward(rows);
+  }
+  ASSERT_EQ(graph.cached_layout_count(), 16);
+
+  // 再次使用维度最小的布局，之后加入新的布局时移除的是最久未使用的6x5
+  forward(5);
+  forward(21);
+  ASSERT_EQ(graph.cached_layout_count(), 16);
+  ASSERT_TRUE(cached(5));
+  ASSERT_FALSE(cached(6));
+  ASSERT_TRUE(cached(7));
+  ASSERT_TRUE(cached(21));
+}
+
+TEST(test_runtime, forward_multiple_inputs_outputs) {
+  // 两个输入、三个输出：relu(conv1(input0) + input1)、其2x2池化结果、conv2(input1)
+  const std::vector<std::string> input_names{"pnnx_input_0", "pnnx_input_1"};
+  const std::vector<std::string> output_names{"pnnx_output_0", "pnnx_output_1",
+                                              "pnnx_output_2"};
+  RuntimeGraph graph("../../tmp/multi_io/multi_io.pnnx.param",
+                     "../../tmp/multi_io/multi_io.pnnx.bin");
+  graph.Build(input_names, output_names);
+  ASSERT_EQ(graph.input_names(), input_names);
+  ASSERT_EQ(graph.output_names(), output_names);
+
+  RuntimeGraph unfused_graph("../../tmp/multi_io/multi_io.pnnx.param",
+                             "../../tmp/multi_io/multi_io.pnnx.bin");
+  unfused_graph.set_fuse_ops(false);
+  unfused_graph.set_max_concurrent_ops(3);
+  unfused_graph.Build(input_names, output_names);
+
+  // 只构建一个输出头的计算图
+  RuntimeGraph head_graph("../../tmp/multi_io/multi_io.pnnx.param",
+                          "../../tmp/multi_io/multi_io.pnnx.bin");
+  head_graph.Build("pnnx_input_1", "pnnx_output_2");
+
+  for (const uint32_t rows : {8, 12}) {
+    std::map<std::string, std::vector<sftensor>> inputs;
+    for (const auto &input_name : input_names) {
+      for (uint32_t b = 0; b < 3; ++b) {
+        sftensor input = std::make_shared<ftensor>(4, rows, 10);
+        input->Rand();
+        inputs[input_name].push_back(input);
+      }
+    }
+
+    const auto &outputs = graph.Forward(inputs, false);
+    ASSERT_EQ(outputs.size(), 3);
+    const auto &context = unfused_graph.CreateContext();
+    const auto &expected = unfused_graph.Forward(*context, inputs, false);
+    const auto &head_outputs =
+        head_graph.Forward(inputs.at("pnnx_input_1"), false);
+
+    for (const auto &output_name : output_names) {
+      ASSERT_EQ(outputs.at(output_name).size(), 3);
+      for (uint32_t b = 0; b < 3; ++b) {
+        ASSERT_TRUE(arma::approx_equal(outputs.at(output_name).at(b)->data(),
+                                       expected.at(output_name).at(b)->data(),
+                                       "absdiff", 1e-5));
+      }
+    }
+
+    for (uint32_t b = 0; b < 3; ++b) {
+      const sftensor &relu = outputs.at("pnnx_output_0").at(b);
+      const sftensor &pool = outputs.at("pnnx_output_1").at(b);
+      const sftensor &conv2 = outputs.at("pnnx_output_2").at(b);
+      ASSERT_EQ(relu->shape(), std::vector<uint32_t>({4, rows, 10}));
+      ASSERT_EQ(pool->shape(), std::vector<uint32_t>({4, rows / 2, 5}));
+      ASSERT_EQ(conv2->shape(), std::vector<uint32_t>({8, rows, 10}));
+      ASSERT_TRUE(arma::approx_equal(conv2->data(),
+                                     head_outputs.at(b)->data(), "absdiff",
+                                     1e-5));
+
+      for (uint32_t c = 0; c < pool->channels(); ++c) {
+        for (uint32_t r = 0; r < pool->rows(); ++r) {
+          for (uint32_t w = 0; w < pool->cols(); ++w) {
+            const float max_value =
+                std::max(std::max(relu->at(c, r * 2, w * 2),
+                                  relu->at(c, r * 2, w * 2 + 1)),
+                         std::max(relu->at(c, r * 2 + 1, w * 2),
+                                  relu->at(c, r * 2 + 1, w * 2 + 1)));
+            ASSERT_EQ(pool->at(c, r, w), max_value);
+            ASSERT_GE(relu->at(c, r * 2, w * 2), 0.f);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(test_runtime, forward_intermediate_outputs) {
+  RuntimeGraph graph("../../tmp/multi_io/multi_io.pnnx.param",
+                     "../../tmp/multi_io/multi_io.pnnx.bin");
+  const std::vector<std::string> input_names{"pnnx_input_0", "pnnx_input_1"};
+  graph.Build(input_names, std::vector<std::string>{
+                               "pnnx_output_0", "pnnx_output_1", "pnnx_output_2"});
+
+  // relu作为末节点融合进conv1，只需执行conv1
+  RuntimeGraph relu_graph("../../tmp/multi_io/multi_io.pnnx.param",
+                          "../../tmp/multi_io/multi_io.pnnx.bin");
+  relu_graph.Build(input_names, std::vector<std::string>{"relu"});
+
+  // conv1的输出须保留，不再与其后的节点融合；只依赖第一个输入
+  RuntimeGraph conv_graph("../../tmp/multi_io/multi_io.pnnx.param",
+                          "../../tmp/multi_io/multi_io.pnnx.bin");
+  conv_graph.Build("pnnx_input_0", "conv1");
+
+  std::map<std::string, std::vector<sftensor>> inputs;
+  for (const std::string &input_name : input_names) {
+    for (uint32_t b = 0; b < 2; ++b) {
+      sftensor input = std::make_shared<ftensor>(4, 8, 8);
+      input->Rand();
+      inputs[input_name].push_back(input);
+    }
+  }
+  const auto &expected = graph.Forward(inputs, false);
+
+  // 不再开辟被跳过节点的输出
+  const auto &context = graph.CreateContext();
+  const auto &relu_context = relu_graph.CreateContext();
+  graph.Forward(*context, inputs);
+  relu_graph.Forward(*relu_context, inputs);
+  ASSERT_LT(relu_context->activation_bytes(), context->activation_bytes());
+
+  const auto &relu_outputs = relu_graph.Forward(inputs, true);
+  ASSERT_EQ(relu_graph.profiler().records().size(), 1);
+  ASSERT_EQ(relu_graph.profiler().records().front().name, "conv1");
+
+  const auto &conv_outputs =
+      conv_graph.Forward(inputs.at("pnnx_input_0"), true);
+  ASSERT_EQ(conv_graph.profiler().records().size(), 1);
+
+  for (uint32_t b = 0; b < 2; ++b) {
+    const auto &relu = relu_outputs.at("relu").at(b);
+    ASSERT_TRUE(arma::approx_equal(relu->data(),
+                                   expected.at("pnnx_output_0").at(b)->data(),
+                                   "absdiff", 1e-5));
+    // relu(conv1(input0) + input1)
+    const auto &conv1 = conv_outputs.at(b);
+    const auto &input1 = inputs.at("pnnx_input_1").at(b);
+    ASSERT_EQ(conv1->shape(), std::vector<uint32_t>({4, 8, 8}));
+    for (uint32_t c = 0; c < conv1->channels(); ++c) {
+      for (uint32_t r = 0; r < conv1->rows(); ++r) {
+        for (uint32_t w = 0; w < conv1->cols(); ++w) {
+          const float sum = conv1->at(c, r, w) + input1->at(c, r, w);
+          ASSERT_NEAR(relu->at(c, r, w), std::max(sum, 0.f), 1e-5);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,152 @@
+#include "runtime/runtime_graph.hpp"
+#include "runtime/shared_weight_segment.hpp"
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace TinyInfer;
+
+namespace {
+std::string SegmentName(const std::string &name) {
+  return "/tinyinfer_" + name + "_" + std::to_string(getpid());
+}
+} // namespace
+
+TEST(test_shared_weight_segment, create_attach) {
+  const std::string name = SegmentName("create_attach");
+  SharedWeightSegment::Remove(name);
+
+  SharedWeightSegment::ModelKey key;
+  key.hash[0] = 1;
+  key.hash[1] = 2;
+  sftensor weight = std::make_shared<ftensor>(2, 3, 3);
+  weight->Rand();
+  sftensor bias = std::make_shared<ftensor>(1, 1, 5);
+  bias->Fill(0.5f);
+
+  bool exists = true;
+  ASSERT_EQ(SharedWeightSegment::Attach(name, key, 0, exists), nullptr);
+  ASSERT_FALSE(exists);
+
+  const auto segment = SharedWeightSegment::Create(
+      name, key, {{"conv.weight", {weight, weight}}, {"conv.bias", {bias}}});
+  ASSERT_NE(segment, nullptr);
+  // 段已存在时不能重复创建
+  ASSERT_EQ(SharedWeightSegment::Create(name, key, {}), nullptr);
+
+  const auto attached = SharedWeightSegment::Attach(name, key, 0, exists);
+  ASSERT_TRUE(exists);
+  ASSERT_NE(attached, nullptr);
+  const float *weight_data = attached->Find("conv.weight", 36);
+  ASSERT_NE(weight_data, nullptr);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(weight_data) %
+                SharedWeightSegment::kAlignment,
+            0);
+  for (uint32_t i = 0; i < 18; ++i) {
+    ASSERT_EQ(weight_data[i], weight->index(i));
+    ASSERT_EQ(weight_data[18 + i], weight->index(i));
+  }
+  ASSERT_EQ(attached->Find("conv.bias", 5)[4], 0.5f);
+  ASSERT_EQ(attached->Find("conv.bias", 4), nullptr);
+  ASSERT_EQ(attached->Find("conv.other", 5), nullptr);
+
+  // 其他模型的段不能使用
+  SharedWeightSegment::ModelKey other_key;
+  ASSERT_EQ(SharedWeightSegment::Attach(name, other_key, 0, exists), nullptr);
+  ASSERT_TRUE(exists);
+
+  // 其他进程映射同一段
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    bool child_exists = false;
+    const auto child_segment =
+        SharedWeightSegment::Attach(name, key, 1000, child_exists);
+    const bool ok = child_segment != nullptr &&
+                    child_segment->Find("conv.bias", 5) != nullptr &&
+                    child_segment->Find("conv.bias", 5)[0] == 0.5f;
+    _exit(ok ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+
+  ASSERT_TRUE(SharedWeightSegment::Remove(name));
+  ASSERT_EQ(SharedWeightSegment::Attach(name, key, 0, exists), nullptr);
+  ASSERT_FALSE(exists);
+}
+
+TEST(test_shared_weight_segment, stale_segment) {
+  const std::string name = SegmentName("stale_segment");
+  SharedWeightSegment::Remove(name);
+
+  // 模拟创建的进程在写入完毕之前退出：段已存在，但始终未置位
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(ftruncate(fd, 4096), 0);
+  close(fd);
+
+  SharedWeightSegment::ModelKey key;
+  key.hash[0] = 3;
+  key.hash[1] = 4;
+  bool exists = true;
+  ASSERT_EQ(SharedWeightSegment::Attach(name, key, 10, exists), nullptr);
+  ASSERT_FALSE(exists);
+
+  // 超时的段已被删除，可以重新创建
+  sftensor weight = std::make_shared<ftensor>(1, 2, 2);
+  weight->Fill(1.f);
+  ASSERT_NE(SharedWeightSegment::Create(name, key, {{"conv.weight", {weight}}}),
+            nullptr);
+  const auto attached = SharedWeightSegment::Attach(name, key, 0, exists);
+  ASSERT_TRUE(exists);
+  ASSERT_NE(attached, nullptr);
+  ASSERT_EQ(attached->Find("conv.weight", 4)[3], 1.f);
+  ASSERT_TRUE(SharedWeightSegment::Remove(name));
+}
+
+TEST(test_shared_weight_segment, graph_weight_segment) {
+  const std::string param_path = "../../tmp/add/resnet_add3.pnnx.param";
+  const std::string bin_path = "../../tmp/add/resnet_add3.pnnx.bin";
+  // 共享内存和文件两种形式
+  const std::vector<std::string> names{SegmentName("graph"),
+                                       "./graph_weight_segment.weights"};
+  for (const std::string &name : names) {
+    SharedWeightSegment::Remove(name);
+
+    RuntimeGraph graph(param_path, bin_path);
+    graph.Build("pnnx_input_0", "pnnx_output_0");
+
+    // 第一个计算图创建权重段，第二个直接映射
+    RuntimeGraph graph1(param_path, bin_path);
+    graph1.set_weight_segment(name);
+    graph1.Build("pnnx_input_0", "pnnx_output_0");
+    ASSERT_EQ(graph1.weight_segment(), name);
+    ASSERT_FALSE(graph1.weight_segment_attached());
+
+    RuntimeGraph graph2(param_path, bin_path);
+    graph2.set_weight_segment(name);
+    graph2.Build("pnnx_input_0", "pnnx_output_0");
+    ASSERT_TRUE(graph2.weight_segment_attached());
+
+    std::vector<sftensor> inputs;
+    for (uint32_t b = 0; b < 2; ++b) {
+      sftensor input = std::make_shared<ftensor>(1, 4, 4);
+      input->Rand();
+      inputs.push_back(input);
+    }
+    const auto &outputs = graph.Forward(inputs, false);
+    const auto &outputs1 = graph1.Forward(inputs, false);
+    const auto &outputs2 = graph2.Forward(inputs, false);
+    for (uint32_t b = 0; b < outputs.size(); ++b) {
+      ASSERT_TRUE(arma::approx_equal(outputs.at(b)->data(),
+                                     outputs1.at(b)->data(), "absdiff", 1e-5));
+      ASSERT_TRUE(arma::approx_equal(outputs.at(b)->data(),
+                                     outputs2.at(b)->data(), "absdiff", 1e-5));
+    }
+    ASSERT_TRUE(SharedWeightSegment::Remove(name));
+  }
+}
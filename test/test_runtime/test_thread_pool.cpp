@@ -0,0 +1,57 @@
+#include "runtime/thread_pool.hpp"
+#include <atomic>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace TinyInfer;
+
+TEST(test_thread_pool, submit_and_wait) {
+  ThreadPool pool(4);
+  ASSERT_EQ(pool.thread_num(), 4);
+
+  std::atomic<uint32_t> count{0};
+  for (uint32_t i = 0; i < 1000; ++i) {
+    pool.Submit([&count]() { count.fetch_add(1); });
+  }
+  pool.Wait();
+  ASSERT_EQ(count.load(), 1000);
+}
+
+TEST(test_thread_pool, submit_from_worker) {
+  // 工作线程中提交的任务同样会被执行，Wait会等待它们完成
+  ThreadPool pool(3);
+  std::atomic<uint32_t> count{0};
+  for (uint32_t i = 0; i < 100; ++i) {
+    pool.Submit([&pool, &count]() {
+      for (uint32_t j = 0; j < 10; ++j) {
+        pool.Submit([&count]() { count.fetch_add(1); });
+      }
+      count.fetch_add(1);
+    });
+  }
+  pool.Wait();
+  ASSERT_EQ(count.load(), 1100);
+}
+
+TEST(test_thread_pool, parallel_for) {
+  // 每个元素恰好被处理一次
+  ThreadPool pool(4);
+  std::vector<std::atomic<uint32_t>> visits(1000);
+  ParallelFor(&pool, visits.size(), [&visits](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      visits.at(i).fetch_add(1);
+    }
+  });
+  for (const auto &visit : visits) {
+    ASSERT_EQ(visit.load(), 1);
+  }
+
+  // 没有线程池时在当前线程中处理
+  size_t sum = 0;
+  ParallelFor(nullptr, 10, [&sum](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      sum += i;
+    }
+  });
+  ASSERT_EQ(sum, 45);
+}
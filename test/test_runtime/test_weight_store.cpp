@@ -0,0 +1,52 @@
+#include "runtime/weight_store.hpp"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <numeric>
+
+using namespace TinyInfer;
+
+TEST(test_weight_store, make_key) {
+  std::vector<float> values(37);
+  std::iota(values.begin(), values.end(), 0.f);
+  const char *data = reinterpret_cast<const char *>(values.data());
+  const size_t bytes = values.size() * sizeof(float);
+
+  const std::string key = WeightStore::MakeKey(data, bytes, {1, 37, 1});
+  ASSERT_EQ(key, WeightStore::MakeKey(data, bytes, {1, 37, 1}));
+  // 维度、内容或长度不同时键不同
+  ASSERT_NE(key, WeightStore::MakeKey(data, bytes, {1, 1, 37}));
+  ASSERT_NE(key, WeightStore::MakeKey(data, bytes - 4, {1, 36, 1}));
+  values.back() += 1.f;
+  ASSERT_NE(key, WeightStore::MakeKey(data, bytes, {1, 37, 1}));
+
+  // 不要求对齐
+  std::vector<char> unaligned(bytes + 1);
+  std::memcpy(unaligned.data() + 1, data, bytes);
+  ASSERT_EQ(WeightStore::MakeKey(data, bytes, {1, 37, 1}),
+            WeightStore::MakeKey(unaligned.data() + 1, bytes, {1, 37, 1}));
+}
+
+TEST(test_weight_store, get_or_create) {
+  WeightStore &store = WeightStore::Instance();
+  const size_t blob_count = store.blob_count();
+  uint32_t create_count = 0;
+  const auto create = [&create_count]() {
+    create_count += 1;
+    return WeightStore::Blob(16, 1.f);
+  };
+
+  const std::string key = "test_weight_store.get_or_create";
+  auto blob1 = store.GetOrCreate(key, create);
+  auto blob2 = store.GetOrCreate(key, create);
+  ASSERT_EQ(blob1, blob2);
+  ASSERT_EQ(create_count, 1);
+  ASSERT_EQ(store.blob_count(), blob_count + 1);
+
+  // 不再被使用的权重被释放，之后重新生成
+  blob1.reset();
+  blob2.reset();
+  ASSERT_EQ(store.blob_count(), blob_count);
+  auto blob3 = store.GetOrCreate(key, create);
+  ASSERT_EQ(create_count, 2);
+  ASSERT_EQ(blob3->size(), 16);
+}
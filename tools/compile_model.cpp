@@ -0,0 +1,74 @@
+#include "runtime/compiled_model.hpp"
+#include "runtime/runtime_graph.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace TinyInfer;
+
+// 按逗号拆分名称列表
+std::vector<std::string> SplitNames(const std::string &names) {
+  std::vector<std::string> results;
+  std::stringstream ss(names);
+  std::string name;
+  while (std::getline(ss, name, ',')) {
+    if (!name.empty()) {
+      results.push_back(name);
+    }
+  }
+  return results;
+}
+
+void PrintUsage() {
+  printf("usage: ./compile_model [param path] [bin path] [output path]\n"
+         "           [--inputs name0,name1,...] [--outputs name0,name1,...]\n"
+         "           [--no-fuse] [--max-concurrent-ops num]\n");
+}
+
+// 由pnnx的结构文件和权重文件生成编译好的模型文件
+int main(int argc, char *argv[]) {
+  if (argc < 4) {
+    PrintUsage();
+    return -1;
+  }
+
+  const std::string param_path = argv[1];
+  const std::string bin_path = argv[2];
+  const std::string output_path = argv[3];
+  std::vector<std::string> input_names{"pnnx_input_0"};
+  std::vector<std::string> output_names{"pnnx_output_0"};
+  bool fuse_ops = true;
+  uint32_t max_concurrent_ops = 1;
+
+  for (int i = 4; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--inputs" && has_value) {
+      input_names = SplitNames(argv[++i]);
+    } else if (arg == "--outputs" && has_value) {
+      output_names = SplitNames(argv[++i]);
+    } else if (arg == "--no-fuse") {
+      fuse_ops = false;
+    } else if (arg == "--max-concurrent-ops" && has_value) {
+      max_concurrent_ops = std::max(std::atoi(argv[++i]), 1);
+    } else {
+      PrintUsage();
+      return -1;
+    }
+  }
+
+  RuntimeGraph graph(param_path, bin_path);
+  graph.set_fuse_ops(fuse_ops);
+  graph.set_max_concurrent_ops(max_concurrent_ops);
+  graph.Build(input_names, output_names);
+
+  if (!CompiledModel::Save(graph, output_path)) {
+    printf("Compile the model failed\n");
+    return -1;
+  }
+  printf("Compiled model saved to %s\n", output_path.c_str());
+  return 0;
+}